@@ -16,7 +16,6 @@ import io.flutter.plugin.common.EventChannel;
 import java.io.ByteArrayOutputStream;
 import java.io.File;
 import java.io.FileOutputStream;
-import java.util.ArrayList;
 import java.util.HashMap;
 import java.util.List;
 import java.util.Map;
@@ -127,17 +126,10 @@ public class ClipboardChannelHandler implements MethodChannel.MethodCallHandler,
         try {
             String text = formats.get("text/plain") != null ? formats.get("text/plain").toString() : "";
             String html = formats.get("text/html") != null ? formats.get("text/html").toString() : null;
-            List<Integer> imageBytes = null;
-            if (formats.get("image/png") instanceof List) {
-                imageBytes = (List<Integer>) formats.get("image/png");
-            }
+            byte[] byteArray = toByteArray(formats.get("image/png"));
 
             // Handle image using MediaStore
-            if (imageBytes != null && !imageBytes.isEmpty()) {
-                byte[] byteArray = new byte[imageBytes.size()];
-                for (int i = 0; i < imageBytes.size(); i++) {
-                    byteArray[i] = imageBytes.get(i).byteValue();
-                }
+            if (byteArray != null && byteArray.length > 0) {
                 Bitmap bitmap = BitmapFactory.decodeByteArray(byteArray, 0, byteArray.length);
                 if (bitmap != null) {
                     Uri imageUri = insertImageToMediaStore(bitmap);
@@ -167,16 +159,12 @@ public class ClipboardChannelHandler implements MethodChannel.MethodCallHandler,
     }
 
     private void handleCopyImage(MethodCall call, MethodChannel.Result result) {
-        List<Integer> imageBytes = call.argument("imageBytes");
-        if (imageBytes == null || imageBytes.isEmpty()) {
+        byte[] byteArray = toByteArray(call.argument("imageBytes"));
+        if (byteArray == null || byteArray.length == 0) {
             result.error("EMPTY_IMAGE", "Image bytes cannot be empty", null);
             return;
         }
         try {
-            byte[] byteArray = new byte[imageBytes.size()];
-            for (int i = 0; i < imageBytes.size(); i++) {
-                byteArray[i] = imageBytes.get(i).byteValue();
-            }
             Bitmap bitmap = BitmapFactory.decodeByteArray(byteArray, 0, byteArray.length);
             if (bitmap == null) {
                 result.error("INVALID_IMAGE", "Failed to decode image", null);
@@ -197,6 +185,25 @@ public class ClipboardChannelHandler implements MethodChannel.MethodCallHandler,
             result.error("COPY_IMAGE_ERROR", "Failed to copy image: " + e.getMessage(), null);
         }
     }
+
+    /**
+     * Image bytes arrive as a Uint8List (byte[]); older Dart callers sent a List<Integer>.
+     */
+    @SuppressWarnings("unchecked")
+    private static byte[] toByteArray(Object value) {
+        if (value instanceof byte[]) {
+            return (byte[]) value;
+        }
+        if (value instanceof List) {
+            List<Integer> list = (List<Integer>) value;
+            byte[] byteArray = new byte[list.size()];
+            for (int i = 0; i < list.size(); i++) {
+                byteArray[i] = list.get(i).byteValue();
+            }
+            return byteArray;
+        }
+        return null;
+    }
     
     private Uri insertImageToMediaStore(Bitmap bitmap) {
         try {
@@ -263,7 +270,7 @@ public class ClipboardChannelHandler implements MethodChannel.MethodCallHandler,
             if (item != null && Build.VERSION.SDK_INT >= Build.VERSION_CODES.JELLY_BEAN) {
                 html = item.getHtmlText();
             }
-            List<Integer> imageBytes = getImageFromClipboard(item);
+            byte[] imageBytes = getImageFromClipboard(item);
 
             Map<String, Object> resultMap = new HashMap<>();
             resultMap.put("text", text);
@@ -282,7 +289,7 @@ public class ClipboardChannelHandler implements MethodChannel.MethodCallHandler,
             ClipData.Item item = clipData != null && clipData.getItemCount() > 0
                 ? clipData.getItemAt(0)
                 : null;
-            List<Integer> imageBytes = getImageFromClipboard(item);
+            byte[] imageBytes = getImageFromClipboard(item);
             Map<String, Object> resultMap = new HashMap<>();
             resultMap.put("imageBytes", imageBytes);
             result.success(resultMap);
@@ -320,7 +327,7 @@ public class ClipboardChannelHandler implements MethodChannel.MethodCallHandler,
         result.success(0);
     }
 
-    private List<Integer> getImageFromClipboard(ClipData.Item item) {
+    private byte[] getImageFromClipboard(ClipData.Item item) {
         if (item == null || item.getUri() == null) {
             return null;
         }
@@ -346,12 +353,7 @@ public class ClipboardChannelHandler implements MethodChannel.MethodCallHandler,
             bitmap.compress(Bitmap.CompressFormat.PNG, 100, outputStream);
             byte[] byteArray = outputStream.toByteArray();
             outputStream.close();
-            
-            List<Integer> result = new ArrayList<>();
-            for (byte b : byteArray) {
-                result.add((int) b & 0xFF);
-            }
-            return result;
+            return byteArray;
         } catch (Exception e) {
             return null;
         }
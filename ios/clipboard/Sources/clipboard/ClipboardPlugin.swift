@@ -79,8 +79,7 @@ public class ClipboardPlugin: NSObject, FlutterPlugin, FlutterStreamHandler {
             }
             
             // Handle image first (highest priority)
-            if let imageBytes = formats["image/png"] as? [Int], !imageBytes.isEmpty {
-                let data = Data(imageBytes.map { UInt8($0 & 0xFF) })
+            if let data = imageData(from: formats["image/png"]), !data.isEmpty {
                 if let image = UIImage(data: data) {
                     UIPasteboard.general.image = image
                     if let text = formats["text/plain"] as? String, !text.isEmpty {
@@ -109,15 +108,14 @@ public class ClipboardPlugin: NSObject, FlutterPlugin, FlutterStreamHandler {
             
         case "copyImage":
             guard let args = call.arguments as? [String: Any],
-                  let imageBytes = args["imageBytes"] as? [Int] else {
+                  let data = imageData(from: args["imageBytes"]) else {
                 result(FlutterError(code: "INVALID_ARGUMENT", message: "Image bytes are required", details: nil))
                 return
             }
-            if imageBytes.isEmpty {
+            if data.isEmpty {
                 result(FlutterError(code: "EMPTY_IMAGE", message: "Image bytes cannot be empty", details: nil))
                 return
             }
-            let data = Data(imageBytes.map { UInt8($0 & 0xFF) })
             guard let image = UIImage(data: data) else {
                 result(FlutterError(code: "INVALID_IMAGE", message: "Failed to decode image", details: nil))
                 return
@@ -263,14 +261,25 @@ public class ClipboardPlugin: NSObject, FlutterPlugin, FlutterStreamHandler {
         return nil
     }
     
-    private func getImageBytesFromClipboard() -> [Int]? {
+    /// Image bytes arrive as a Uint8List; older Dart callers sent a List<int>.
+    private func imageData(from value: Any?) -> Data? {
+        if let typed = value as? FlutterStandardTypedData {
+            return typed.data
+        }
+        if let list = value as? [Int] {
+            return Data(list.map { UInt8($0 & 0xFF) })
+        }
+        return nil
+    }
+    
+    private func getImageBytesFromClipboard() -> FlutterStandardTypedData? {
         guard let image = UIPasteboard.general.image else {
             return nil
         }
         guard let imageData = image.pngData() else {
             return nil
         }
-        return Array(imageData.map { Int($0) })
+        return FlutterStandardTypedData(bytes: imageData)
     }
     
     deinit {
@@ -20,31 +20,52 @@ class ClipboardException implements Exception {
       'ClipboardException: $message${code != null ? ' (Code: $code)' : ''}';
 }
 
+/// Reads binary data sent over the platform channel.
+///
+/// Native code sends `Uint8List`, which is used without copying; a
+/// `List<int>` from older platform implementations is still accepted.
+Uint8List? _bytesFromChannel(Object? value) {
+  if (value is Uint8List) {
+    return value;
+  }
+  if (value is List) {
+    return Uint8List.fromList(value.cast<int>());
+  }
+  return null;
+}
+
 /// Enhanced data class for clipboard content
 class EnhancedClipboardData {
   final String? text;
   final String? html;
+
+  /// URL of the document [html] was copied from, when the source
+  /// application recorded one (Windows "HTML Format" `SourceURL`).
+  final String? sourceUrl;
   final Uint8List? imageBytes;
   final List<String>? filePaths;
   final Map<String, dynamic>? customData;
   final DateTime? timestamp;
 
+  /// 64-bit hash of the clipboard payloads this data was read from, when the
+  /// platform provides one (Windows change events). Equal hashes mean the
+  /// same content. See [FlutterClipboard.getContentHash].
+  final int? contentHash;
+
   EnhancedClipboardData({
     this.text,
     this.html,
+    this.sourceUrl,
     this.imageBytes,
     this.filePaths,
     this.customData,
     DateTime? timestamp,
+    this.contentHash,
   }) : timestamp = timestamp ?? DateTime.now();
 
   /// Factory constructor from platform channel map
   factory EnhancedClipboardData.fromMap(Map<dynamic, dynamic> map) {
-    Uint8List? imageBytes;
-    if (map['imageBytes'] != null) {
-      final List<dynamic> bytes = map['imageBytes'] as List<dynamic>;
-      imageBytes = Uint8List.fromList(bytes.cast<int>());
-    }
+    final imageBytes = _bytesFromChannel(map['imageBytes']);
 
     List<String>? filePaths;
     if (map['filePaths'] != null) {
@@ -54,12 +75,16 @@ class EnhancedClipboardData {
     return EnhancedClipboardData(
       text: map['text'] as String?,
       html: map['html'] as String?,
+      sourceUrl: map['sourceUrl'] as String?,
       imageBytes: imageBytes,
       filePaths: filePaths,
-      customData: map['customData'] as Map<String, dynamic>?,
+      customData: map['customData'] != null
+          ? Map<String, dynamic>.from(map['customData'] as Map)
+          : null,
       timestamp: map['timestamp'] != null
           ? DateTime.fromMillisecondsSinceEpoch(map['timestamp'] as int)
           : null,
+      contentHash: map['contentHash'] as int?,
     );
   }
 
@@ -68,10 +93,12 @@ class EnhancedClipboardData {
     return {
       'text': text,
       'html': html,
-      'imageBytes': imageBytes?.toList(),
+      'sourceUrl': sourceUrl,
+      'imageBytes': imageBytes,
       'filePaths': filePaths,
       'customData': customData,
       'timestamp': timestamp?.millisecondsSinceEpoch,
+      'contentHash': contentHash,
     };
   }
 
@@ -90,6 +117,283 @@ class EnhancedClipboardData {
 /// Content type enumeration
 enum ClipboardContentType { text, html, image, files, mixed, empty, unknown }
 
+/// Channel order of [ClipboardRawImage.bytes]; the names match
+/// `PixelFormat` in `dart:ui`.
+enum ClipboardPixelFormat { rgba8888, bgra8888 }
+
+/// A file or directory copied to the clipboard, from
+/// [FlutterClipboard.pasteFiles].
+class ClipboardFile {
+  final String path;
+
+  /// Size in bytes; 0 for directories, null when it could not be read.
+  final int? size;
+  final bool isDirectory;
+
+  ClipboardFile({required this.path, this.size, this.isDirectory = false});
+}
+
+/// Summary of an entry in the native clipboard history, from
+/// [FlutterClipboard.getHistory]. Fetch the full content with
+/// [FlutterClipboard.getHistoryItem].
+class ClipboardHistoryEntry {
+  final int id;
+
+  /// When this content was last copied.
+  final DateTime timestamp;
+
+  /// Bytes the entry counts against the history budget.
+  final int sizeBytes;
+
+  /// The start of the text, at most 256 UTF-8 bytes.
+  final String textPreview;
+  final bool hasHtml;
+
+  /// Size of the PNG-encoded image, 0 without one.
+  final int imageSize;
+  final int fileCount;
+
+  ClipboardHistoryEntry({
+    required this.id,
+    required this.timestamp,
+    required this.sizeBytes,
+    this.textPreview = '',
+    this.hasHtml = false,
+    this.imageSize = 0,
+    this.fileCount = 0,
+  });
+
+  bool get hasImage => imageSize > 0;
+
+  /// Factory constructor from platform channel map
+  factory ClipboardHistoryEntry.fromMap(Map<dynamic, dynamic> map) {
+    return ClipboardHistoryEntry(
+      id: map['id'] as int,
+      timestamp: DateTime.fromMillisecondsSinceEpoch(map['timestamp'] as int),
+      sizeBytes: map['sizeBytes'] as int? ?? 0,
+      textPreview: map['textPreview'] as String? ?? '',
+      hasHtml: map['hasHtml'] as bool? ?? false,
+      imageSize: map['imageSize'] as int? ?? 0,
+      fileCount: map['fileCount'] as int? ?? 0,
+    );
+  }
+}
+
+/// One page of [FlutterClipboard.getHistory], newest first.
+class ClipboardHistoryPage {
+  /// Entries in the whole history.
+  final int total;
+
+  /// Bytes the whole history uses.
+  final int bytes;
+  final List<ClipboardHistoryEntry> items;
+
+  ClipboardHistoryPage({
+    this.total = 0,
+    this.bytes = 0,
+    this.items = const [],
+  });
+
+  /// Factory constructor from platform channel map
+  factory ClipboardHistoryPage.fromMap(Map<dynamic, dynamic> map) {
+    final items = map['items'] as List? ?? const [];
+    return ClipboardHistoryPage(
+      total: map['total'] as int? ?? 0,
+      bytes: map['bytes'] as int? ?? 0,
+      items: [
+        for (final item in items)
+          ClipboardHistoryEntry.fromMap(item as Map<dynamic, dynamic>),
+      ],
+    );
+  }
+}
+
+/// Resampling filter for [FlutterClipboard.pasteImageThumbnail].
+enum ClipboardResizeFilter {
+  /// Averages the pixels each thumbnail pixel covers. Fast and smooth.
+  box,
+
+  /// Lanczos-3 windowed sinc. Sharper, but several times slower.
+  lanczos,
+}
+
+/// Uncompressed clipboard image from [FlutterClipboard.pasteImageRaw].
+///
+/// Rows are top-down and [stride] bytes apart, four bytes per pixel, ready
+/// for `decodeImageFromPixels`.
+class ClipboardRawImage {
+  final int width;
+  final int height;
+  final int stride;
+  final ClipboardPixelFormat pixelFormat;
+
+  /// Whether color channels are premultiplied by alpha.
+  final bool premultiplied;
+  final Uint8List bytes;
+
+  ClipboardRawImage({
+    required this.width,
+    required this.height,
+    required this.stride,
+    required this.pixelFormat,
+    required this.premultiplied,
+    required this.bytes,
+  });
+
+  /// Factory constructor from platform channel map
+  factory ClipboardRawImage.fromMap(Map<dynamic, dynamic> map) {
+    return ClipboardRawImage(
+      width: map['width'] as int,
+      height: map['height'] as int,
+      stride: map['stride'] as int,
+      pixelFormat: map['pixelFormat'] == 'bgra8888'
+          ? ClipboardPixelFormat.bgra8888
+          : ClipboardPixelFormat.rgba8888,
+      premultiplied: map['premultiplied'] as bool? ?? false,
+      bytes: _bytesFromChannel(map['bytes']) ?? Uint8List(0),
+    );
+  }
+}
+
+/// Clipboard formats described by [ClipboardChangeEvent] and selected by
+/// [FlutterClipboard.addChangeListener].
+enum ClipboardFormat { text, html, image, files }
+
+/// What changed on the clipboard, delivered to
+/// [FlutterClipboard.addChangeListener]. Carries no content; fetch what
+/// you need with the paste methods.
+class ClipboardChangeEvent {
+  final int sequenceNumber;
+  final DateTime timestamp;
+
+  /// Formats on the clipboard now.
+  final Set<ClipboardFormat> formats;
+
+  /// Formats whose content differs from the previous event, including ones
+  /// that appeared or disappeared.
+  final Set<ClipboardFormat> changedFormats;
+
+  /// Payload size in bytes of each format in [formats].
+  final Map<ClipboardFormat, int> sizes;
+
+  /// Same as [FlutterClipboard.getContentHash] for this clipboard state.
+  final int? contentHash;
+  final Map<ClipboardFormat, int> formatHashes;
+
+  ClipboardChangeEvent({
+    required this.sequenceNumber,
+    required this.timestamp,
+    this.formats = const {},
+    this.changedFormats = const {},
+    this.sizes = const {},
+    this.contentHash,
+    this.formatHashes = const {},
+  });
+
+  /// Factory constructor from platform channel map
+  factory ClipboardChangeEvent.fromMap(Map<dynamic, dynamic> map) {
+    return ClipboardChangeEvent(
+      sequenceNumber: map['sequenceNumber'] as int? ?? 0,
+      timestamp: map['timestamp'] != null
+          ? DateTime.fromMillisecondsSinceEpoch(map['timestamp'] as int)
+          : DateTime.now(),
+      formats: _formatSet(map['formats']),
+      changedFormats: _formatSet(map['changedFormats']),
+      sizes: _formatMap(map['sizes']),
+      contentHash: map['contentHash'] as int?,
+      formatHashes: _formatMap(map['formatHashes']),
+    );
+  }
+
+  bool hasChanged(ClipboardFormat format) => changedFormats.contains(format);
+
+  static ClipboardFormat? _format(dynamic name) {
+    for (final format in ClipboardFormat.values) {
+      if (format.name == name) {
+        return format;
+      }
+    }
+    return null;
+  }
+
+  static Set<ClipboardFormat> _formatSet(dynamic names) {
+    return {
+      for (final name in names as List? ?? const [])
+        if (_format(name) != null) _format(name)!,
+    };
+  }
+
+  static Map<ClipboardFormat, int> _formatMap(dynamic values) {
+    return {
+      for (final entry in (values as Map? ?? const {}).entries)
+        if (_format(entry.key) != null) _format(entry.key)!: entry.value as int,
+    };
+  }
+}
+
+/// One step of [FlutterClipboard.batch]: a platform method name, such as
+/// `paste`, `pasteRichText`, `hasData` or `clear`, with its arguments.
+class ClipboardOperation {
+  final String method;
+  final Map<String, dynamic>? arguments;
+
+  const ClipboardOperation(this.method, [this.arguments]);
+
+  const ClipboardOperation.paste() : this('paste');
+  const ClipboardOperation.pasteRichText() : this('pasteRichText');
+  const ClipboardOperation.pasteImage() : this('pasteImage');
+  const ClipboardOperation.pasteFiles() : this('pasteFiles');
+  const ClipboardOperation.pasteAll() : this('pasteAll');
+  const ClipboardOperation.hasData() : this('hasData');
+  const ClipboardOperation.getContentType() : this('getContentType');
+  const ClipboardOperation.clear() : this('clear');
+
+  ClipboardOperation.copy(String text) : this('copy', {'text': text});
+
+  ClipboardOperation.copyRichText({required String text, String? html})
+      : this('copyRichText', {'text': text, 'html': html});
+
+  Map<String, dynamic> toMap() {
+    return {
+      'method': method,
+      if (arguments != null) 'arguments': arguments,
+    };
+  }
+}
+
+/// Outcome of one [ClipboardOperation] in [FlutterClipboard.batch]:
+/// the raw platform result on success, the error otherwise.
+class ClipboardOperationResult {
+  final bool success;
+  final dynamic value;
+  final String? errorCode;
+  final String? errorMessage;
+
+  ClipboardOperationResult({
+    required this.success,
+    this.value,
+    this.errorCode,
+    this.errorMessage,
+  });
+
+  /// Factory constructor from platform channel map
+  factory ClipboardOperationResult.fromMap(Map<dynamic, dynamic> map) {
+    return ClipboardOperationResult(
+      success: map['success'] as bool? ?? false,
+      value: map['value'],
+      errorCode: map['code'] as String?,
+      errorMessage: map['message'] as String?,
+    );
+  }
+}
+
+class _ChangeSubscription {
+  final Set<ClipboardFormat> formats;
+  final Function(ClipboardChangeEvent) listener;
+
+  _ChangeSubscription(this.formats, this.listener);
+}
+
 /// A Flutter Clipboard Plugin with enhanced functionality.
 class FlutterClipboard {
   static final MethodChannel _channel =
@@ -98,6 +402,11 @@ class FlutterClipboard {
       EventChannel('net.cubiclab.clipboard/events');
 
   static final Set<Function(EnhancedClipboardData)> _listeners = {};
+  static final Map<int, _ChangeSubscription> _changeListeners = {};
+  static int _nextChangeListenerId = 1;
+
+  /// Subscription id under which [_listeners] are registered natively.
+  static const int _contentListenersId = 0;
   static StreamSubscription<dynamic>? _clipboardChangeSubscription;
   static EnhancedClipboardData? _lastData;
   static bool _isMonitoring = false;
@@ -207,12 +516,13 @@ class FlutterClipboard {
     }
 
     try {
-      // Convert image bytes to list if present
+      // Send image bytes as typed data so they cross the channel in one block
       Map<String, dynamic> convertedFormats =
           Map<String, dynamic>.from(formats);
-      if (formats['image/png'] is Uint8List) {
+      if (formats['image/png'] is List<int> &&
+          formats['image/png'] is! Uint8List) {
         convertedFormats['image/png'] =
-            (formats['image/png'] as Uint8List).toList();
+            Uint8List.fromList(formats['image/png'] as List<int>);
       }
 
       final result = await _channel.invokeMethod<bool>(
@@ -290,7 +600,7 @@ class FlutterClipboard {
     try {
       final result = await _channel.invokeMethod<bool>(
         'copyImage',
-        {'imageBytes': imageBytes.toList()},
+        {'imageBytes': imageBytes},
       );
       if (result != true) {
         throw ClipboardException(
@@ -447,6 +757,51 @@ class FlutterClipboard {
     }
   }
 
+  /// Paste every supported format at once: text, HTML, image and files.
+  ///
+  /// On Windows all of them are read in a single clipboard session, so they
+  /// always describe the same copy, and the image is encoded after the
+  /// clipboard is released. [EnhancedClipboardData.customData] then holds
+  /// the clipboard `sequenceNumber` and the `formatSizes` of every format
+  /// present. Other platforms combine [pasteRichText] and [pasteImage].
+  static Future<EnhancedClipboardData> pasteAll() async {
+    if (!kIsWeb) {
+      try {
+        final result =
+            await _channel.invokeMethod<Map<dynamic, dynamic>>('pasteAll');
+        if (result != null) {
+          final data = EnhancedClipboardData.fromMap(result);
+          _lastData = data;
+          return data;
+        }
+      } on PlatformException catch (e) {
+        throw ClipboardException(
+          'Failed to paste clipboard contents: ${e.message}',
+          e.code,
+        );
+      } catch (_) {
+        // Not implemented on this platform
+      }
+    }
+
+    final richText = await pasteRichText();
+    final imageBytes = await pasteImage();
+    if (imageBytes == null) {
+      return richText;
+    }
+    final data = EnhancedClipboardData(
+      text: richText.text,
+      html: richText.html,
+      sourceUrl: richText.sourceUrl,
+      imageBytes: imageBytes,
+      filePaths: richText.filePaths,
+      customData: richText.customData,
+      timestamp: richText.timestamp,
+    );
+    _lastData = data;
+    return data;
+  }
+
   /// Paste image from clipboard
   /// Returns the image bytes if available, null otherwise
   static Future<Uint8List?> pasteImage() async {
@@ -464,9 +819,99 @@ class FlutterClipboard {
     try {
       final result =
           await _channel.invokeMethod<Map<dynamic, dynamic>>('pasteImage');
-      if (result != null && result['imageBytes'] != null) {
-        final bytes = result['imageBytes'] as List<dynamic>;
-        return Uint8List.fromList(bytes.cast<int>());
+      if (result != null) {
+        return _bytesFromChannel(result['imageBytes']);
+      }
+      return null;
+    } on PlatformException {
+      return null;
+    } catch (_) {
+      return null;
+    }
+  }
+
+  /// Paste the files copied to the clipboard (e.g. from Explorer) with
+  /// their sizes. Only the path list and file system attributes are read,
+  /// never file contents.
+  /// Currently Windows only; returns an empty list elsewhere or when the
+  /// clipboard holds no files.
+  static Future<List<ClipboardFile>> pasteFiles() async {
+    if (kIsWeb) {
+      return const [];
+    }
+    try {
+      final result =
+          await _channel.invokeMethod<Map<dynamic, dynamic>>('pasteFiles');
+      if (result == null) {
+        return const [];
+      }
+      final paths = (result['paths'] as List?)?.cast<String>() ?? const [];
+      final sizes = result['sizes'] as List?;
+      final directories = result['directories'] as List?;
+      return [
+        for (var i = 0; i < paths.length; i++)
+          ClipboardFile(
+            path: paths[i],
+            size: sizes != null && (sizes[i] as int) >= 0
+                ? sizes[i] as int
+                : null,
+            isDirectory: directories != null && directories[i] != 0,
+          ),
+      ];
+    } on PlatformException {
+      return const [];
+    } catch (_) {
+      return const [];
+    }
+  }
+
+  /// Paste the clipboard image as a PNG no larger than [maxDimension]
+  /// pixels on either side, keeping its aspect ratio. Images that already
+  /// fit are returned at full size. The image is downscaled natively before
+  /// encoding, so previews of large screenshots stay small.
+  /// Currently Windows only; returns null elsewhere or when the clipboard
+  /// holds no image.
+  static Future<Uint8List?> pasteImageThumbnail(
+    int maxDimension, {
+    ClipboardResizeFilter filter = ClipboardResizeFilter.box,
+  }) async {
+    if (kIsWeb) {
+      return null;
+    }
+    try {
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>(
+        'pasteImageThumbnail',
+        {'maxDimension': maxDimension, 'filter': filter.name},
+      );
+      if (result != null) {
+        return _bytesFromChannel(result['imageBytes']);
+      }
+      return null;
+    } on PlatformException {
+      return null;
+    } catch (_) {
+      return null;
+    }
+  }
+
+  /// Paste the clipboard image as raw pixels, skipping PNG encoding and
+  /// decoding entirely. Pass the result to `decodeImageFromPixels`.
+  /// Currently Windows only; returns null elsewhere or when the clipboard
+  /// holds no image.
+  static Future<ClipboardRawImage?> pasteImageRaw({
+    ClipboardPixelFormat pixelFormat = ClipboardPixelFormat.rgba8888,
+    bool premultiplied = false,
+  }) async {
+    if (kIsWeb) {
+      return null;
+    }
+    try {
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>(
+        'pasteImageRaw',
+        {'pixelFormat': pixelFormat.name, 'premultiplied': premultiplied},
+      );
+      if (result != null) {
+        return ClipboardRawImage.fromMap(result);
       }
       return null;
     } on PlatformException {
@@ -482,9 +927,80 @@ class FlutterClipboard {
     return pasteImageWebImpl();
   }
 
+  /// Configure the native clipboard history. When [enabled], every
+  /// clipboard change (text, HTML, image and file list) is recorded by the
+  /// plugin, not the Dart isolate. Copying content that is already kept
+  /// moves it to the front instead of storing it again. Beyond [maxBytes]
+  /// or [maxEntries] the least recently used entries are dropped.
+  /// Defaults are 64 MiB and 1000 entries.
+  /// Currently Windows only; returns false elsewhere.
+  static Future<bool> setHistoryOptions({
+    bool? enabled,
+    int? maxBytes,
+    int? maxEntries,
+  }) async {
+    try {
+      final result = await _channel.invokeMethod<bool>('setHistoryOptions', {
+        'enabled': enabled,
+        'maxBytes': maxBytes,
+        'maxEntries': maxEntries,
+      });
+      return result ?? false;
+    } catch (e) {
+      return false;
+    }
+  }
+
+  /// Page through the native clipboard history, newest first. Entries
+  /// carry a text preview and sizes only; see [getHistoryItem].
+  static Future<ClipboardHistoryPage> getHistory({
+    int offset = 0,
+    int limit = 50,
+  }) async {
+    try {
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>(
+        'getHistory',
+        {'offset': offset, 'limit': limit},
+      );
+      return result != null
+          ? ClipboardHistoryPage.fromMap(result)
+          : ClipboardHistoryPage();
+    } catch (e) {
+      return ClipboardHistoryPage();
+    }
+  }
+
+  /// Full content of a history entry, or null if it has been evicted.
+  static Future<EnhancedClipboardData?> getHistoryItem(int id) async {
+    try {
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>(
+        'getHistoryItem',
+        {'id': id},
+      );
+      return result != null ? EnhancedClipboardData.fromMap(result) : null;
+    } catch (e) {
+      return null;
+    }
+  }
+
+  /// Remove every entry from the native clipboard history.
+  static Future<bool> clearHistory() async {
+    try {
+      final result = await _channel.invokeMethod<bool>('clearHistory');
+      return result ?? false;
+    } catch (e) {
+      return false;
+    }
+  }
+
   /// Get clipboard content type
-  /// Note: This method no longer accesses the clipboard automatically to avoid permission prompts.
-  /// Call paste() or pasteRichText() first to access clipboard content.
+  /// On Windows this inspects which formats are available without reading
+  /// any payload. Applications copy one item in several formats, so the
+  /// richest kind present is reported, in the order files, image, html,
+  /// text: a browser or Office copy with both HTML and plain text is
+  /// [ClipboardContentType.html]. [ClipboardContentType.mixed] means files
+  /// and an image are both present. Other platforms return [ClipboardContentType.unknown] to
+  /// avoid permission prompts; call paste() or pasteRichText() there instead.
   static Future<ClipboardContentType> getContentType() async {
     try {
       final result = await _channel.invokeMethod<String>('getContentType');
@@ -514,8 +1030,9 @@ class FlutterClipboard {
   }
 
   /// Check if clipboard has content
-  /// Note: This method no longer accesses the clipboard automatically to avoid permission prompts.
-  /// Call paste() or pasteRichText() first to access clipboard content.
+  /// On Windows this counts the available formats without reading them.
+  /// Other platforms return false to avoid permission prompts; call paste()
+  /// or pasteRichText() there instead.
   static Future<bool> hasData() async {
     try {
       final result = await _channel.invokeMethod<bool>('hasData');
@@ -559,8 +1076,9 @@ class FlutterClipboard {
   }
 
   /// Get clipboard data size (approximate)
-  /// Note: This method no longer accesses the clipboard automatically to avoid permission prompts.
-  /// Call paste() or pasteRichText() first to access clipboard content.
+  /// On Windows this sums the sizes [getFormatSizes] can measure, so formats
+  /// it reports as -1 are not counted. Other platforms return 0 to avoid
+  /// permission prompts.
   static Future<int> getDataSize() async {
     try {
       final result = await _channel.invokeMethod<int>('getDataSize');
@@ -574,6 +1092,230 @@ class FlutterClipboard {
     }
   }
 
+  /// Get the size in bytes of each clipboard format, keyed by format name
+  /// (for example `CF_UNICODETEXT`, `HTML Format`, `PNG`). Measuring never
+  /// makes an application render data, so a size is -1 when it could not
+  /// be read without that: every format while another application's window
+  /// owns the clipboard (any of them may be rendered only on request),
+  /// formats Windows would convert from another one, and bitmaps and
+  /// metafiles. Lets callers decide whether fetching
+  /// the data is worth it. Returns an empty map on platforms without format
+  /// metadata.
+  static Future<Map<String, int>> getFormatSizes() async {
+    try {
+      final result =
+          await _channel.invokeMethod<Map<dynamic, dynamic>>('getFormatSizes');
+      if (result != null) {
+        return result.map((key, value) => MapEntry(key as String, value as int));
+      }
+      return {};
+    } catch (e) {
+      return {};
+    }
+  }
+
+  /// Get a 64-bit hash of the clipboard content, which changes whenever the
+  /// text, HTML, image or file list does. The payloads are hashed natively
+  /// (xxHash64) without being copied or decoded, and the result is cached
+  /// until the clipboard changes, so checking for new content costs one
+  /// integer compare instead of a paste.
+  /// Currently Windows only; returns null elsewhere.
+  static Future<int?> getContentHash() async {
+    if (kIsWeb) {
+      return null;
+    }
+    try {
+      final result =
+          await _channel.invokeMethod<Map<dynamic, dynamic>>('getContentHash');
+      return result?['hash'] as int?;
+    } on PlatformException {
+      return null;
+    } catch (_) {
+      return null;
+    }
+  }
+
+  /// Get the hash of each format's payload, keyed by `text`, `html`,
+  /// `image` and `files`; absent formats are left out. Returns an empty map
+  /// on platforms without content hashes.
+  static Future<Map<String, int>> getFormatHashes() async {
+    if (kIsWeb) {
+      return {};
+    }
+    try {
+      final result =
+          await _channel.invokeMethod<Map<dynamic, dynamic>>('getContentHash');
+      final formats = result?['formats'] as Map<dynamic, dynamic>?;
+      if (formats != null) {
+        return formats
+            .map((key, value) => MapEntry(key as String, value as int));
+      }
+      return {};
+    } catch (e) {
+      return {};
+    }
+  }
+
+  /// Run [operations] in order in a single platform call. On Windows they
+  /// share one clipboard lock acquisition, so they all see the same
+  /// clipboard and no other application can change it in between. Elsewhere
+  /// they run one call at a time. Returns one result per operation; a
+  /// failing operation does not stop the ones after it.
+  static Future<List<ClipboardOperationResult>> batch(
+      List<ClipboardOperation> operations) async {
+    try {
+      final result = await _channel.invokeMethod<List<dynamic>>('batch', {
+        'operations': [for (final operation in operations) operation.toMap()],
+      });
+      if (result != null) {
+        return [
+          for (final entry in result)
+            ClipboardOperationResult.fromMap(entry as Map<dynamic, dynamic>),
+        ];
+      }
+    } on PlatformException catch (e) {
+      throw ClipboardException(
+          'Failed to run clipboard batch: ${e.message}', 'BATCH_ERROR');
+    } catch (_) {
+      // No native batch support; run the operations one by one below
+    }
+    final results = <ClipboardOperationResult>[];
+    for (final operation in operations) {
+      try {
+        final value =
+            await _channel.invokeMethod(operation.method, operation.arguments);
+        results.add(ClipboardOperationResult(success: true, value: value));
+      } on PlatformException catch (e) {
+        results.add(ClipboardOperationResult(
+          success: false,
+          errorCode: e.code,
+          errorMessage: e.message,
+        ));
+      } catch (e) {
+        results.add(ClipboardOperationResult(
+          success: false,
+          errorCode: 'NOT_IMPLEMENTED',
+          errorMessage: e.toString(),
+        ));
+      }
+    }
+    return results;
+  }
+
+  /// Get statistics of the native paste result cache
+  /// Returns `hits`, `misses`, `entries` and `bytes`, or an empty map on
+  /// platforms without a paste cache.
+  static Future<Map<String, int>> getPasteCacheStats() async {
+    try {
+      final result = await _channel
+          .invokeMethod<Map<dynamic, dynamic>>('getPasteCacheStats');
+      if (result != null) {
+        return result.map((key, value) => MapEntry(key as String, value as int));
+      }
+      return {};
+    } catch (e) {
+      return {};
+    }
+  }
+
+  /// Get statistics of native clipboard lock acquisition
+  /// Returns `acquisitions`, `failures`, `contended` (opens that had to
+  /// retry), `attempts`, and the total and maximum time spent waiting for
+  /// and holding the lock (`waitMicros`, `maxWaitMicros`, `holdMicros`,
+  /// `maxHoldMicros`). Returns an empty map on platforms without them.
+  static Future<Map<String, int>> getClipboardLockStats() async {
+    try {
+      final result = await _channel
+          .invokeMethod<Map<dynamic, dynamic>>('getClipboardLockStats');
+      if (result != null) {
+        return result.map((key, value) => MapEntry(key as String, value as int));
+      }
+      return {};
+    } catch (e) {
+      return {};
+    }
+  }
+
+  /// Configure how long native code retries when another application holds
+  /// the clipboard. Retries wait [initialBackoff] first and double the wait
+  /// up to [maxBackoff], giving up after [timeout]; a zero [timeout] makes a
+  /// single attempt. Omitted values are left unchanged.
+  /// Returns false on platforms without configurable clipboard locking.
+  static Future<bool> setClipboardLockOptions({
+    Duration? timeout,
+    Duration? initialBackoff,
+    Duration? maxBackoff,
+  }) async {
+    try {
+      final result =
+          await _channel.invokeMethod<bool>('setClipboardLockOptions', {
+        if (timeout != null) 'timeoutMs': timeout.inMilliseconds,
+        if (initialBackoff != null)
+          'initialBackoffMs': initialBackoff.inMilliseconds,
+        if (maxBackoff != null) 'maxBackoffMs': maxBackoff.inMilliseconds,
+      });
+      return result ?? false;
+    } catch (e) {
+      return false;
+    }
+  }
+
+  /// Configure how clipboard change events are throttled. Changes within
+  /// [debounce] of the last event (50 ms by default) are merged into one
+  /// event, so bursts reach listeners at most once per window; zero sends
+  /// every change. While listeners are still busy with an event, newer ones
+  /// wait in a queue of [maxQueuedEvents] (default 1) that drops the oldest
+  /// when full. Omitted values are left unchanged.
+  /// Returns false on platforms without native change throttling.
+  static Future<bool> setMonitoringOptions({
+    Duration? debounce,
+    int? maxQueuedEvents,
+  }) async {
+    try {
+      final result =
+          await _channel.invokeMethod<bool>('setMonitoringOptions', {
+        if (debounce != null) 'debounceMs': debounce.inMilliseconds,
+        if (maxQueuedEvents != null) 'maxQueuedEvents': maxQueuedEvents,
+      });
+      return result ?? false;
+    } catch (e) {
+      return false;
+    }
+  }
+
+  /// Get clipboard change event counters: changes `received`, changes
+  /// `coalesced` into another event, events `delivered` to Dart, events
+  /// `dropped` from a full queue and events still `queued`. Returns an
+  /// empty map on platforms without native change throttling.
+  static Future<Map<String, int>> getMonitoringStats() async {
+    try {
+      final result = await _channel
+          .invokeMethod<Map<dynamic, dynamic>>('getMonitoringStats');
+      if (result != null) {
+        return result.map((key, value) => MapEntry(key as String, value as int));
+      }
+      return {};
+    } catch (e) {
+      return {};
+    }
+  }
+
+  /// Configure native image encoding. [threads] caps the cores used to
+  /// encode large pasted images as PNG: 1 encodes on a single thread, 0 (the
+  /// default) uses one per core. Omitted values are left unchanged.
+  /// Returns false on platforms without configurable image encoding.
+  static Future<bool> setImageEncodingOptions({int? threads}) async {
+    try {
+      final result =
+          await _channel.invokeMethod<bool>('setImageEncodingOptions', {
+        if (threads != null) 'threads': threads,
+      });
+      return result ?? false;
+    } catch (e) {
+      return false;
+    }
+  }
+
   /// Validate input before copying
   static bool isValidInput(String text) {
     return text.isNotEmpty && text.trim().isNotEmpty;
@@ -583,6 +1325,7 @@ class FlutterClipboard {
   /// Returns a function to remove the listener
   static Function() addListener(Function(EnhancedClipboardData) listener) {
     _listeners.add(listener);
+    _syncEventSubscriptions();
     // Return a cleanup function
     return () => removeListener(listener);
   }
@@ -590,11 +1333,37 @@ class FlutterClipboard {
   /// Remove clipboard change listener
   static void removeListener(Function(EnhancedClipboardData) listener) {
     _listeners.remove(listener);
+    _syncEventSubscriptions();
+  }
+
+  /// Add a listener for [ClipboardChangeEvent]s, which describe a change
+  /// without its content. It is only called when one of [formats] (all by
+  /// default) changed; on Windows this is decided natively, so other
+  /// changes never reach Dart. Fetch content with the paste methods when
+  /// needed. Events require [startMonitoring] on a platform with native
+  /// change events (currently Windows).
+  /// Returns a function to remove the listener.
+  static Function() addChangeListener(
+    Function(ClipboardChangeEvent) listener, {
+    Set<ClipboardFormat>? formats,
+  }) {
+    final id = _nextChangeListenerId++;
+    _changeListeners[id] = _ChangeSubscription(
+      formats ?? ClipboardFormat.values.toSet(),
+      listener,
+    );
+    _syncEventSubscriptions();
+    return () {
+      _changeListeners.remove(id);
+      _syncEventSubscriptions();
+    };
   }
 
   /// Remove all listeners
   static void removeAllListeners() {
     _listeners.clear();
+    _changeListeners.clear();
+    _syncEventSubscriptions();
   }
 
   /// Start monitoring clipboard changes using native notifications
@@ -606,22 +1375,22 @@ class FlutterClipboard {
     }
 
     try {
-      // Try to use native clipboard change notifications
-      _clipboardChangeSubscription =
-          _eventChannel.receiveBroadcastStream().listen(
-        (dynamic event) {
+      // Try to use native clipboard change notifications. Events marked
+      // `acknowledge` are held back natively until the previous one is
+      // acknowledged, so a busy isolate gets the latest change, not a backlog.
+      _clipboardChangeSubscription = _eventChannel
+          .receiveBroadcastStream(const {'acknowledge': true}).listen(
+        (dynamic event) async {
           try {
             if (event is Map) {
-              final data = EnhancedClipboardData.fromMap(event);
-              if (_lastData?.text != data.text ||
-                  _lastData?.html != data.html ||
-                  _lastData?.imageBytes != data.imageBytes) {
-                _lastData = data;
-                _notifyListeners(data);
-              }
+              await _handleChangeEvent(event);
             }
           } catch (e) {
             // Ignore parsing errors
+          } finally {
+            if (event is Map && event['acknowledge'] == true) {
+              _channel.invokeMethod<bool>('ackEvent').catchError((_) => false);
+            }
           }
         },
         onError: (error) {
@@ -631,6 +1400,7 @@ class FlutterClipboard {
       );
 
       // Start native monitoring on platform
+      _syncEventSubscriptions();
       await _channel.invokeMethod<bool>('startMonitoring');
       _isMonitoring = true;
     } catch (e) {
@@ -645,10 +1415,13 @@ class FlutterClipboard {
     _monitoringTimer?.cancel();
     _monitoringTimer = Timer.periodic(interval, (timer) async {
       try {
-        final currentData = await pasteRichText();
-        if (_lastData?.text != currentData.text ||
-            _lastData?.html != currentData.html ||
-            _lastData?.imageBytes != currentData.imageBytes) {
+        // Only paste when the content hash moved (or is unavailable)
+        final hash = await getContentHash();
+        if (hash != null && hash == _lastData?.contentHash) {
+          return;
+        }
+        final currentData = _withContentHash(await pasteRichText(), hash);
+        if (_isNewContent(currentData)) {
           _lastData = currentData;
           _notifyListeners(currentData);
         }
@@ -728,6 +1501,108 @@ class FlutterClipboard {
   }
 
   // Private helper methods
+
+  /// Tells native code which formats each listener cares about, so changes
+  /// nobody wants are filtered before they cross the channel.
+  /// [addListener] listeners share one subscription covering all formats.
+  static void _syncEventSubscriptions() {
+    if (kIsWeb) {
+      return;
+    }
+    final subscriptions = <int, int>{
+      if (_listeners.isNotEmpty)
+        _contentListenersId: _formatMask(ClipboardFormat.values),
+      for (final entry in _changeListeners.entries)
+        entry.key: _formatMask(entry.value.formats),
+    };
+    _channel.invokeMethod<bool>('setEventSubscriptions', {
+      'subscriptions': subscriptions,
+    }).catchError((_) => false);
+  }
+
+  static int _formatMask(Iterable<ClipboardFormat> formats) {
+    return formats.fold(0, (mask, format) => mask | (1 << format.index));
+  }
+
+  /// Dispatches a native change event. Metadata events go to the change
+  /// listeners they name (or that match their changed formats when they
+  /// name none); [addListener] listeners get the content, pasted once on
+  /// their behalf. Platforms that send the content itself only reach
+  /// [addListener] listeners.
+  static Future<void> _handleChangeEvent(Map<dynamic, dynamic> event) async {
+    if (!event.containsKey('formats')) {
+      final data = EnhancedClipboardData.fromMap(event);
+      if (_isNewContent(data)) {
+        _lastData = data;
+        _notifyListeners(data);
+      }
+      return;
+    }
+    final change = ClipboardChangeEvent.fromMap(event);
+    final subscribers = (event['subscribers'] as List?)?.cast<int>().toSet();
+    for (final entry in List.of(_changeListeners.entries)) {
+      final wanted = subscribers != null
+          ? subscribers.contains(entry.key)
+          : entry.value.formats.any(change.changedFormats.contains);
+      if (!wanted) {
+        continue;
+      }
+      try {
+        entry.value.listener(change);
+      } catch (e) {
+        // Ignore listener errors but log in debug mode
+        if (kDebugMode) {
+          print('Clipboard change listener error: $e');
+        }
+      }
+    }
+    if (_listeners.isEmpty ||
+        (subscribers != null && !subscribers.contains(_contentListenersId)) ||
+        (change.contentHash != null &&
+            change.contentHash == _lastData?.contentHash)) {
+      return;
+    }
+    final data = _withContentHash(await pasteRichText(), change.contentHash);
+    if (_isNewContent(data)) {
+      _lastData = data;
+      _notifyListeners(data);
+    }
+  }
+
+  static EnhancedClipboardData _withContentHash(
+      EnhancedClipboardData data, int? contentHash) {
+    if (contentHash == null) {
+      return data;
+    }
+    return EnhancedClipboardData(
+      text: data.text,
+      html: data.html,
+      sourceUrl: data.sourceUrl,
+      imageBytes: data.imageBytes,
+      filePaths: data.filePaths,
+      customData: data.customData,
+      timestamp: data.timestamp,
+      contentHash: contentHash,
+    );
+  }
+
+  /// Whether [data] differs from what listeners were last given. Content
+  /// hashes are compared when both sides have one; data set locally (for
+  /// example by [copy]) has none, so its fields are compared instead.
+  static bool _isNewContent(EnhancedClipboardData data) {
+    final last = _lastData;
+    if (last == null) {
+      return true;
+    }
+    if (data.contentHash != null && last.contentHash != null) {
+      return data.contentHash != last.contentHash;
+    }
+    return last.text != data.text ||
+        last.html != data.html ||
+        !listEquals(last.imageBytes, data.imageBytes) ||
+        !listEquals(last.filePaths, data.filePaths);
+  }
+
   static void _notifyListeners(EnhancedClipboardData data) {
     final listeners = List<Function(EnhancedClipboardData)>.from(_listeners);
     for (final listener in listeners) {
@@ -78,8 +78,7 @@ public class ClipboardPlugin: NSObject, FlutterPlugin, FlutterStreamHandler {
             pasteboard.clearContents()
             
             // Handle image first (highest priority)
-            if let imageBytes = formats["image/png"] as? [Int], !imageBytes.isEmpty {
-                let data = Data(imageBytes.map { UInt8($0 & 0xFF) })
+            if let data = imageData(from: formats["image/png"]), !data.isEmpty {
                 if let image = NSImage(data: data) {
                     pasteboard.writeObjects([image])
                     if let text = formats["text/plain"] as? String, !text.isEmpty {
@@ -101,15 +100,14 @@ public class ClipboardPlugin: NSObject, FlutterPlugin, FlutterStreamHandler {
             
         case "copyImage":
             guard let args = call.arguments as? [String: Any],
-                  let imageBytes = args["imageBytes"] as? [Int] else {
+                  let data = imageData(from: args["imageBytes"]) else {
                 result(FlutterError(code: "INVALID_ARGUMENT", message: "Image bytes are required", details: nil))
                 return
             }
-            if imageBytes.isEmpty {
+            if data.isEmpty {
                 result(FlutterError(code: "EMPTY_IMAGE", message: "Image bytes cannot be empty", details: nil))
                 return
             }
-            let data = Data(imageBytes.map { UInt8($0 & 0xFF) })
             guard let image = NSImage(data: data) else {
                 result(FlutterError(code: "INVALID_IMAGE", message: "Failed to decode image", details: nil))
                 return
@@ -225,7 +223,18 @@ public class ClipboardPlugin: NSObject, FlutterPlugin, FlutterStreamHandler {
         return nil
     }
     
-    private func getImageBytesFromClipboard() -> [Int]? {
+    /// Image bytes arrive as a Uint8List; older Dart callers sent a List<int>.
+    private func imageData(from value: Any?) -> Data? {
+        if let typed = value as? FlutterStandardTypedData {
+            return typed.data
+        }
+        if let list = value as? [Int] {
+            return Data(list.map { UInt8($0 & 0xFF) })
+        }
+        return nil
+    }
+    
+    private func getImageBytesFromClipboard() -> FlutterStandardTypedData? {
         let pasteboard = NSPasteboard.general
         
         // Check if clipboard has image data
@@ -244,7 +253,7 @@ public class ClipboardPlugin: NSObject, FlutterPlugin, FlutterStreamHandler {
             return nil
         }
         
-        return Array(pngData.map { Int($0) })
+        return FlutterStandardTypedData(bytes: pngData)
     }
     
     deinit {
@@ -1,3 +1,5 @@
+import 'dart:typed_data';
+
 import 'package:flutter_test/flutter_test.dart';
 import 'package:clipboard/clipboard.dart';
 
@@ -130,6 +132,81 @@ void main() {
         expect(result, isA<int>());
       });
 
+      test('getFormatSizes should return map', () async {
+        final result = await FlutterClipboard.getFormatSizes();
+        expect(result, isA<Map<String, int>>());
+      });
+
+      test('getPasteCacheStats should return map', () async {
+        final result = await FlutterClipboard.getPasteCacheStats();
+        expect(result, isA<Map<String, int>>());
+      });
+
+      test('getClipboardLockStats should return map', () async {
+        final result = await FlutterClipboard.getClipboardLockStats();
+        expect(result, isA<Map<String, int>>());
+      });
+
+      test('setClipboardLockOptions should return bool', () async {
+        final result = await FlutterClipboard.setClipboardLockOptions(
+          timeout: const Duration(milliseconds: 200),
+        );
+        expect(result, isA<bool>());
+      });
+
+      test('setImageEncodingOptions should return bool', () async {
+        final result =
+            await FlutterClipboard.setImageEncodingOptions(threads: 2);
+        expect(result, isA<bool>());
+      });
+
+      test('setMonitoringOptions should return bool', () async {
+        final result = await FlutterClipboard.setMonitoringOptions(
+          debounce: const Duration(milliseconds: 100),
+          maxQueuedEvents: 4,
+        );
+        expect(result, isA<bool>());
+      });
+
+      test('getMonitoringStats should return map', () async {
+        final result = await FlutterClipboard.getMonitoringStats();
+        expect(result, isA<Map<String, int>>());
+      });
+
+      test('pasteFiles should return list', () async {
+        final result = await FlutterClipboard.pasteFiles();
+        expect(result, isA<List<ClipboardFile>>());
+      });
+
+      test('pasteImageThumbnail should return bytes or null', () async {
+        final result = await FlutterClipboard.pasteImageThumbnail(64);
+        expect(result, anyOf(isNull, isA<Uint8List>()));
+      });
+
+      test('getHistory should return ClipboardHistoryPage', () async {
+        final result = await FlutterClipboard.getHistory(limit: 10);
+        expect(result, isA<ClipboardHistoryPage>());
+      });
+
+      test('batch should return one result per operation', () async {
+        final results = await FlutterClipboard.batch(const [
+          ClipboardOperation.hasData(),
+          ClipboardOperation.pasteRichText(),
+        ]);
+        expect(results, hasLength(2));
+        expect(results.first, isA<ClipboardOperationResult>());
+      });
+
+      test('pasteAll should return EnhancedClipboardData', () async {
+        final result = await FlutterClipboard.pasteAll();
+        expect(result, isA<EnhancedClipboardData>());
+      });
+
+      test('getContentHash should return int or null', () async {
+        final result = await FlutterClipboard.getContentHash();
+        expect(result, anyOf(isNull, isA<int>()));
+      });
+
       test('getContentType should return ClipboardContentType', () async {
         final result = await FlutterClipboard.getContentType();
         expect(result, isA<ClipboardContentType>());
@@ -159,6 +236,16 @@ void main() {
         expect(() => FlutterClipboard.removeAllListeners(), returnsNormally);
       });
 
+      test('addChangeListener should return cleanup function', () {
+        void testListener(ClipboardChangeEvent event) {}
+        final removeListener = FlutterClipboard.addChangeListener(
+          testListener,
+          formats: {ClipboardFormat.text},
+        );
+        expect(removeListener, isA<Function>());
+        expect(() => removeListener(), returnsNormally);
+      });
+
       test('startMonitoring should start monitoring', () async {
         expect(() => FlutterClipboard.startMonitoring(), returnsNormally);
         await FlutterClipboard.stopMonitoring();
@@ -211,6 +298,129 @@ void main() {
         expect(emptyData.hasText, isFalse);
         expect(textData.hasText, isTrue);
       });
+
+      test('EnhancedClipboardData.fromMap should keep typed image bytes', () {
+        final bytes = Uint8List.fromList([137, 80, 78, 71]);
+        final data = EnhancedClipboardData.fromMap({'imageBytes': bytes});
+        expect(identical(data.imageBytes, bytes), isTrue);
+      });
+
+      test('EnhancedClipboardData.fromMap should accept legacy int lists', () {
+        final data = EnhancedClipboardData.fromMap({
+          'imageBytes': <dynamic>[137, 80, 78, 71],
+        });
+        expect(data.imageBytes, equals([137, 80, 78, 71]));
+      });
+
+      test('EnhancedClipboardData.fromMap should read sourceUrl', () {
+        final data = EnhancedClipboardData.fromMap({
+          'html': '<b>Hello</b>',
+          'sourceUrl': 'https://example.com/page',
+        });
+        expect(data.sourceUrl, equals('https://example.com/page'));
+        expect(data.toMap()['sourceUrl'], equals('https://example.com/page'));
+      });
+
+      test('EnhancedClipboardData.fromMap should accept channel customData',
+          () {
+        final data = EnhancedClipboardData.fromMap({
+          'text': 'Hello',
+          'customData': <Object?, Object?>{
+            'sequenceNumber': 42,
+            'formatSizes': <Object?, Object?>{'CF_UNICODETEXT': 12},
+          },
+        });
+        expect(data.customData?['sequenceNumber'], equals(42));
+        expect(data.customData?['formatSizes'], isA<Map>());
+      });
+
+      test('EnhancedClipboardData.fromMap should read contentHash', () {
+        final data = EnhancedClipboardData.fromMap({
+          'text': 'Hello',
+          'contentHash': -4237318386146127593,
+        });
+        expect(data.contentHash, equals(-4237318386146127593));
+        expect(data.toMap()['contentHash'], equals(-4237318386146127593));
+      });
+    });
+
+    group('ClipboardRawImage Class', () {
+      test('ClipboardRawImage.fromMap should read pixel layout', () {
+        final bytes = Uint8List(2 * 1 * 4);
+        final image = ClipboardRawImage.fromMap({
+          'width': 2,
+          'height': 1,
+          'stride': 8,
+          'pixelFormat': 'bgra8888',
+          'premultiplied': true,
+          'bytes': bytes,
+        });
+        expect(image.width, equals(2));
+        expect(image.stride, equals(8));
+        expect(image.pixelFormat, equals(ClipboardPixelFormat.bgra8888));
+        expect(image.premultiplied, isTrue);
+        expect(identical(image.bytes, bytes), isTrue);
+      });
+    });
+
+    group('ClipboardChangeEvent Class', () {
+      test('ClipboardChangeEvent.fromMap should read metadata', () {
+        final event = ClipboardChangeEvent.fromMap({
+          'sequenceNumber': 42,
+          'timestamp': 1700000000000,
+          'formats': ['text', 'image'],
+          'changedFormats': ['image'],
+          'sizes': {'text': 10, 'image': 4096},
+          'contentHash': 123,
+          'formatHashes': {'text': 1, 'image': 2},
+          'subscribers': [1],
+        });
+        expect(event.sequenceNumber, equals(42));
+        expect(event.formats,
+            equals({ClipboardFormat.text, ClipboardFormat.image}));
+        expect(event.hasChanged(ClipboardFormat.image), isTrue);
+        expect(event.hasChanged(ClipboardFormat.text), isFalse);
+        expect(event.sizes[ClipboardFormat.image], equals(4096));
+        expect(event.contentHash, equals(123));
+      });
+    });
+
+    group('ClipboardOperationResult Class', () {
+      test('ClipboardOperationResult.fromMap should read errors', () {
+        final result = ClipboardOperationResult.fromMap({
+          'success': false,
+          'code': 'PASTE_ERROR',
+          'message': 'Failed to open clipboard',
+        });
+        expect(result.success, isFalse);
+        expect(result.errorCode, equals('PASTE_ERROR'));
+        expect(result.value, isNull);
+      });
+    });
+
+    group('ClipboardHistoryPage Class', () {
+      test('ClipboardHistoryPage.fromMap should read entries', () {
+        final page = ClipboardHistoryPage.fromMap({
+          'total': 3,
+          'bytes': 1024,
+          'items': [
+            {
+              'id': 7,
+              'timestamp': 1700000000000,
+              'sizeBytes': 200,
+              'textPreview': 'Hello',
+              'hasHtml': true,
+              'imageSize': 0,
+              'fileCount': 2,
+            },
+          ],
+        });
+        expect(page.total, equals(3));
+        expect(page.items.single.id, equals(7));
+        expect(page.items.single.textPreview, equals('Hello'));
+        expect(page.items.single.hasImage, isFalse);
+        expect(page.items.single.fileCount, equals(2));
+      });
     });
 
     group('ClipboardException Class', () {
@@ -0,0 +1,76 @@
+import 'dart:typed_data';
+
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+
+// Compares the two ways image bytes can cross the platform channel: the
+// List<int> with one boxed integer per byte that copyImage and pasteImage
+// used to send, and the Uint8List they send now. The encoded message is
+// the buffer the channel copies between the isolate and the platform
+// thread; the timings cover one encode and one decode, as each direction of
+// a method call does.
+void main() {
+  const codec = StandardMethodCodec();
+  const imageSize = 4 * 1024 * 1024;
+  const iterations = 5;
+
+  final image = Uint8List(imageSize);
+  for (var i = 0; i < imageSize; i++) {
+    image[i] = (i * 31) & 0xFF;
+  }
+  final legacyImage = List<int>.of(image);
+
+  ByteData encode(Object imageBytes) => codec.encodeMethodCall(
+      MethodCall('copyImage', {'imageBytes': imageBytes}));
+
+  Object? decode(ByteData message) =>
+      (codec.decodeMethodCall(message).arguments as Map)['imageBytes'];
+
+  // Microseconds per encode + decode, best of |iterations|.
+  int roundTripMicros(Object imageBytes) {
+    var best = -1;
+    for (var i = 0; i < iterations; i++) {
+      final stopwatch = Stopwatch()..start();
+      decode(encode(imageBytes));
+      stopwatch.stop();
+      final micros = stopwatch.elapsedMicroseconds;
+      if (best < 0 || micros < best) {
+        best = micros;
+      }
+    }
+    return best;
+  }
+
+  group('Image Transfer Benchmark', () {
+    test('Uint8List message should be about the size of the image', () {
+      final typed = encode(image).lengthInBytes;
+      final legacy = encode(legacyImage).lengthInBytes;
+      debugPrint('4 MiB image message: Uint8List $typed bytes, '
+          'List<int> $legacy bytes');
+
+      expect(typed, lessThan(imageSize + 64));
+      // Every element of a List<int> is a type tag plus an int32
+      expect(legacy, greaterThanOrEqualTo(imageSize * 5));
+    });
+
+    test('Uint8List should decode to typed data with the same bytes', () {
+      final typed = decode(encode(image));
+      final legacy = decode(encode(legacyImage));
+
+      expect(typed, isA<Uint8List>());
+      expect(typed, equals(image));
+      expect(legacy, isNot(isA<Uint8List>()));
+      expect(legacy, equals(image));
+    });
+
+    test('Uint8List round trip should be faster than List<int>', () {
+      final typed = roundTripMicros(image);
+      final legacy = roundTripMicros(legacyImage);
+      debugPrint('4 MiB image encode + decode: Uint8List $typed us, '
+          'List<int> $legacy us');
+
+      expect(typed, lessThan(legacy));
+    });
+  });
+}
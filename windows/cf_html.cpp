@@ -0,0 +1,190 @@
+#include "cf_html.h"
+
+#include <cstring>
+#include <string_view>
+
+namespace clipboard {
+
+namespace {
+
+constexpr int kOffsetDigits = 10;
+
+constexpr char kVersionLine[] = "Version:0.9\r\n";
+constexpr char kStartHtmlKey[] = "StartHTML:";
+constexpr char kEndHtmlKey[] = "EndHTML:";
+constexpr char kStartFragmentKey[] = "StartFragment:";
+constexpr char kEndFragmentKey[] = "EndFragment:";
+constexpr char kLineEnd[] = "\r\n";
+
+constexpr char kDocumentPrefix[] = "<html><body>\r\n<!--StartFragment-->";
+constexpr char kDocumentSuffix[] = "<!--EndFragment-->\r\n</body></html>";
+
+constexpr char kStartFragmentMarker[] = "<!--StartFragment-->";
+constexpr char kEndFragmentMarker[] = "<!--EndFragment-->";
+
+constexpr size_t Length(const char* literal) {
+  return std::char_traits<char>::length(literal);
+}
+
+constexpr size_t OffsetLineSize(const char* key) {
+  return Length(key) + kOffsetDigits + Length(kLineEnd);
+}
+
+constexpr size_t kHeaderSize =
+    Length(kVersionLine) + OffsetLineSize(kStartHtmlKey) +
+    OffsetLineSize(kEndHtmlKey) + OffsetLineSize(kStartFragmentKey) +
+    OffsetLineSize(kEndFragmentKey);
+
+char* Append(char* out, const char* data, size_t size) {
+  memcpy(out, data, size);
+  return out + size;
+}
+
+char* AppendLiteral(char* out, const char* literal) {
+  return Append(out, literal, Length(literal));
+}
+
+// Writes "<key><value as 10 zero-padded digits>\r\n".
+char* AppendOffsetLine(char* out, const char* key, size_t value) {
+  out = AppendLiteral(out, key);
+  for (int i = kOffsetDigits - 1; i >= 0; i--) {
+    out[i] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  }
+  out += kOffsetDigits;
+  return AppendLiteral(out, kLineEnd);
+}
+
+// Parses a decimal header value. Producers write -1 for absent sections;
+// that, garbage and overflow all yield -1.
+long long ParseOffset(std::string_view value) {
+  size_t i = 0;
+  while (i < value.size() && value[i] == ' ') {
+    i++;
+  }
+  if (i == value.size() || value[i] < '0' || value[i] > '9') {
+    return -1;
+  }
+  long long result = 0;
+  for (; i < value.size() && value[i] >= '0' && value[i] <= '9'; i++) {
+    if (result > (1LL << 40)) {
+      return -1;
+    }
+    result = result * 10 + (value[i] - '0');
+  }
+  return result;
+}
+
+}  // namespace
+
+size_t CfHtmlEncodedSize(size_t fragment_size) {
+  return kHeaderSize + Length(kDocumentPrefix) + fragment_size +
+         Length(kDocumentSuffix);
+}
+
+void WriteCfHtml(const char* fragment, size_t fragment_size, char* out) {
+  const size_t start_html = kHeaderSize;
+  const size_t start_fragment = start_html + Length(kDocumentPrefix);
+  const size_t end_fragment = start_fragment + fragment_size;
+  const size_t end_html = end_fragment + Length(kDocumentSuffix);
+
+  out = AppendLiteral(out, kVersionLine);
+  out = AppendOffsetLine(out, kStartHtmlKey, start_html);
+  out = AppendOffsetLine(out, kEndHtmlKey, end_html);
+  out = AppendOffsetLine(out, kStartFragmentKey, start_fragment);
+  out = AppendOffsetLine(out, kEndFragmentKey, end_fragment);
+  out = AppendLiteral(out, kDocumentPrefix);
+  out = Append(out, fragment, fragment_size);
+  out = AppendLiteral(out, kDocumentSuffix);
+  *out = '\0';
+}
+
+std::string EncodeCfHtml(const std::string& fragment) {
+  std::string encoded(CfHtmlEncodedSize(fragment.size()), '\0');
+  // The string's own terminator provides the extra byte
+  WriteCfHtml(fragment.data(), fragment.size(), &encoded[0]);
+  return encoded;
+}
+
+bool DecodeCfHtml(const char* data, size_t size, CfHtmlFragment* result) {
+  if (const void* nul = memchr(data, '\0', size)) {
+    size = static_cast<size_t>(static_cast<const char*>(nul) - data);
+  }
+  const std::string_view payload(data, size);
+
+  long long start_html = -1;
+  long long end_html = -1;
+  long long start_fragment = -1;
+  long long end_fragment = -1;
+  bool has_header = false;
+  std::string_view source_url;
+
+  // Header lines run until the document starts (or StartHTML, if it is
+  // already known).
+  size_t pos = 0;
+  while (pos < payload.size() && payload[pos] != '<' &&
+         (start_html < 0 || pos < static_cast<size_t>(start_html))) {
+    size_t line_end = payload.find_first_of("\r\n", pos);
+    if (line_end == std::string_view::npos) {
+      line_end = payload.size();
+    }
+    const std::string_view line = payload.substr(pos, line_end - pos);
+    const size_t colon = line.find(':');
+    if (colon != std::string_view::npos) {
+      const std::string_view key = line.substr(0, colon);
+      const std::string_view value = line.substr(colon + 1);
+      if (key == "Version") {
+        has_header = true;
+      } else if (key == "StartHTML") {
+        start_html = ParseOffset(value);
+      } else if (key == "EndHTML") {
+        end_html = ParseOffset(value);
+      } else if (key == "StartFragment") {
+        start_fragment = ParseOffset(value);
+      } else if (key == "EndFragment") {
+        end_fragment = ParseOffset(value);
+      } else if (key == "SourceURL") {
+        source_url = value;
+      }
+    }
+    pos = line_end;
+    while (pos < payload.size() && (payload[pos] == '\r' || payload[pos] == '\n')) {
+      pos++;
+    }
+  }
+  const size_t header_end = pos;
+  if (!has_header && start_html < 0 && start_fragment < 0) {
+    return false;
+  }
+
+  auto in_range = [&](long long begin, long long end) {
+    return begin >= static_cast<long long>(header_end) && begin <= end &&
+           end <= static_cast<long long>(payload.size());
+  };
+
+  size_t begin = header_end;
+  size_t end = payload.size();
+  if (in_range(start_fragment, end_fragment)) {
+    begin = static_cast<size_t>(start_fragment);
+    end = static_cast<size_t>(end_fragment);
+  } else {
+    const size_t start_marker = payload.find(kStartFragmentMarker, header_end);
+    const size_t end_marker =
+        start_marker == std::string_view::npos
+            ? std::string_view::npos
+            : payload.find(kEndFragmentMarker, start_marker);
+    if (end_marker != std::string_view::npos) {
+      begin = start_marker + Length(kStartFragmentMarker);
+      end = end_marker;
+    } else if (in_range(start_html, end_html)) {
+      begin = static_cast<size_t>(start_html);
+      end = static_cast<size_t>(end_html);
+    }
+  }
+
+  result->html.assign(payload.data() + begin, end - begin);
+  result->source_url.assign(source_url.data(), source_url.size());
+  return true;
+}
+
+}  // namespace clipboard
@@ -0,0 +1,43 @@
+#ifndef CF_HTML_H_
+#define CF_HTML_H_
+
+#include <cstddef>
+#include <string>
+
+namespace clipboard {
+
+// Codec for the Windows "HTML Format" (CF_HTML) clipboard payload: an ASCII
+// header of byte offsets followed by an HTML document whose fragment is
+// delimited by <!--StartFragment--> and <!--EndFragment-->. Offsets and
+// sizes are in bytes of UTF-8; the fragment is not validated or escaped.
+
+// Exact size of the CF_HTML payload for |fragment|, without the terminating
+// NUL that clipboard consumers expect.
+size_t CfHtmlEncodedSize(size_t fragment_size);
+
+// Writes the CF_HTML payload for |fragment| to |out| in a single pass. All
+// offsets are known up front because the header has fixed-width fields.
+// |out| must hold CfHtmlEncodedSize(fragment_size) + 1 bytes; the last one is
+// the NUL terminator.
+void WriteCfHtml(const char* fragment, size_t fragment_size, char* out);
+
+// Convenience wrapper returning the payload (without NUL) as a string.
+std::string EncodeCfHtml(const std::string& fragment);
+
+struct CfHtmlFragment {
+  std::string html;
+  // Empty if the producer did not record the source document.
+  std::string source_url;
+};
+
+// Extracts the fragment and SourceURL from a CF_HTML payload. Reads at most
+// |size| bytes and stops early at a NUL, so the payload may come straight
+// from a clipboard handle whose GlobalSize exceeds its content. Falls back
+// to the comment markers, then to the whole HTML document, when the header
+// offsets are missing or out of range. Returns false if |data| has no
+// recognizable CF_HTML header.
+bool DecodeCfHtml(const char* data, size_t size, CfHtmlFragment* result);
+
+}  // namespace clipboard
+
+#endif  // CF_HTML_H_
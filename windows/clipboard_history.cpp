@@ -0,0 +1,173 @@
+#include "clipboard_history.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "content_hash.h"
+
+namespace clipboard {
+
+namespace {
+
+// Bookkeeping charged to every entry on top of its payload.
+constexpr size_t kEntryOverhead = 128;
+
+// Each field's hash seeds the next, so moving bytes between fields changes
+// the result. Only used to find duplicate candidates, which are then
+// compared in full.
+uint64_t HashContent(const ClipboardContent& content) {
+  uint64_t hash = Xxh64(content.text.data(), content.text.size());
+  hash = Xxh64(content.html.data(), content.html.size(), hash);
+  hash = Xxh64(content.source_url.data(), content.source_url.size(), hash);
+  hash = Xxh64(content.image_png.data(), content.image_png.size(), hash);
+  for (const auto& path : content.file_paths) {
+    hash = Xxh64(path.data(), path.size(), hash);
+  }
+  return hash;
+}
+
+size_t ContentSize(const ClipboardContent& content) {
+  size_t size = kEntryOverhead + content.text.size() + content.html.size() +
+                content.source_url.size() + content.image_png.size();
+  for (const auto& path : content.file_paths) {
+    size += sizeof(std::string) + path.size();
+  }
+  return size;
+}
+
+bool IsEmpty(const ClipboardContent& content) {
+  return content.text.empty() && content.html.empty() &&
+         content.image_png.empty() && content.file_paths.empty();
+}
+
+}  // namespace
+
+bool operator==(const ClipboardContent& a, const ClipboardContent& b) {
+  return a.text == b.text && a.html == b.html &&
+         a.source_url == b.source_url && a.image_png == b.image_png &&
+         a.file_paths == b.file_paths;
+}
+
+ClipboardHistory::ClipboardHistory(size_t max_bytes, size_t max_entries)
+    : max_bytes_(max_bytes), max_entries_(max_entries) {}
+
+uint64_t ClipboardHistory::Add(ClipboardContent content,
+                               int64_t timestamp_ms) {
+  if (IsEmpty(content)) {
+    return 0;
+  }
+  // Hashing and sizing read the whole payload, so they happen unlocked.
+  const uint64_t hash = HashContent(content);
+  const size_t size = ContentSize(content);
+  auto shared = std::make_shared<const ClipboardContent>(std::move(content));
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (size > max_bytes_ || max_entries_ == 0) {
+    return 0;
+  }
+  auto candidates = ids_by_hash_.equal_range(hash);
+  for (auto it = candidates.first; it != candidates.second; ++it) {
+    Node& node = nodes_.at(it->second);
+    if (*node.record.content == *shared) {
+      node.record.timestamp_ms = timestamp_ms;
+      order_.splice(order_.begin(), order_, node.order);
+      lru_.splice(lru_.begin(), lru_, node.lru);
+      stats_.deduplicated++;
+      return node.record.id;
+    }
+  }
+
+  const uint64_t id = next_id_++;
+  Node& node = nodes_[id];
+  node.record.id = id;
+  node.record.timestamp_ms = timestamp_ms;
+  node.record.size_bytes = size;
+  node.record.content = std::move(shared);
+  node.hash = hash;
+  node.order = order_.insert(order_.begin(), id);
+  node.lru = lru_.insert(lru_.begin(), id);
+  ids_by_hash_.emplace(hash, id);
+  bytes_ += size;
+  stats_.added++;
+  EvictLocked();
+  return id;
+}
+
+std::vector<HistoryRecord> ClipboardHistory::Page(size_t offset,
+                                                  size_t limit) {
+  std::vector<HistoryRecord> page;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (offset >= order_.size()) {
+    return page;
+  }
+  page.reserve(std::min(limit, order_.size() - offset));
+  auto it = order_.begin();
+  std::advance(it, offset);
+  for (; it != order_.end() && page.size() < limit; ++it) {
+    page.push_back(nodes_.at(*it).record);
+  }
+  return page;
+}
+
+bool ClipboardHistory::Find(uint64_t id, HistoryRecord* record) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = nodes_.find(id);
+  if (it == nodes_.end()) {
+    return false;
+  }
+  lru_.splice(lru_.begin(), lru_, it->second.lru);
+  *record = it->second.record;
+  return true;
+}
+
+void ClipboardHistory::SetLimits(size_t max_bytes, size_t max_entries) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_bytes_ = max_bytes;
+  max_entries_ = max_entries;
+  EvictLocked();
+}
+
+void ClipboardHistory::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  nodes_.clear();
+  order_.clear();
+  lru_.clear();
+  ids_by_hash_.clear();
+  bytes_ = 0;
+}
+
+ClipboardHistoryStats ClipboardHistory::stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ClipboardHistoryStats stats = stats_;
+  stats.entries = nodes_.size();
+  stats.bytes = bytes_;
+  return stats;
+}
+
+void ClipboardHistory::EvictLocked() {
+  while (!lru_.empty() &&
+         (bytes_ > max_bytes_ || nodes_.size() > max_entries_)) {
+    RemoveLocked(lru_.back());
+    stats_.evicted++;
+  }
+}
+
+void ClipboardHistory::RemoveLocked(uint64_t id) {
+  auto it = nodes_.find(id);
+  Node& node = it->second;
+  auto candidates = ids_by_hash_.equal_range(node.hash);
+  for (auto candidate = candidates.first; candidate != candidates.second;
+       ++candidate) {
+    if (candidate->second == id) {
+      ids_by_hash_.erase(candidate);
+      break;
+    }
+  }
+  order_.erase(node.order);
+  lru_.erase(node.lru);
+  bytes_ -= node.record.size_bytes;
+  nodes_.erase(it);
+}
+
+}  // namespace clipboard
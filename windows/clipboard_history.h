@@ -0,0 +1,109 @@
+#ifndef CLIPBOARD_HISTORY_H_
+#define CLIPBOARD_HISTORY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace clipboard {
+
+// One captured clipboard state. Formats that were absent are empty.
+struct ClipboardContent {
+  std::string text;
+  // HTML fragment and the document it was copied from.
+  std::string html;
+  std::string source_url;
+  // The image, PNG-encoded.
+  std::vector<uint8_t> image_png;
+  std::vector<std::string> file_paths;
+};
+
+bool operator==(const ClipboardContent& a, const ClipboardContent& b);
+
+struct HistoryRecord {
+  uint64_t id = 0;
+  // Most recent capture of this content, in milliseconds since the epoch.
+  int64_t timestamp_ms = 0;
+  size_t size_bytes = 0;
+  std::shared_ptr<const ClipboardContent> content;
+};
+
+struct ClipboardHistoryStats {
+  size_t entries = 0;
+  size_t bytes = 0;
+  uint64_t added = 0;
+  uint64_t deduplicated = 0;
+  uint64_t evicted = 0;
+};
+
+// Clipboard history kept natively, so a clipboard manager can page through
+// thousands of entries without holding them in Dart. Entries are listed
+// newest capture first and evicted least recently used first (captured
+// again or fetched with Find) once the byte or entry budget is exceeded.
+// Capturing content already kept moves that entry to the front instead of
+// storing it twice; candidates are found by content hash and confirmed by
+// comparing payloads. Ids are never reused. All methods may be called
+// from any thread.
+class ClipboardHistory {
+ public:
+  static constexpr size_t kDefaultMaxBytes = 64 * 1024 * 1024;
+  static constexpr size_t kDefaultMaxEntries = 1000;
+
+  explicit ClipboardHistory(size_t max_bytes = kDefaultMaxBytes,
+                            size_t max_entries = kDefaultMaxEntries);
+
+  ClipboardHistory(const ClipboardHistory&) = delete;
+  ClipboardHistory& operator=(const ClipboardHistory&) = delete;
+
+  // Records |content| captured at |timestamp_ms| and returns its entry's
+  // id. Returns 0 without storing anything for empty content and for
+  // content larger than the whole byte budget.
+  uint64_t Add(ClipboardContent content, int64_t timestamp_ms);
+
+  // Up to |limit| entries, newest capture first, after skipping |offset|.
+  std::vector<HistoryRecord> Page(size_t offset, size_t limit);
+
+  // Fills |record| and marks the entry used. Returns false for ids that
+  // were evicted or never existed.
+  bool Find(uint64_t id, HistoryRecord* record);
+
+  // Evicts down to the new budget right away.
+  void SetLimits(size_t max_bytes, size_t max_entries);
+
+  void Clear();
+
+  ClipboardHistoryStats stats();
+
+ private:
+  struct Node {
+    HistoryRecord record;
+    uint64_t hash = 0;
+    std::list<uint64_t>::iterator order;
+    std::list<uint64_t>::iterator lru;
+  };
+
+  void EvictLocked();
+  void RemoveLocked(uint64_t id);
+
+  std::mutex mutex_;
+  size_t max_bytes_;
+  size_t max_entries_;
+  uint64_t next_id_ = 1;
+  std::unordered_map<uint64_t, Node> nodes_;
+  // Newest capture first.
+  std::list<uint64_t> order_;
+  // Most recently used first.
+  std::list<uint64_t> lru_;
+  std::unordered_multimap<uint64_t, uint64_t> ids_by_hash_;
+  size_t bytes_ = 0;
+  ClipboardHistoryStats stats_;
+};
+
+}  // namespace clipboard
+
+#endif  // CLIPBOARD_HISTORY_H_
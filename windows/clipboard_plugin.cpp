@@ -7,11 +7,18 @@
 #include <windows.h>
 #include <shlobj.h>
 #include <shellapi.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <vector>
 #include <algorithm>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
 // GDI+ requires min/max macros which are disabled by NOMINMAX
 // Define them explicitly for GDI+ headers
@@ -39,16 +46,222 @@ using namespace Gdiplus;
 #include <flutter/standard_method_codec.h>
 #include <flutter/event_stream_handler_functions.h>
 
+#include "cf_html.h"
+#include "clipboard_history.h"
+#include "clipboard_session.h"
+#include "clipboard_worker.h"
+#include "content_hash.h"
+#include "drop_files.h"
+#include "event_queue.h"
+#include "image_scale.h"
+#include "image_sniff.h"
+#include "paste_cache.h"
+#include "pixel_convert.h"
+#include "png_encoder.h"
+#include "thread_pool.h"
+#include "utf_transcode.h"
+
 using flutter::EncodableList;
 using flutter::EncodableMap;
 using flutter::EncodableValue;
 
 namespace {
 
-class ClipboardPluginImpl {
+// Owns the GDI+ runtime for the lifetime of the plugin. GDI+ is started on
+// first image use and shut down with the plugin, and encoder CLSIDs are
+// resolved once per MIME type.
+class GdiplusRuntime {
+ public:
+  GdiplusRuntime() {}
+
+  ~GdiplusRuntime() {
+    if (token_ != 0) {
+      GdiplusShutdown(token_);
+    }
+  }
+
+  GdiplusRuntime(const GdiplusRuntime&) = delete;
+  GdiplusRuntime& operator=(const GdiplusRuntime&) = delete;
+
+  bool EnsureStarted() {
+    if (token_ != 0) {
+      return true;
+    }
+    GdiplusStartupInput gdiplusStartupInput;
+    if (GdiplusStartup(&token_, &gdiplusStartupInput, nullptr) != Ok) {
+      token_ = 0;
+      return false;
+    }
+    return true;
+  }
+
+  // Returns the encoder CLSID for |mime_type|, or nullptr if GDI+ has no
+  // encoder for it. Requires EnsureStarted().
+  const CLSID* GetEncoderClsid(const std::wstring& mime_type) {
+    auto it = encoder_clsids_.find(mime_type);
+    if (it != encoder_clsids_.end()) {
+      return &it->second;
+    }
+
+    UINT count = 0;
+    UINT size = 0;
+    if (GetImageEncodersSize(&count, &size) != Ok || size == 0) {
+      return nullptr;
+    }
+    std::vector<BYTE> buffer(size);
+    ImageCodecInfo* codecs = reinterpret_cast<ImageCodecInfo*>(buffer.data());
+    if (GetImageEncoders(count, size, codecs) != Ok) {
+      return nullptr;
+    }
+    for (UINT i = 0; i < count; i++) {
+      if (mime_type == codecs[i].MimeType) {
+        auto inserted = encoder_clsids_.emplace(mime_type, codecs[i].Clsid);
+        return &inserted.first->second;
+      }
+    }
+    return nullptr;
+  }
+
+ private:
+  ULONG_PTR token_ = 0;
+  std::map<std::wstring, CLSID> encoder_clsids_;
+};
+
+// Read-only memory-mapped view of a whole file.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::wstring& path) {
+    file_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    LARGE_INTEGER size;
+    if (file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &size) || size.QuadPart <= 0 ||
+        static_cast<uint64_t>(size.QuadPart) > SIZE_MAX) {
+      return;
+    }
+    mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_) {
+      return;
+    }
+    data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (data_) {
+      size_ = static_cast<size_t>(size.QuadPart);
+    }
+  }
+
+  ~MappedFile() {
+    if (data_) {
+      UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+      CloseHandle(mapping_);
+    }
+    if (file_ != INVALID_HANDLE_VALUE) {
+      CloseHandle(file_);
+    }
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool is_valid() const { return data_ != nullptr; }
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  HANDLE file_ = INVALID_HANDLE_VALUE;
+  HANDLE mapping_ = nullptr;
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+// Copies from a mapped view. Returns false instead of crashing when the
+// file cannot be paged in, e.g. a network share went away mid-read.
+bool CopyMappedBytes(const uint8_t* src, size_t size, uint8_t* dst) {
+  __try {
+    memcpy(dst, src, size);
+  } __except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER
+                                                            : EXCEPTION_CONTINUE_SEARCH) {
+    return false;
+  }
+  return true;
+}
+
+// Outcome of one clipboard operation. Handlers report into it on whichever
+// thread they run on, and DeliverTo replays it into the Flutter MethodResult
+// on the platform thread. Successful values are shared, so cached paste
+// results are delivered without copying.
+class OperationResult {
+ public:
+  void Success(EncodableValue value) {
+    Success(std::make_shared<const EncodableValue>(std::move(value)));
+  }
+
+  void Success(std::shared_ptr<const EncodableValue> value) {
+    kind_ = Kind::kSuccess;
+    value_ = std::move(value);
+  }
+
+  void Error(const std::string& code, const std::string& message) {
+    kind_ = Kind::kError;
+    error_code_ = code;
+    error_message_ = message;
+  }
+
+  // An error caused by another process holding the clipboard lock.
+  void ClipboardBusy(const std::string& code, const std::string& message) {
+    Error(code, message);
+    clipboard_busy_ = true;
+  }
+
+  void NotImplemented() { kind_ = Kind::kNotImplemented; }
+
+  bool clipboard_busy() const { return clipboard_busy_; }
+
+  // The outcome as one entry of a batch result: {success: true, value} or
+  // {success: false, code, message}.
+  EncodableValue ToBatchEntry() const {
+    if (kind_ == Kind::kSuccess) {
+      return EncodableValue(EncodableMap{
+          {EncodableValue("success"), EncodableValue(true)},
+          {EncodableValue("value"), *value_},
+      });
+    }
+    const bool implemented = kind_ == Kind::kError;
+    return EncodableValue(EncodableMap{
+        {EncodableValue("success"), EncodableValue(false)},
+        {EncodableValue("code"), EncodableValue(implemented ? error_code_ : "NOT_IMPLEMENTED")},
+        {EncodableValue("message"),
+         EncodableValue(implemented ? error_message_ : "Unknown method")},
+    });
+  }
+
+  void DeliverTo(flutter::MethodResult<EncodableValue>& result) const {
+    switch (kind_) {
+      case Kind::kSuccess:
+        result.Success(*value_);
+        break;
+      case Kind::kError:
+        result.Error(error_code_, error_message_);
+        break;
+      case Kind::kNotImplemented:
+        result.NotImplemented();
+        break;
+    }
+  }
+
+ private:
+  enum class Kind { kSuccess, kError, kNotImplemented };
+
+  Kind kind_ = Kind::kNotImplemented;
+  std::shared_ptr<const EncodableValue> value_;
+  std::string error_code_;
+  std::string error_message_;
+  bool clipboard_busy_ = false;
+};
+
+class ClipboardPluginImpl : public flutter::Plugin {
  public:
-  static void RegisterWithRegistrar(FlutterDesktopPluginRegistrarRef registrar_ref) {
-    auto registrar = std::make_unique<flutter::PluginRegistrarWindows>(registrar_ref);
+  static void RegisterWithRegistrar(flutter::PluginRegistrarWindows* registrar) {
     auto plugin = std::make_unique<ClipboardPluginImpl>();
     
     auto method_channel = std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
@@ -69,25 +282,58 @@ class ClipboardPluginImpl {
             [plugin_pointer = plugin.get()](const EncodableValue* arguments,
                                              std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&& events)
                 -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
-              plugin_pointer->event_sink_ = events.release();
+              plugin_pointer->event_sink_ = std::move(events);
+              plugin_pointer->acknowledge_events_ = ReadAcknowledgeArgument(arguments);
+              plugin_pointer->events_in_flight_ = 0;
+              plugin_pointer->event_queue_.Clear();
+              plugin_pointer->has_event_listener_ = true;
+              plugin_pointer->RunOnWorker([plugin_pointer] { plugin_pointer->StartMonitoring(); });
               return nullptr;
             },
             [plugin_pointer = plugin.get()](const EncodableValue* arguments)
                 -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
-              plugin_pointer->event_sink_ = nullptr;
+              plugin_pointer->has_event_listener_ = false;
+              plugin_pointer->RunOnWorker([plugin_pointer] { plugin_pointer->StopMonitoring(); });
+              plugin_pointer->event_sink_.reset();
+              plugin_pointer->event_queue_.Clear();
               return nullptr;
             }));
 
-    // Keep plugin and registrar alive
-    static std::vector<std::unique_ptr<ClipboardPluginImpl>> plugins;
-    static std::vector<std::unique_ptr<flutter::PluginRegistrarWindows>> registrars;
-    plugins.push_back(std::move(plugin));
-    registrars.push_back(std::move(registrar));
+    // The registrar owns the plugin, so it (and the GDI+ runtime) is torn
+    // down together with the engine rather than at DLL unload.
+    registrar->AddPlugin(std::move(plugin));
   }
 
-  ClipboardPluginImpl() {}
+  ClipboardPluginImpl() : platform_thread_id_(GetCurrentThreadId()) {
+    // Results are handed back through the platform runner, so without it
+    // everything stays on the platform thread with no owner window.
+    platform_runner_ = std::make_unique<clipboard::PlatformTaskRunner>();
+    if (!platform_runner_->is_valid()) {
+      return;
+    }
+    worker_ = std::make_unique<clipboard::ClipboardWorker>(
+        [this](HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam, LRESULT* result) {
+          return HandleOwnerMessage(hwnd, message, wparam, lparam, result);
+        });
+    if (worker_->is_valid()) {
+      owner_window_ = worker_->window();
+    } else {
+      worker_.reset();
+    }
+  }
 
-  virtual ~ClipboardPluginImpl() {}
+  virtual ~ClipboardPluginImpl() {
+    // Finishing the worker destroys the clipboard owner, which renders
+    // pending formats while the payloads and GDI+ are still alive. Results
+    // still queued for the platform thread are dropped with the runner.
+    history_enabled_ = false;
+    if (worker_) {
+      worker_->Post([this] { StopMonitoring(); });
+      worker_.reset();
+    }
+    owner_window_ = nullptr;
+    platform_runner_.reset();
+  }
 
   void HandleMethodCall(
       const flutter::MethodCall<flutter::EncodableValue> &method_call,
@@ -96,39 +342,338 @@ class ClipboardPluginImpl {
     const std::string& method = method_call.method_name();
     const auto* arguments = std::get_if<EncodableMap>(method_call.arguments());
 
-    if (method == "copy") {
-      HandleCopy(arguments, std::move(result));
+    // Event delivery state belongs to this thread, so acknowledgements never
+    // wait behind clipboard work on the worker.
+    if (method == "ackEvent") {
+      if (events_in_flight_ > 0) {
+        events_in_flight_--;
+      }
+      DeliverEvents();
+      result->Success(EncodableValue(true));
+      return;
+    }
+
+    // Cheap calls skip the thread hop, but only when nothing is queued on the
+    // worker; otherwise they could overtake an earlier copy. Cached pastes
+    // are answered with the entry found here and never by running the
+    // handler, which would do the uncached work on this thread if the
+    // clipboard changed in between.
+    std::string cache_key;
+    if (worker_ && worker_->IsIdle() && PasteCacheKey(method, arguments, &cache_key)) {
+      if (auto cached = paste_cache_.FindIfCached(GetClipboardSequenceNumber(), cache_key)) {
+        result->Success(*cached);
+        return;
+      }
+    }
+    if (!worker_ || (worker_->IsIdle() && CanRunInline(method, arguments))) {
+      OperationResult operation_result;
+      RunOperation(method, arguments ? std::make_shared<EncodableMap>(*arguments) : nullptr,
+                   &operation_result);
+      // Inline calls try the lock once; waiting for it is the worker's job
+      if (!worker_ || !operation_result.clipboard_busy()) {
+        operation_result.DeliverTo(*result);
+        return;
+      }
+    }
+
+    // The call only lives until we return, so the worker takes over its
+    // arguments
+    std::shared_ptr<EncodableMap> owned_arguments = TakeCallArguments(method_call);
+    std::shared_ptr<flutter::MethodResult<EncodableValue>> reply = std::move(result);
+    worker_->Post([this, method, owned_arguments, reply] {
+      auto operation_result = std::make_shared<OperationResult>();
+      RunOperation(method, owned_arguments, operation_result.get());
+      platform_runner_->Post([operation_result, reply] { operation_result->DeliverTo(*reply); });
+    });
+  }
+
+  // The flutter wrapper's MethodCall owns its arguments through a
+  // std::unique_ptr<T> filled by MethodCodec::DecodeMethodCall, and
+  // MethodChannel hands the handler a reference to that call and destroys
+  // it once the handler returns (cpp_client_wrapper method_call.h and
+  // method_channel.h, unchanged from Flutter 1.10 through 3.x). The
+  // arguments are therefore a mutable object that nothing reads after
+  // HandleMethodCall, and moving out of them is defined. That is what lets
+  // text and image payloads of hundreds of megabytes reach the worker
+  // without a copy. This is the only place that relies on it; if the
+  // wrapper ever stops meeting the assertions below, or shares arguments
+  // between calls, copy the map here instead.
+  static std::shared_ptr<EncodableMap> TakeCallArguments(
+      const flutter::MethodCall<EncodableValue>& method_call) {
+    static_assert(!std::is_copy_constructible_v<flutter::MethodCall<EncodableValue>>,
+                  "MethodCall must own its arguments exclusively");
+    static_assert(std::is_same_v<decltype(method_call.arguments()), const EncodableValue*>,
+                  "MethodCall::arguments() must point into the call's own storage");
+    const auto* arguments = std::get_if<EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      return nullptr;
+    }
+    return std::make_shared<EncodableMap>(std::move(*const_cast<EncodableMap*>(arguments)));
+  }
+
+  // The paste cache key |method| with |arguments| stores its result under,
+  // for the methods whose results are cached.
+  static bool PasteCacheKey(const std::string& method, const EncodableMap* arguments,
+                            std::string* key) {
+    if (method == "paste" || method == "pasteRichText" || method == "pasteImage" ||
+        method == "pasteAll" || method == "getContentHash") {
+      *key = method;
+      return true;
+    }
+    if (method == "pasteImageRaw") {
+      RawImageRequest request;
+      if (!ReadRawImageRequest(arguments, &request)) {
+        return false;
+      }
+      *key = request.CacheKey();
+      return true;
+    }
+    if (method == "pasteImageThumbnail") {
+      int max_dimension = 0;
+      clipboard::ScaleFilter filter = clipboard::ScaleFilter::kBox;
+      if (!ReadThumbnailRequest(arguments, &max_dimension, &filter)) {
+        return false;
+      }
+      *key = ThumbnailCacheKey(max_dimension, filter);
+      return true;
+    }
+    return false;
+  }
+
+  // Whether |method| is cheap enough to run on the platform thread: format
+  // queries, settings and copies of short text. Pastes never are, even when
+  // cached; HandleMethodCall answers those from the cache itself.
+  bool CanRunInline(const std::string& method, const EncodableMap* arguments) {
+    if (method == "hasData" || method == "getContentType" || method == "getPasteCacheStats" ||
+        method == "getClipboardLockStats" || method == "setClipboardLockOptions" ||
+        method == "setImageEncodingOptions" || method == "setMonitoringOptions" ||
+        method == "getMonitoringStats" || method == "setEventSubscriptions") {
+      return true;
+    }
+    if (method == "copy" || method == "copyRichText") {
+      if (!arguments) {
+        return true;
+      }
+      size_t size = 0;
+      for (const char* key : {"text", "html"}) {
+        auto it = arguments->find(EncodableValue(key));
+        if (it != arguments->end()) {
+          if (const auto* str = std::get_if<std::string>(&it->second)) {
+            size += str->size();
+          }
+        }
+      }
+      return size <= kInlineTextThreshold;
+    }
+    return false;
+  }
+
+  // Runs |task| on the clipboard worker, or right away if there is none.
+  void RunOnWorker(std::function<void()> task) {
+    if (worker_) {
+      worker_->Post(std::move(task));
+    } else {
+      task();
+    }
+  }
+
+  // Sends |event| to Dart from any thread. Events queue up while Dart has
+  // one it has not acknowledged yet; the queue keeps only the newest.
+  void SendEvent(EncodableValue event) {
+    event_queue_.Push(std::move(event));
+    if (worker_) {
+      platform_runner_->Post([this] { DeliverEvents(); });
+    } else {
+      DeliverEvents();
+    }
+  }
+
+  // Hands queued events to the sink until one is awaiting acknowledgement.
+  // Platform thread only.
+  void DeliverEvents() {
+    EncodableValue event;
+    while ((!acknowledge_events_ || events_in_flight_ == 0) && event_queue_.Pop(&event)) {
+      if (!event_sink_) {
+        continue;
+      }
+      if (acknowledge_events_) {
+        if (auto* map = std::get_if<EncodableMap>(&event)) {
+          (*map)[EncodableValue("acknowledge")] = EncodableValue(true);
+        }
+        events_in_flight_++;
+      }
+      event_sink_->Success(event);
+      events_delivered_++;
+    }
+  }
+
+  // Whether the listener asked for flow control: it then acknowledges each
+  // event with ackEvent, and no further event is sent until it does.
+  static bool ReadAcknowledgeArgument(const EncodableValue* arguments) {
+    const auto* map = arguments ? std::get_if<EncodableMap>(arguments) : nullptr;
+    if (!map) {
+      return false;
+    }
+    auto it = map->find(EncodableValue("acknowledge"));
+    const bool* acknowledge = it != map->end() ? std::get_if<bool>(&it->second) : nullptr;
+    return acknowledge && *acknowledge;
+  }
+
+  // Lock policy for the calling thread. On the platform thread a single
+  // attempt is made; a busy clipboard sends the call to the worker, which
+  // retries with backoff.
+  clipboard::ClipboardAcquireOptions AcquireOptions() {
+    clipboard::ClipboardAcquireOptions options = clipboard_lock_.options();
+    if (worker_ && GetCurrentThreadId() == platform_thread_id_) {
+      options.timeout_ms = 0;
+    }
+    return options;
+  }
+
+  static void ReportOpenFailure(OperationResult* result, const std::string& code,
+                                const clipboard::ClipboardSession& session) {
+    std::ostringstream message;
+    message << "Failed to open clipboard after " << session.attempts() << " attempts in "
+            << session.wait_micros() / 1000 << " ms";
+    result->ClipboardBusy(code, message.str());
+  }
+
+  // |arguments| is shared so that delayed renders can keep payloads alive
+  // without copying them. The operation owns it and may move payloads out,
+  // as batches do for their operations.
+  void RunOperation(const std::string& method, const std::shared_ptr<EncodableMap>& arguments,
+                    OperationResult* result) {
+    if (method == "batch") {
+      HandleBatch(arguments, result);
+    } else if (method == "copy") {
+      HandleCopy(arguments, result);
     } else if (method == "copyRichText") {
-      HandleCopyRichText(arguments, std::move(result));
+      HandleCopyRichText(arguments, result);
     } else if (method == "copyMultiple") {
-      HandleCopyMultiple(arguments, std::move(result));
+      HandleCopyMultiple(arguments, result);
     } else if (method == "copyImage") {
-      HandleCopyImage(arguments, std::move(result));
+      HandleCopyImage(arguments, result);
     } else if (method == "paste") {
-      HandlePaste(std::move(result));
+      HandlePaste(result);
     } else if (method == "pasteRichText") {
-      HandlePasteRichText(std::move(result));
+      HandlePasteRichText(result);
     } else if (method == "pasteImage") {
-      HandlePasteImage(std::move(result));
+      HandlePasteImage(result);
+    } else if (method == "pasteAll") {
+      HandlePasteAll(result);
+    } else if (method == "pasteImageRaw") {
+      HandlePasteImageRaw(arguments.get(), result);
+    } else if (method == "pasteImageThumbnail") {
+      HandlePasteImageThumbnail(arguments.get(), result);
+    } else if (method == "pasteFiles") {
+      HandlePasteFiles(result);
+    } else if (method == "setHistoryOptions") {
+      HandleSetHistoryOptions(arguments.get(), result);
+    } else if (method == "getHistory") {
+      HandleGetHistory(arguments.get(), result);
+    } else if (method == "getHistoryItem") {
+      HandleGetHistoryItem(arguments.get(), result);
+    } else if (method == "clearHistory") {
+      history_.Clear();
+      result->Success(EncodableValue(true));
     } else if (method == "getContentType") {
-      HandleGetContentType(std::move(result));
+      HandleGetContentType(result);
     } else if (method == "hasData") {
-      HandleHasData(std::move(result));
+      HandleHasData(result);
     } else if (method == "clear") {
-      HandleClear(std::move(result));
+      HandleClear(result);
     } else if (method == "getDataSize") {
-      HandleGetDataSize(std::move(result));
+      HandleGetDataSize(result);
+    } else if (method == "getFormatSizes") {
+      HandleGetFormatSizes(result);
+    } else if (method == "getContentHash") {
+      HandleGetContentHash(result);
+    } else if (method == "getPasteCacheStats") {
+      HandleGetPasteCacheStats(result);
+    } else if (method == "getClipboardLockStats") {
+      HandleGetClipboardLockStats(result);
+    } else if (method == "setClipboardLockOptions") {
+      HandleSetClipboardLockOptions(arguments.get(), result);
+    } else if (method == "setImageEncodingOptions") {
+      HandleSetImageEncodingOptions(arguments.get(), result);
+    } else if (method == "setMonitoringOptions") {
+      HandleSetMonitoringOptions(arguments.get(), result);
+    } else if (method == "getMonitoringStats") {
+      HandleGetMonitoringStats(result);
+    } else if (method == "setEventSubscriptions") {
+      HandleSetEventSubscriptions(arguments.get(), result);
     } else if (method == "startMonitoring") {
-      result->Success(EncodableValue(true));
+      if (StartMonitoring()) {
+        result->Success(EncodableValue(true));
+      } else {
+        result->Error("MONITORING_ERROR", "Failed to register clipboard format listener");
+      }
     } else if (method == "stopMonitoring") {
+      StopMonitoring();
       result->Success(EncodableValue(true));
     } else {
       result->NotImplemented();
     }
   }
 
-  void HandleCopy(const EncodableMap* arguments,
-                  std::unique_ptr<flutter::MethodResult<EncodableValue>> result) {
+  // Runs {operations: [{method, arguments}]} in order while holding the
+  // clipboard once: every session the operations open joins the batch's,
+  // so they see one consistent clipboard and pay for one acquisition. The
+  // lock is then also held through any encoding they do. Each operation
+  // gets an entry in the returned list (see OperationResult::ToBatchEntry);
+  // a failed one does not stop the rest.
+  void HandleBatch(const std::shared_ptr<EncodableMap>& arguments, OperationResult* result) {
+    EncodableList* operations = nullptr;
+    if (arguments) {
+      auto it = arguments->find(EncodableValue("operations"));
+      if (it != arguments->end()) {
+        operations = std::get_if<EncodableList>(&it->second);
+      }
+    }
+    if (!operations) {
+      result->Error("INVALID_ARGUMENT", "operations must be a list");
+      return;
+    }
+    clipboard::ClipboardBatch batch(owner_window_, &clipboard_lock_, AcquireOptions());
+    if (!batch.is_open()) {
+      ReportOpenFailure(result, "BATCH_ERROR", batch.session());
+      return;
+    }
+    EncodableList results;
+    results.reserve(operations->size());
+    for (auto& operation : *operations) {
+      OperationResult operation_result;
+      auto* map = std::get_if<EncodableMap>(&operation);
+      const std::string* method = nullptr;
+      if (map) {
+        auto method_it = map->find(EncodableValue("method"));
+        if (method_it != map->end()) {
+          method = std::get_if<std::string>(&method_it->second);
+        }
+      }
+      if (!method) {
+        operation_result.Error("INVALID_ARGUMENT", "Each operation needs a method name");
+      } else if (*method == "batch") {
+        operation_result.Error("INVALID_ARGUMENT", "Batches cannot be nested");
+      } else {
+        // Like the call itself, the batch owns its arguments, so payloads
+        // are moved to the operation rather than copied
+        std::shared_ptr<EncodableMap> operation_arguments;
+        auto arguments_it = map->find(EncodableValue("arguments"));
+        if (arguments_it != map->end()) {
+          if (auto* operation_map = std::get_if<EncodableMap>(&arguments_it->second)) {
+            operation_arguments = std::make_shared<EncodableMap>(std::move(*operation_map));
+          }
+        }
+        RunOperation(*method, operation_arguments, &operation_result);
+      }
+      results.push_back(operation_result.ToBatchEntry());
+    }
+    result->Success(EncodableValue(std::move(results)));
+  }
+
+  void HandleCopy(const std::shared_ptr<const EncodableMap>& arguments,
+                  OperationResult* result) {
     if (!arguments) {
       result->Error("INVALID_ARGUMENT", "Arguments are required");
       return;
@@ -146,101 +691,67 @@ class ClipboardPluginImpl {
       return;
     }
 
-    if (OpenClipboard(nullptr)) {
+    clipboard::ClipboardSession session(owner_window_, &clipboard_lock_, AcquireOptions());
+    if (session.is_open()) {
       EmptyClipboard();
-      
-      // Convert to wide string for Windows
-      int size_needed = MultiByteToWideChar(CP_UTF8, 0, text->c_str(), -1, NULL, 0);
-      std::vector<wchar_t> wstr(size_needed);
-      MultiByteToWideChar(CP_UTF8, 0, text->c_str(), -1, &wstr[0], size_needed);
-      
-      HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, (wstr.size()) * sizeof(wchar_t));
-      if (hMem) {
-        wchar_t* pMem = (wchar_t*)GlobalLock(hMem);
-        wcscpy_s(pMem, wstr.size(), &wstr[0]);
-        GlobalUnlock(hMem);
-        SetClipboardData(CF_UNICODETEXT, hMem);
-      }
-      CloseClipboard();
+      SetClipboardText(SharedPayload(arguments, text));
+      session.Close();
       result->Success(EncodableValue(true));
     } else {
-      result->Error("COPY_ERROR", "Failed to open clipboard");
+      ReportOpenFailure(result, "COPY_ERROR", session);
     }
   }
 
-  void HandleCopyRichText(const EncodableMap* arguments,
-                          std::unique_ptr<flutter::MethodResult<EncodableValue>> result) {
+  void HandleCopyRichText(const std::shared_ptr<const EncodableMap>& arguments,
+                          OperationResult* result) {
     if (!arguments) {
       result->Error("INVALID_ARGUMENT", "Arguments are required");
       return;
     }
 
-    std::string text;
-    std::string html;
+    const std::string* text = nullptr;
+    const std::string* html = nullptr;
 
     auto text_it = arguments->find(EncodableValue("text"));
     if (text_it != arguments->end()) {
-      const auto* text_ptr = std::get_if<std::string>(&text_it->second);
-      if (text_ptr) text = *text_ptr;
+      text = std::get_if<std::string>(&text_it->second);
     }
 
     auto html_it = arguments->find(EncodableValue("html"));
     if (html_it != arguments->end()) {
-      const auto* html_ptr = std::get_if<std::string>(&html_it->second);
-      if (html_ptr) html = *html_ptr;
+      html = std::get_if<std::string>(&html_it->second);
     }
 
-    if (text.empty() && html.empty()) {
+    const bool has_text = text && !text->empty();
+    const bool has_html = html && !html->empty();
+    if (!has_text && !has_html) {
       result->Error("EMPTY_CONTENT", "Either text or html must be provided");
       return;
     }
 
-    if (OpenClipboard(nullptr)) {
+    clipboard::ClipboardSession session(owner_window_, &clipboard_lock_, AcquireOptions());
+    if (session.is_open()) {
       EmptyClipboard();
       
       // Set text
-      if (!text.empty()) {
-        int size_needed = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, NULL, 0);
-        std::vector<wchar_t> wstr(size_needed);
-        MultiByteToWideChar(CP_UTF8, 0, text.c_str(), -1, &wstr[0], size_needed);
-        
-        HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, (wstr.size()) * sizeof(wchar_t));
-        if (hMem) {
-          wchar_t* pMem = (wchar_t*)GlobalLock(hMem);
-          wcscpy_s(pMem, wstr.size(), &wstr[0]);
-          GlobalUnlock(hMem);
-          SetClipboardData(CF_UNICODETEXT, hMem);
-        }
+      if (has_text) {
+        SetClipboardText(SharedPayload(arguments, text));
       }
 
       // Set HTML if available
-      if (!html.empty()) {
-        UINT cf_html = RegisterClipboardFormatA("HTML Format");
-        if (cf_html != 0) {
-          std::string html_format = "Version:0.9\r\nStartHTML:00000000\r\nEndHTML:00000000\r\nStartFragment:00000000\r\nEndFragment:00000000\r\n";
-          html_format += "<html><body><!--StartFragment-->";
-          html_format += html;
-          html_format += "<!--EndFragment--></body></html>";
-          
-          HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, html_format.size() + 1);
-          if (hMem) {
-            char* pMem = (char*)GlobalLock(hMem);
-            strcpy_s(pMem, html_format.size() + 1, html_format.c_str());
-            GlobalUnlock(hMem);
-            SetClipboardData(cf_html, hMem);
-          }
-        }
+      if (has_html) {
+        SetClipboardHtml(SharedPayload(arguments, html));
       }
 
-      CloseClipboard();
+      session.Close();
       result->Success(EncodableValue(true));
     } else {
-      result->Error("COPY_RICH_ERROR", "Failed to open clipboard");
+      ReportOpenFailure(result, "COPY_RICH_ERROR", session);
     }
   }
 
-  void HandleCopyMultiple(const EncodableMap* arguments,
-                          std::unique_ptr<flutter::MethodResult<EncodableValue>> result) {
+  void HandleCopyMultiple(const std::shared_ptr<const EncodableMap>& arguments,
+                          OperationResult* result) {
     if (!arguments) {
       result->Error("INVALID_ARGUMENT", "Arguments are required");
       return;
@@ -258,25 +769,16 @@ class ClipboardPluginImpl {
       return;
     }
 
-    if (OpenClipboard(nullptr)) {
+    clipboard::ClipboardSession session(owner_window_, &clipboard_lock_, AcquireOptions());
+    if (session.is_open()) {
       EmptyClipboard();
 
       // Handle image first
       auto image_it = formats->find(EncodableValue("image/png"));
       if (image_it != formats->end()) {
-        const auto* image_bytes = std::get_if<EncodableList>(&image_it->second);
-        if (image_bytes && !image_bytes->empty()) {
-          std::vector<uint8_t> bytes;
-          for (const auto& byte_val : *image_bytes) {
-            if (const auto* byte_int32 = std::get_if<int32_t>(&byte_val)) {
-              bytes.push_back(static_cast<uint8_t>(*byte_int32));
-            } else if (const auto* byte_int64 = std::get_if<int64_t>(&byte_val)) {
-              bytes.push_back(static_cast<uint8_t>(*byte_int64));
-            }
-          }
-          if (!bytes.empty()) {
-            SetClipboardImage(bytes);
-          }
+        auto bytes = GetSharedImageBytes(arguments, image_it->second);
+        if (bytes && !bytes->empty()) {
+          SetClipboardImage(bytes);
         }
       }
 
@@ -285,17 +787,7 @@ class ClipboardPluginImpl {
       if (text_it != formats->end()) {
         const auto* text = std::get_if<std::string>(&text_it->second);
         if (text && !text->empty()) {
-          int size_needed = MultiByteToWideChar(CP_UTF8, 0, text->c_str(), -1, NULL, 0);
-          std::vector<wchar_t> wstr(size_needed);
-          MultiByteToWideChar(CP_UTF8, 0, text->c_str(), -1, &wstr[0], size_needed);
-          
-          HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, (wstr.size()) * sizeof(wchar_t));
-          if (hMem) {
-            wchar_t* pMem = (wchar_t*)GlobalLock(hMem);
-            wcscpy_s(pMem, wstr.size(), &wstr[0]);
-            GlobalUnlock(hMem);
-            SetClipboardData(CF_UNICODETEXT, hMem);
-          }
+          SetClipboardText(SharedPayload(arguments, text));
         }
       }
 
@@ -304,33 +796,19 @@ class ClipboardPluginImpl {
       if (html_it != formats->end()) {
         const auto* html = std::get_if<std::string>(&html_it->second);
         if (html && !html->empty()) {
-          UINT cf_html = RegisterClipboardFormatA("HTML Format");
-          if (cf_html != 0) {
-            std::string html_format = "Version:0.9\r\nStartHTML:00000000\r\nEndHTML:00000000\r\nStartFragment:00000000\r\nEndFragment:00000000\r\n";
-            html_format += "<html><body><!--StartFragment-->";
-            html_format += *html;
-            html_format += "<!--EndFragment--></body></html>";
-            
-            HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, html_format.size() + 1);
-            if (hMem) {
-              char* pMem = (char*)GlobalLock(hMem);
-              strcpy_s(pMem, html_format.size() + 1, html_format.c_str());
-              GlobalUnlock(hMem);
-              SetClipboardData(cf_html, hMem);
-            }
-          }
+          SetClipboardHtml(SharedPayload(arguments, html));
         }
       }
 
-      CloseClipboard();
+      session.Close();
       result->Success(EncodableValue(true));
     } else {
-      result->Error("COPY_MULTIPLE_ERROR", "Failed to open clipboard");
+      ReportOpenFailure(result, "COPY_MULTIPLE_ERROR", session);
     }
   }
 
-  void HandleCopyImage(const EncodableMap* arguments,
-                       std::unique_ptr<flutter::MethodResult<EncodableValue>> result) {
+  void HandleCopyImage(const std::shared_ptr<const EncodableMap>& arguments,
+                       OperationResult* result) {
     if (!arguments) {
       result->Error("INVALID_ARGUMENT", "Arguments are required");
       return;
@@ -342,30 +820,17 @@ class ClipboardPluginImpl {
       return;
     }
 
-    const auto* image_bytes = std::get_if<EncodableList>(&image_bytes_it->second);
-    if (!image_bytes || image_bytes->empty()) {
-      result->Error("EMPTY_IMAGE", "Image bytes cannot be empty");
-      return;
-    }
-
-    std::vector<uint8_t> bytes;
-    for (const auto& byte_val : *image_bytes) {
-      if (const auto* byte_int32 = std::get_if<int32_t>(&byte_val)) {
-        bytes.push_back(static_cast<uint8_t>(*byte_int32));
-      } else if (const auto* byte_int64 = std::get_if<int64_t>(&byte_val)) {
-        bytes.push_back(static_cast<uint8_t>(*byte_int64));
-      }
-    }
-
-    if (bytes.empty()) {
+    auto bytes = GetSharedImageBytes(arguments, image_bytes_it->second);
+    if (!bytes || bytes->empty()) {
       result->Error("EMPTY_IMAGE", "Image bytes cannot be empty");
       return;
     }
 
-    if (OpenClipboard(nullptr)) {
+    clipboard::ClipboardSession session(owner_window_, &clipboard_lock_, AcquireOptions());
+    if (session.is_open()) {
       EmptyClipboard();
       bool success = SetClipboardImage(bytes);
-      CloseClipboard();
+      session.Close();
       
       if (success) {
         result->Success(EncodableValue(true));
@@ -373,482 +838,2104 @@ class ClipboardPluginImpl {
         result->Error("COPY_IMAGE_ERROR", "Failed to copy image to clipboard");
       }
     } else {
-      result->Error("COPY_IMAGE_ERROR", "Failed to open clipboard");
+      ReportOpenFailure(result, "COPY_IMAGE_ERROR", session);
     }
   }
 
-  bool SetClipboardImage(const std::vector<uint8_t>& png_bytes) {
-    if (png_bytes.empty()) {
-      return false;
+  // Returns the image bytes carried by |value|. Uint8List arrives as
+  // std::vector<uint8_t> and is used in place; a List<int> from older Dart
+  // callers is unpacked into |legacy_storage|.
+  static const std::vector<uint8_t>* GetImageBytes(const EncodableValue& value,
+                                                   std::vector<uint8_t>& legacy_storage) {
+    if (const auto* typed = std::get_if<std::vector<uint8_t>>(&value)) {
+      return typed;
+    }
+    const auto* list = std::get_if<EncodableList>(&value);
+    if (!list) {
+      return nullptr;
+    }
+    legacy_storage.reserve(list->size());
+    for (const auto& byte_val : *list) {
+      if (const auto* byte_int32 = std::get_if<int32_t>(&byte_val)) {
+        legacy_storage.push_back(static_cast<uint8_t>(*byte_int32));
+      } else if (const auto* byte_int64 = std::get_if<int64_t>(&byte_val)) {
+        legacy_storage.push_back(static_cast<uint8_t>(*byte_int64));
+      }
     }
+    return &legacy_storage;
+  }
 
-    // Initialize GDI+
-    GdiplusStartupInput gdiplusStartupInput;
-    ULONG_PTR gdiplusToken;
-    GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, nullptr);
+  // Shares ownership of |payload|, which lives inside |arguments|, so it can
+  // outlive the call for delayed rendering without being copied.
+  template <typename T>
+  static std::shared_ptr<const T> SharedPayload(const std::shared_ptr<const EncodableMap>& arguments,
+                                                const T* payload) {
+    return std::shared_ptr<const T>(arguments, payload);
+  }
 
-    // Create IStream from PNG bytes
-    IStream* pStream = nullptr;
-    HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, png_bytes.size());
-    if (!hMem) {
-      GdiplusShutdown(gdiplusToken);
-      return false;
+  // GetImageBytes for payloads that may be kept for delayed rendering.
+  static std::shared_ptr<const std::vector<uint8_t>> GetSharedImageBytes(
+      const std::shared_ptr<const EncodableMap>& arguments, const EncodableValue& value) {
+    std::vector<uint8_t> legacy_storage;
+    const auto* bytes = GetImageBytes(value, legacy_storage);
+    if (!bytes) {
+      return nullptr;
     }
+    if (bytes == &legacy_storage) {
+      return std::make_shared<const std::vector<uint8_t>>(std::move(legacy_storage));
+    }
+    return SharedPayload(arguments, bytes);
+  }
 
-    void* pMem = GlobalLock(hMem);
-    if (!pMem) {
-      GlobalFree(hMem);
-      GdiplusShutdown(gdiplusToken);
+  // Publishes an encoded image on the (already opened and emptied) clipboard.
+  // PNG input is placed as-is under the registered "PNG" format, which
+  // browsers and Office read directly; a CF_DIBV5 with alpha is added for
+  // legacy consumers, and Windows synthesizes CF_DIB/CF_BITMAP from it.
+  bool SetClipboardImage(std::shared_ptr<const std::vector<uint8_t>> payload) {
+    const std::vector<uint8_t>& png_bytes = *payload;
+    if (png_bytes.empty()) {
       return false;
     }
 
-    memcpy(pMem, png_bytes.data(), png_bytes.size());
-    GlobalUnlock(hMem);
+    bool success = false;
+    if (IsPngSignature(png_bytes)) {
+      UINT cf_png = RegisterClipboardFormatA("PNG");
+      HGLOBAL hPng = cf_png != 0 ? CreateGlobalFromBytes(png_bytes.data(), png_bytes.size()) : nullptr;
+      if (hPng) {
+        if (SetClipboardData(cf_png, hPng)) {
+          success = true;
+        } else {
+          GlobalFree(hPng);
+        }
+      }
+    }
 
-    if (CreateStreamOnHGlobal(hMem, TRUE, &pStream) != S_OK) {
-      GlobalFree(hMem);
-      GdiplusShutdown(gdiplusToken);
-      return false;
+    if (success) {
+      // The DIB needs a full decode; only do it if a consumer asks for it
+      DelayRender(CF_DIBV5, [this, payload] { return CreateDibV5FromImage(*payload); });
+    } else {
+      // Other encodings are decoded now so invalid input is reported
+      success = SetClipboardGlobal(CF_DIBV5, CreateDibV5FromImage(png_bytes));
     }
 
-    // Load image from stream
-    Bitmap* pBitmap = Bitmap::FromStream(pStream);
-    if (!pBitmap || pBitmap->GetLastStatus() != Ok) {
-      pStream->Release();
-      GdiplusShutdown(gdiplusToken);
-      if (pBitmap) delete pBitmap;
-      return false;
+    return success;
+  }
+
+  // Places |text| as CF_UNICODETEXT. Large text is registered for delayed
+  // rendering and only converted to UTF-16 if a consumer asks for it; until
+  // then the call's own buffer is the only copy.
+  void SetClipboardText(std::shared_ptr<const std::string> text) {
+    if (text->size() < kDelayedTextThreshold) {
+      SetClipboardGlobal(CF_UNICODETEXT, CreateUnicodeTextGlobal(*text));
+      return;
     }
+    DelayRender(CF_UNICODETEXT, [text] { return CreateUnicodeTextGlobal(*text); });
+  }
 
-    // Get bitmap dimensions
-    int width = pBitmap->GetWidth();
-    int height = pBitmap->GetHeight();
+  // Registers |html| as delayed-rendered "HTML Format".
+  void SetClipboardHtml(std::shared_ptr<const std::string> html) {
+    UINT cf_html = RegisterClipboardFormatA("HTML Format");
+    if (cf_html == 0) {
+      return;
+    }
+    DelayRender(cf_html, [html] { return CreateHtmlFormatGlobal(*html); });
+  }
 
-    // Create DIB compatible with clipboard
-    BITMAPINFOHEADER bih = {0};
-    bih.biSize = sizeof(BITMAPINFOHEADER);
-    bih.biWidth = width;
-    bih.biHeight = -height; // Negative for top-down DIB
-    bih.biPlanes = 1;
-    bih.biBitCount = 32;
-    bih.biCompression = BI_RGB;
+  // Transcodes |text| to NUL-terminated UTF-16 directly in the clipboard
+  // allocation.
+  static HGLOBAL CreateUnicodeTextGlobal(const std::string& text) {
+    size_t units = clipboard::Utf16LengthOfUtf8(text.data(), text.size());
+    HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, (units + 1) * sizeof(wchar_t));
+    if (!hMem) {
+      return nullptr;
+    }
+    char16_t* pMem = static_cast<char16_t*>(GlobalLock(hMem));
+    if (!pMem) {
+      GlobalFree(hMem);
+      return nullptr;
+    }
+    clipboard::Utf8ToUtf16(text.data(), text.size(), pMem);
+    pMem[units] = u'\0';
+    GlobalUnlock(hMem);
+    return hMem;
+  }
 
-    int rowSize = ((width * 32 + 31) / 32) * 4; // DWORD-aligned
-    DWORD imageSize = rowSize * height;
+  // Encodes |html| as CF_HTML straight into the clipboard allocation.
+  static HGLOBAL CreateHtmlFormatGlobal(const std::string& html) {
+    HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, clipboard::CfHtmlEncodedSize(html.size()) + 1);
+    if (!hMem) {
+      return nullptr;
+    }
+    char* pMem = static_cast<char*>(GlobalLock(hMem));
+    if (!pMem) {
+      GlobalFree(hMem);
+      return nullptr;
+    }
+    clipboard::WriteCfHtml(html.data(), html.size(), pMem);
+    GlobalUnlock(hMem);
+    return hMem;
+  }
 
-    // Allocate memory for DIB
-    HGLOBAL hDib = GlobalAlloc(GMEM_MOVEABLE, sizeof(BITMAPINFOHEADER) + imageSize);
-    if (!hDib) {
-      delete pBitmap;
-      pStream->Release();
-      GdiplusShutdown(gdiplusToken);
+  // Hands |hMem| to the open clipboard, freeing it if the clipboard refuses.
+  static bool SetClipboardGlobal(UINT format, HGLOBAL hMem) {
+    if (!hMem) {
       return false;
     }
-
-    BYTE* pDib = (BYTE*)GlobalLock(hDib);
-    if (!pDib) {
-      GlobalFree(hDib);
-      delete pBitmap;
-      pStream->Release();
-      GdiplusShutdown(gdiplusToken);
+    if (!SetClipboardData(format, hMem)) {
+      GlobalFree(hMem);
       return false;
     }
+    return true;
+  }
 
-    // Copy BITMAPINFOHEADER
-    memcpy(pDib, &bih, sizeof(BITMAPINFOHEADER));
-    BYTE* pBits = pDib + sizeof(BITMAPINFOHEADER);
+  // Registers |format| on the open clipboard without data. |render| produces
+  // it when another application requests it (WM_RENDERFORMAT) or before the
+  // owner window goes away (WM_RENDERALLFORMATS). Must be called after
+  // EmptyClipboard, which drops the previous owner's pending renders.
+  void DelayRender(UINT format, std::function<HGLOBAL()> render) {
+    if (!owner_window_) {
+      SetClipboardGlobal(format, render());
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(delayed_renders_mutex_);
+      delayed_renders_[format] = std::move(render);
+    }
+    SetClipboardData(format, nullptr);
+  }
 
-    // Lock bitmap bits and copy pixel data
-    BitmapData bitmapData;
-    Rect rect(0, 0, width, height);
-    
-    if (pBitmap->LockBits(&rect, ImageLockModeRead, PixelFormat32bppARGB, &bitmapData) == Ok) {
-      BYTE* pSource = (BYTE*)bitmapData.Scan0;
-      
-      for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-          // GDI+ uses BGRA format, DIB needs BGRA too, but we need to handle alpha
-          BYTE b = pSource[y * bitmapData.Stride + x * 4 + 0];
-          BYTE g = pSource[y * bitmapData.Stride + x * 4 + 1];
-          BYTE r = pSource[y * bitmapData.Stride + x * 4 + 2];
-          BYTE a = pSource[y * bitmapData.Stride + x * 4 + 3];
-          
-          // Copy to DIB (BGRA format)
-          pBits[y * rowSize + x * 4 + 0] = b;
-          pBits[y * rowSize + x * 4 + 1] = g;
-          pBits[y * rowSize + x * 4 + 2] = r;
-          pBits[y * rowSize + x * 4 + 3] = a;
+  // Handles messages for the owner window. Runs on the clipboard worker
+  // thread, so rendering and change notifications never block the UI.
+  bool HandleOwnerMessage(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam,
+                          LRESULT* result) {
+    switch (message) {
+      case WM_RENDERFORMAT:
+        // The clipboard is already open on behalf of the requesting app
+        RenderDelayedFormat(static_cast<UINT>(wparam));
+        break;
+      case WM_RENDERALLFORMATS: {
+        clipboard::ClipboardSession session(hwnd, &clipboard_lock_);
+        if (session.is_open() && GetClipboardOwner() == hwnd) {
+          RenderAllDelayedFormats();
         }
+        break;
       }
-      
-      pBitmap->UnlockBits(&bitmapData);
-    } else {
-      GlobalUnlock(hDib);
-      GlobalFree(hDib);
+      case WM_DESTROYCLIPBOARD: {
+        std::lock_guard<std::mutex> lock(delayed_renders_mutex_);
+        delayed_renders_.clear();
+        break;
+      }
+      case WM_CLIPBOARDUPDATE:
+        OnClipboardChanged();
+        break;
+      case WM_TIMER:
+        if (wparam != kCoalesceTimerId) {
+          return false;
+        }
+        OnCoalesceTimer();
+        break;
+      default:
+        return false;
+    }
+    *result = 0;
+    return true;
+  }
+
+  void RenderDelayedFormat(UINT format) {
+    std::function<HGLOBAL()> render;
+    {
+      std::lock_guard<std::mutex> lock(delayed_renders_mutex_);
+      auto it = delayed_renders_.find(format);
+      if (it == delayed_renders_.end()) {
+        return;
+      }
+      render = std::move(it->second);
+      delayed_renders_.erase(it);
+    }
+    SetClipboardGlobal(format, render());
+  }
+
+  void RenderAllDelayedFormats() {
+    std::map<UINT, std::function<HGLOBAL()>> renders;
+    {
+      std::lock_guard<std::mutex> lock(delayed_renders_mutex_);
+      renders.swap(delayed_renders_);
+    }
+    for (auto& entry : renders) {
+      SetClipboardGlobal(entry.first, entry.second());
+    }
+  }
+
+  bool HasDelayedRender(UINT format) {
+    std::lock_guard<std::mutex> lock(delayed_renders_mutex_);
+    return delayed_renders_.count(format) != 0;
+  }
+
+  static bool IsPngSignature(const std::vector<uint8_t>& bytes) {
+    static const uint8_t kPngSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    return bytes.size() >= sizeof(kPngSignature) &&
+           memcmp(bytes.data(), kPngSignature, sizeof(kPngSignature)) == 0;
+  }
+
+  // Copies |size| bytes into a new movable global block for SetClipboardData.
+  static HGLOBAL CreateGlobalFromBytes(const void* data, size_t size) {
+    HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, size);
+    if (!hMem) {
+      return nullptr;
+    }
+    void* pMem = GlobalLock(hMem);
+    if (!pMem) {
+      GlobalFree(hMem);
+      return nullptr;
+    }
+    memcpy(pMem, data, size);
+    GlobalUnlock(hMem);
+    return hMem;
+  }
+
+  // Decodes an encoded image into a bottom-up 32bpp CF_DIBV5 with straight
+  // alpha. Returns nullptr if the image cannot be decoded.
+  HGLOBAL CreateDibV5FromImage(const std::vector<uint8_t>& image_bytes) {
+    if (!gdiplus_.EnsureStarted()) {
+      return nullptr;
+    }
+
+    // Create IStream from the encoded bytes
+    HGLOBAL hMem = CreateGlobalFromBytes(image_bytes.data(), image_bytes.size());
+    if (!hMem) {
+      return nullptr;
+    }
+
+    IStream* pStream = nullptr;
+    if (CreateStreamOnHGlobal(hMem, TRUE, &pStream) != S_OK) {
+      GlobalFree(hMem);
+      return nullptr;
+    }
+
+    // Load image from stream
+    Bitmap* pBitmap = Bitmap::FromStream(pStream);
+    if (!pBitmap || pBitmap->GetLastStatus() != Ok) {
+      pStream->Release();
+      if (pBitmap) delete pBitmap;
+      return nullptr;
+    }
+
+    // Get bitmap dimensions
+    int width = pBitmap->GetWidth();
+    int height = pBitmap->GetHeight();
+    if (width <= 0 || height <= 0) {
       delete pBitmap;
       pStream->Release();
-      GdiplusShutdown(gdiplusToken);
-      return false;
+      return nullptr;
+    }
+    int rowSize = width * 4;
+    DWORD imageSize = static_cast<DWORD>(rowSize) * static_cast<DWORD>(height);
+
+    BITMAPV5HEADER bih = {0};
+    bih.bV5Size = sizeof(BITMAPV5HEADER);
+    bih.bV5Width = width;
+    bih.bV5Height = height;  // Bottom-up; the most widely understood layout
+    bih.bV5Planes = 1;
+    bih.bV5BitCount = 32;
+    bih.bV5Compression = BI_BITFIELDS;
+    bih.bV5SizeImage = imageSize;
+    bih.bV5RedMask = 0x00FF0000;
+    bih.bV5GreenMask = 0x0000FF00;
+    bih.bV5BlueMask = 0x000000FF;
+    bih.bV5AlphaMask = 0xFF000000;
+    bih.bV5CSType = LCS_sRGB;
+    bih.bV5Intent = LCS_GM_IMAGES;
+
+    HGLOBAL hDib = GlobalAlloc(GMEM_MOVEABLE, sizeof(BITMAPV5HEADER) + imageSize);
+    if (!hDib) {
+      delete pBitmap;
+      pStream->Release();
+      return nullptr;
     }
 
-    GlobalUnlock(hDib);
+    BYTE* pDib = (BYTE*)GlobalLock(hDib);
+    if (!pDib) {
+      GlobalFree(hDib);
+      delete pBitmap;
+      pStream->Release();
+      return nullptr;
+    }
 
-    // Set clipboard data
-    bool success = (SetClipboardData(CF_DIB, hDib) != NULL);
+    memcpy(pDib, &bih, sizeof(BITMAPV5HEADER));
+    BYTE* pBits = pDib + sizeof(BITMAPV5HEADER);
 
-    // Cleanup
+    // Lock bitmap bits and copy pixel data
+    BitmapData bitmapData;
+    Rect rect(0, 0, width, height);
+    bool copied = false;
+    if (pBitmap->LockBits(&rect, ImageLockModeRead, PixelFormat32bppARGB, &bitmapData) == Ok) {
+      // GDI+ and the DIB are both straight-alpha BGRA; writing through a
+      // negative stride flips the top-down source into the bottom-up DIB
+      clipboard::PixelConvertOptions options;
+      options.thread_pool = GetThreadPool();
+      clipboard::ConvertPixelRows(static_cast<const uint8_t*>(bitmapData.Scan0),
+                                  bitmapData.Stride,
+                                  pBits + static_cast<size_t>(rowSize) * (height - 1),
+                                  -rowSize, width, height, options);
+      pBitmap->UnlockBits(&bitmapData);
+      copied = true;
+    }
+
+    GlobalUnlock(hDib);
     delete pBitmap;
     pStream->Release();
-    GdiplusShutdown(gdiplusToken);
 
-    return success;
+    if (!copied) {
+      GlobalFree(hDib);
+      return nullptr;
+    }
+    return hDib;
   }
 
-  void HandlePaste(std::unique_ptr<flutter::MethodResult<EncodableValue>> result) {
-    if (OpenClipboard(nullptr)) {
-      if (IsClipboardFormatAvailable(CF_UNICODETEXT)) {
-        HGLOBAL hMem = GetClipboardData(CF_UNICODETEXT);
-        if (hMem) {
-          wchar_t* pMem = (wchar_t*)GlobalLock(hMem);
-          int size_needed = WideCharToMultiByte(CP_UTF8, 0, pMem, -1, NULL, 0, NULL, NULL);
-          std::vector<char> str(size_needed);
-          WideCharToMultiByte(CP_UTF8, 0, pMem, -1, &str[0], size_needed, NULL, NULL);
-          GlobalUnlock(hMem);
-          
-          EncodableMap result_map;
-          result_map[EncodableValue("text")] = EncodableValue(std::string(&str[0]));
-          result->Success(EncodableValue(result_map));
-        } else {
-          result->Success(EncodableValue(EncodableMap{{EncodableValue("text"), EncodableValue("")}}));
+  void HandlePaste(OperationResult* result) {
+    DWORD sequence = GetClipboardSequenceNumber();
+    if (auto cached = paste_cache_.Find(sequence, "paste")) {
+      result->Success(cached);
+      return;
+    }
+
+    clipboard::ClipboardSession session(nullptr, &clipboard_lock_, AcquireOptions());
+    if (session.is_open()) {
+      std::string text = ReadClipboardText();
+      session.Close();
+      size_t size = text.size();
+      auto value = CachePasteResult(
+          sequence, "paste",
+          EncodableValue(EncodableMap{{EncodableValue("text"), EncodableValue(std::move(text))}}),
+          size);
+      result->Success(value);
+    } else {
+      ReportOpenFailure(result, "PASTE_ERROR", session);
+    }
+  }
+
+  void HandlePasteRichText(OperationResult* result) {
+    DWORD sequence = GetClipboardSequenceNumber();
+    if (auto cached = paste_cache_.Find(sequence, "pasteRichText")) {
+      result->Success(cached);
+      return;
+    }
+
+    clipboard::ClipboardSession session(nullptr, &clipboard_lock_, AcquireOptions());
+    if (session.is_open()) {
+      EncodableMap result_map = ReadRichTextMap();
+      session.Close();
+      size_t size = 0;
+      for (const auto& entry : result_map) {
+        if (const auto* str = std::get_if<std::string>(&entry.second)) {
+          size += str->size();
+        } else if (const auto* list = std::get_if<EncodableList>(&entry.second)) {
+          for (const auto& item : *list) {
+            if (const auto* path = std::get_if<std::string>(&item)) {
+              size += path->size();
+            }
+          }
         }
-      } else {
-        result->Success(EncodableValue(EncodableMap{{EncodableValue("text"), EncodableValue("")}}));
       }
-      CloseClipboard();
+      auto value = CachePasteResult(sequence, "pasteRichText",
+                                    EncodableValue(std::move(result_map)), size);
+      result->Success(value);
     } else {
-      result->Error("PASTE_ERROR", "Failed to open clipboard");
+      ReportOpenFailure(result, "PASTE_RICH_ERROR", session);
     }
   }
 
-  void HandlePasteRichText(std::unique_ptr<flutter::MethodResult<EncodableValue>> result) {
-    EncodableMap result_map;
-    
-    if (OpenClipboard(nullptr)) {
-      // Get text
-      std::string text;
-      if (IsClipboardFormatAvailable(CF_UNICODETEXT)) {
-        HGLOBAL hMem = GetClipboardData(CF_UNICODETEXT);
-        if (hMem) {
-          wchar_t* pMem = (wchar_t*)GlobalLock(hMem);
-          int size_needed = WideCharToMultiByte(CP_UTF8, 0, pMem, -1, NULL, 0, NULL, NULL);
-          std::vector<char> str(size_needed);
-          WideCharToMultiByte(CP_UTF8, 0, pMem, -1, &str[0], size_needed, NULL, NULL);
+  // Every format in one session, so the parts cannot come from different
+  // copies: text, HTML, files, the content hash, the format list and the
+  // image's bytes are copied, then the clipboard is released before the
+  // image is decoded and encoded as pasteImage does. customData carries the
+  // sequence number and the format sizes.
+  void HandlePasteAll(OperationResult* result) {
+    DWORD sequence = GetClipboardSequenceNumber();
+    if (auto cached = paste_cache_.Find(sequence, "pasteAll")) {
+      result->Success(cached);
+      return;
+    }
+
+    clipboard::ClipboardSession session(nullptr, &clipboard_lock_, AcquireOptions());
+    if (!session.is_open()) {
+      ReportOpenFailure(result, "PASTE_ALL_ERROR", session);
+      return;
+    }
+    // Cannot change while the clipboard is open
+    sequence = GetClipboardSequenceNumber();
+    clipboard::ClipboardContent content = ReadClipboardContent();
+    const ContentDigest digest = ReadContentDigest();
+    std::vector<ClipboardFormatInfo> formats = ProbeClipboardFormats();
+    CapturedImage capture;
+    CaptureClipboardImage(true, &capture);
+    session.Close();
+    const char* image_error = nullptr;
+    EncodeCapturedImage(&capture, &content.image_png, &image_error);
+
+    size_t size = content.text.size() + content.html.size() + content.source_url.size() +
+                  content.image_png.size();
+    for (const auto& path : content.file_paths) {
+      size += path.size();
+    }
+    EncodableMap format_sizes;
+    for (const auto& format : formats) {
+      format_sizes[EncodableValue(format.name)] = EncodableValue(format.size);
+    }
+    EncodableMap custom_data;
+    custom_data[EncodableValue("sequenceNumber")] = EncodableValue(static_cast<int64_t>(sequence));
+    custom_data[EncodableValue("formatSizes")] = EncodableValue(std::move(format_sizes));
+
+    EncodableMap result_map = ContentMap(std::move(content), CurrentTimeMillis());
+    result_map[EncodableValue("contentHash")] =
+        EncodableValue(static_cast<int64_t>(digest.combined()));
+    result_map[EncodableValue("customData")] = EncodableValue(std::move(custom_data));
+    auto value = CachePasteResult(sequence, "pasteAll", EncodableValue(std::move(result_map)),
+                                  size);
+    result->Success(value);
+  }
+
+  // Paths from CF_HDROP with sizes from the file system's attributes; file
+  // contents are never opened. Not cached, since the files can change
+  // while the clipboard does not.
+  void HandlePasteFiles(OperationResult* result) {
+    clipboard::ClipboardSession session(nullptr, &clipboard_lock_, AcquireOptions());
+    if (!session.is_open()) {
+      ReportOpenFailure(result, "PASTE_FILES_ERROR", session);
+      return;
+    }
+    std::vector<std::wstring> paths;
+    ReadClipboardFileList(&paths);
+    session.Close();
+
+    EncodableList utf8_paths;
+    utf8_paths.reserve(paths.size());
+    // -1 where the attributes cannot be read; directories report 0
+    std::vector<int64_t> sizes;
+    sizes.reserve(paths.size());
+    std::vector<uint8_t> directories;
+    directories.reserve(paths.size());
+    for (const auto& path : paths) {
+      utf8_paths.emplace_back(WideToUtf8(path));
+      WIN32_FILE_ATTRIBUTE_DATA attributes;
+      if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &attributes)) {
+        sizes.push_back(-1);
+        directories.push_back(0);
+      } else if (attributes.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+        sizes.push_back(0);
+        directories.push_back(1);
+      } else {
+        ULARGE_INTEGER size;
+        size.LowPart = attributes.nFileSizeLow;
+        size.HighPart = attributes.nFileSizeHigh;
+        sizes.push_back(static_cast<int64_t>(size.QuadPart));
+        directories.push_back(0);
+      }
+    }
+    result->Success(EncodableValue(EncodableMap{
+        {EncodableValue("paths"), EncodableValue(std::move(utf8_paths))},
+        {EncodableValue("sizes"), EncodableValue(std::move(sizes))},
+        {EncodableValue("directories"), EncodableValue(std::move(directories))},
+    }));
+  }
+
+  // Caches |value| under |sequence| unless the clipboard changed while the
+  // result was being produced. Returns the (possibly uncached) result.
+  std::shared_ptr<const EncodableValue> CachePasteResult(DWORD sequence, const std::string& key,
+                                                         EncodableValue value, size_t size_bytes) {
+    if (GetClipboardSequenceNumber() != sequence) {
+      sequence = 0;
+    }
+    return paste_cache_.Store(sequence, key, std::move(value), size_bytes);
+  }
+
+  void HandleGetPasteCacheStats(OperationResult* result) {
+    clipboard::PasteCacheStats stats = paste_cache_.stats();
+    result->Success(EncodableValue(EncodableMap{
+        {EncodableValue("hits"), EncodableValue(static_cast<int64_t>(stats.hits))},
+        {EncodableValue("misses"), EncodableValue(static_cast<int64_t>(stats.misses))},
+        {EncodableValue("entries"), EncodableValue(static_cast<int64_t>(stats.entries))},
+        {EncodableValue("bytes"), EncodableValue(static_cast<int64_t>(stats.bytes))},
+    }));
+  }
+
+  void HandleGetClipboardLockStats(OperationResult* result) {
+    clipboard::ClipboardLockStats stats = clipboard_lock_.stats();
+    result->Success(EncodableValue(EncodableMap{
+        {EncodableValue("acquisitions"), EncodableValue(static_cast<int64_t>(stats.acquisitions))},
+        {EncodableValue("failures"), EncodableValue(static_cast<int64_t>(stats.failures))},
+        {EncodableValue("contended"), EncodableValue(static_cast<int64_t>(stats.contended))},
+        {EncodableValue("attempts"), EncodableValue(static_cast<int64_t>(stats.attempts))},
+        {EncodableValue("waitMicros"), EncodableValue(static_cast<int64_t>(stats.wait_micros))},
+        {EncodableValue("maxWaitMicros"), EncodableValue(static_cast<int64_t>(stats.max_wait_micros))},
+        {EncodableValue("holdMicros"), EncodableValue(static_cast<int64_t>(stats.hold_micros))},
+        {EncodableValue("maxHoldMicros"), EncodableValue(static_cast<int64_t>(stats.max_hold_micros))},
+    }));
+  }
+
+  // Updates the acquisition policy; omitted fields keep their value.
+  void HandleSetClipboardLockOptions(const EncodableMap* arguments, OperationResult* result) {
+    if (!arguments) {
+      result->Error("INVALID_ARGUMENT", "Arguments are required");
+      return;
+    }
+    clipboard::ClipboardAcquireOptions options = clipboard_lock_.options();
+    auto read_millis = [arguments](const char* key, uint32_t* value) {
+      auto it = arguments->find(EncodableValue(key));
+      if (it == arguments->end()) {
+        return true;
+      }
+      int64_t millis = -1;
+      if (const auto* millis32 = std::get_if<int32_t>(&it->second)) {
+        millis = *millis32;
+      } else if (const auto* millis64 = std::get_if<int64_t>(&it->second)) {
+        millis = *millis64;
+      }
+      if (millis < 0 || millis > 60000) {
+        return false;
+      }
+      *value = static_cast<uint32_t>(millis);
+      return true;
+    };
+    if (!read_millis("timeoutMs", &options.timeout_ms) ||
+        !read_millis("initialBackoffMs", &options.initial_backoff_ms) ||
+        !read_millis("maxBackoffMs", &options.max_backoff_ms)) {
+      result->Error("INVALID_ARGUMENT", "Durations must be between 0 and 60000 ms");
+      return;
+    }
+    // A zero cap would turn the backoff into a busy loop
+    options.max_backoff_ms = std::max<uint32_t>(options.max_backoff_ms, 1);
+    clipboard_lock_.set_options(options);
+    result->Success(EncodableValue(true));
+  }
+
+  // Updates change event throttling; omitted fields keep their value. A
+  // new debounce window applies from the next one opened.
+  void HandleSetMonitoringOptions(const EncodableMap* arguments, OperationResult* result) {
+    if (!arguments) {
+      result->Error("INVALID_ARGUMENT", "Arguments are required");
+      return;
+    }
+    int64_t debounce_ms = monitoring_debounce_ms_;
+    int64_t max_queued = static_cast<int64_t>(event_queue_.capacity());
+    if (!ReadOptionalInt(*arguments, "debounceMs", &debounce_ms) ||
+        !ReadOptionalInt(*arguments, "maxQueuedEvents", &max_queued)) {
+      result->Error("INVALID_ARGUMENT", "debounceMs and maxQueuedEvents must be integers");
+      return;
+    }
+    if (debounce_ms < 0 || debounce_ms > 60000) {
+      result->Error("INVALID_ARGUMENT", "debounceMs must be between 0 and 60000");
+      return;
+    }
+    if (max_queued < 1 || max_queued > kMaxQueuedEvents) {
+      result->Error("INVALID_ARGUMENT", "maxQueuedEvents must be between 1 and 1024");
+      return;
+    }
+    monitoring_debounce_ms_ = static_cast<UINT>(debounce_ms);
+    event_queue_.SetCapacity(static_cast<size_t>(max_queued));
+    result->Success(EncodableValue(true));
+  }
+
+  void HandleGetMonitoringStats(OperationResult* result) {
+    clipboard::EventQueueStats queue = event_queue_.stats();
+    result->Success(EncodableValue(EncodableMap{
+        {EncodableValue("received"), EncodableValue(static_cast<int64_t>(changes_received_))},
+        {EncodableValue("coalesced"), EncodableValue(static_cast<int64_t>(changes_coalesced_))},
+        {EncodableValue("filtered"), EncodableValue(static_cast<int64_t>(changes_filtered_))},
+        {EncodableValue("delivered"), EncodableValue(static_cast<int64_t>(events_delivered_))},
+        {EncodableValue("dropped"), EncodableValue(static_cast<int64_t>(queue.dropped))},
+        {EncodableValue("queued"), EncodableValue(static_cast<int64_t>(queue.pending))},
+    }));
+  }
+
+  void HandleSetImageEncodingOptions(const EncodableMap* arguments, OperationResult* result) {
+    if (!arguments) {
+      result->Error("INVALID_ARGUMENT", "Arguments are required");
+      return;
+    }
+    auto it = arguments->find(EncodableValue("threads"));
+    if (it != arguments->end()) {
+      int64_t threads = -1;
+      if (const auto* threads32 = std::get_if<int32_t>(&it->second)) {
+        threads = *threads32;
+      } else if (const auto* threads64 = std::get_if<int64_t>(&it->second)) {
+        threads = *threads64;
+      }
+      if (threads < 0 || threads > kMaxEncodeThreads) {
+        result->Error("INVALID_ARGUMENT", "threads must be between 0 and 64");
+        return;
+      }
+      image_encode_threads_ = static_cast<uint32_t>(threads);
+    }
+    result->Success(EncodableValue(true));
+  }
+
+  // Configures and enables the native history. Recording needs the
+  // clipboard listener, which stays registered while history is on.
+  void HandleSetHistoryOptions(const EncodableMap* arguments, OperationResult* result) {
+    if (!arguments) {
+      result->Error("INVALID_ARGUMENT", "Arguments are required");
+      return;
+    }
+    int64_t max_bytes = static_cast<int64_t>(history_max_bytes_);
+    int64_t max_entries = static_cast<int64_t>(history_max_entries_);
+    if (!ReadOptionalInt(*arguments, "maxBytes", &max_bytes) || max_bytes < 0 ||
+        !ReadOptionalInt(*arguments, "maxEntries", &max_entries) || max_entries < 0) {
+      result->Error("INVALID_ARGUMENT", "maxBytes and maxEntries must be non-negative integers");
+      return;
+    }
+    history_max_bytes_ = static_cast<size_t>(max_bytes);
+    history_max_entries_ = static_cast<size_t>(max_entries);
+    history_.SetLimits(history_max_bytes_, history_max_entries_);
+
+    auto enabled_it = arguments->find(EncodableValue("enabled"));
+    if (enabled_it != arguments->end() && !enabled_it->second.IsNull()) {
+      const auto* enabled = std::get_if<bool>(&enabled_it->second);
+      if (!enabled) {
+        result->Error("INVALID_ARGUMENT", "enabled must be a bool");
+        return;
+      }
+      if (*enabled) {
+        history_enabled_ = true;
+        if (!StartMonitoring()) {
+          history_enabled_ = false;
+          result->Error("MONITORING_ERROR", "Failed to register clipboard format listener");
+          return;
+        }
+      } else {
+        history_enabled_ = false;
+        if (!has_event_listener_) {
+          StopMonitoring();
+        }
+      }
+    }
+    result->Success(EncodableValue(true));
+  }
+
+  // One page of history summaries, newest first. Only a short text
+  // preview crosses the channel; getHistoryItem returns full payloads.
+  void HandleGetHistory(const EncodableMap* arguments, OperationResult* result) {
+    int64_t offset = 0;
+    int64_t limit = kDefaultHistoryPageSize;
+    if (arguments && (!ReadOptionalInt(*arguments, "offset", &offset) ||
+                      !ReadOptionalInt(*arguments, "limit", &limit))) {
+      result->Error("INVALID_ARGUMENT", "offset and limit must be integers");
+      return;
+    }
+    if (offset < 0 || limit < 0) {
+      result->Error("INVALID_ARGUMENT", "offset and limit must not be negative");
+      return;
+    }
+    std::vector<clipboard::HistoryRecord> page =
+        history_.Page(static_cast<size_t>(offset), static_cast<size_t>(limit));
+    EncodableList items;
+    items.reserve(page.size());
+    for (const auto& record : page) {
+      const clipboard::ClipboardContent& content = *record.content;
+      items.emplace_back(EncodableMap{
+          {EncodableValue("id"), EncodableValue(static_cast<int64_t>(record.id))},
+          {EncodableValue("timestamp"), EncodableValue(record.timestamp_ms)},
+          {EncodableValue("sizeBytes"), EncodableValue(static_cast<int64_t>(record.size_bytes))},
+          {EncodableValue("textPreview"), EncodableValue(TextPreview(content.text))},
+          {EncodableValue("hasHtml"), EncodableValue(!content.html.empty())},
+          {EncodableValue("imageSize"),
+           EncodableValue(static_cast<int64_t>(content.image_png.size()))},
+          {EncodableValue("fileCount"),
+           EncodableValue(static_cast<int64_t>(content.file_paths.size()))},
+      });
+    }
+    clipboard::ClipboardHistoryStats stats = history_.stats();
+    result->Success(EncodableValue(EncodableMap{
+        {EncodableValue("total"), EncodableValue(static_cast<int64_t>(stats.entries))},
+        {EncodableValue("bytes"), EncodableValue(static_cast<int64_t>(stats.bytes))},
+        {EncodableValue("items"), EncodableValue(std::move(items))},
+    }));
+  }
+
+  // The full entry in EnhancedClipboardData shape, or null once evicted.
+  void HandleGetHistoryItem(const EncodableMap* arguments, OperationResult* result) {
+    int64_t id = -1;
+    if (!arguments || !ReadOptionalInt(*arguments, "id", &id) || id < 0) {
+      result->Error("INVALID_ARGUMENT", "id must be a non-negative integer");
+      return;
+    }
+    clipboard::HistoryRecord record;
+    if (!history_.Find(static_cast<uint64_t>(id), &record)) {
+      result->Success(EncodableValue());
+      return;
+    }
+    EncodableMap item = ContentMap(*record.content, record.timestamp_ms);
+    item[EncodableValue("id")] = EncodableValue(id);
+    result->Success(EncodableValue(std::move(item)));
+  }
+
+  // Reads an int32 or int64 argument. Leaves |value| unchanged and returns
+  // true when |key| is absent or null.
+  static bool ReadOptionalInt(const EncodableMap& arguments, const char* key, int64_t* value) {
+    auto it = arguments.find(EncodableValue(key));
+    if (it == arguments.end() || it->second.IsNull()) {
+      return true;
+    }
+    return ReadInt(it->second, value);
+  }
+
+  // The codec sends small ints as int32 and larger ones as int64.
+  static bool ReadInt(const EncodableValue& encoded, int64_t* value) {
+    if (const auto* value32 = std::get_if<int32_t>(&encoded)) {
+      *value = *value32;
+      return true;
+    }
+    if (const auto* value64 = std::get_if<int64_t>(&encoded)) {
+      *value = *value64;
+      return true;
+    }
+    return false;
+  }
+
+  // The first kHistoryPreviewBytes of |text|, cut at a UTF-8 boundary.
+  static std::string TextPreview(const std::string& text) {
+    if (text.size() <= kHistoryPreviewBytes) {
+      return text;
+    }
+    size_t end = kHistoryPreviewBytes;
+    while (end > 0 && (static_cast<unsigned char>(text[end]) & 0xC0) == 0x80) {
+      end--;
+    }
+    return text.substr(0, end);
+  }
+
+  // Reads CF_UNICODETEXT as UTF-8 from the open clipboard, or "" if absent.
+  static std::string ReadClipboardText() {
+    std::string text;
+    if (IsClipboardFormatAvailable(CF_UNICODETEXT)) {
+      HGLOBAL hMem = GetClipboardData(CF_UNICODETEXT);
+      if (hMem) {
+        const wchar_t* pMem = static_cast<const wchar_t*>(GlobalLock(hMem));
+        if (pMem) {
+          // GlobalSize may be rounded up, so the terminator still ends the
+          // text, but the scan never runs past the allocation
+          size_t units = wcsnlen(pMem, GlobalSize(hMem) / sizeof(wchar_t));
+          const char16_t* utf16 = reinterpret_cast<const char16_t*>(pMem);
+          text.resize(clipboard::Utf8LengthOfUtf16(utf16, units));
+          clipboard::Utf16ToUtf8(utf16, units, &text[0]);
           GlobalUnlock(hMem);
-          text = std::string(&str[0]);
         }
       }
-      result_map[EncodableValue("text")] = EncodableValue(text);
+    }
+    return text;
+  }
 
-      // Get HTML
-      UINT cf_html = RegisterClipboardFormatA("HTML Format");
-      std::string html;
-      if (cf_html != 0 && IsClipboardFormatAvailable(cf_html)) {
-        HGLOBAL hMem = GetClipboardData(cf_html);
-        if (hMem) {
-          char* pMem = (char*)GlobalLock(hMem);
-          html = std::string(pMem);
+  // Reads the "HTML Format" fragment and source URL from the open
+  // clipboard; both are empty if absent. The read is bounded by GlobalSize.
+  // Payloads without a CF_HTML header are returned whole.
+  static clipboard::CfHtmlFragment ReadClipboardHtml() {
+    clipboard::CfHtmlFragment fragment;
+    UINT cf_html = RegisterClipboardFormatA("HTML Format");
+    if (cf_html != 0 && IsClipboardFormatAvailable(cf_html)) {
+      HGLOBAL hMem = GetClipboardData(cf_html);
+      if (hMem) {
+        const char* pMem = static_cast<const char*>(GlobalLock(hMem));
+        if (pMem) {
+          size_t size = GlobalSize(hMem);
+          if (!clipboard::DecodeCfHtml(pMem, size, &fragment)) {
+            fragment.html.assign(pMem, strnlen(pMem, size));
+          }
           GlobalUnlock(hMem);
         }
       }
-      result_map[EncodableValue("html")] = EncodableValue(html);
+    }
+    return fragment;
+  }
 
-      result_map[EncodableValue("timestamp")] = EncodableValue(static_cast<int64_t>(GetTickCount64()));
-      
-      CloseClipboard();
-      result->Success(EncodableValue(result_map));
+  // Copies the CF_HDROP path list out of the open clipboard. Returns false
+  // if there is none. Nothing is read from the files themselves.
+  static bool ReadClipboardFileList(std::vector<std::wstring>* paths) {
+    if (!IsClipboardFormatAvailable(CF_HDROP)) {
+      return false;
+    }
+    HGLOBAL hDrop = GetClipboardData(CF_HDROP);
+    if (!hDrop) {
+      return false;
+    }
+    const uint8_t* data = static_cast<const uint8_t*>(GlobalLock(hDrop));
+    if (!data) {
+      return false;
+    }
+    std::vector<std::u16string_view> views;
+    if (clipboard::ParseDropFiles(data, GlobalSize(hDrop), &views)) {
+      paths->reserve(views.size());
+      for (const auto& view : views) {
+        paths->emplace_back(reinterpret_cast<const wchar_t*>(view.data()), view.size());
+      }
     } else {
-      result->Error("PASTE_RICH_ERROR", "Failed to open clipboard");
+      // ANSI lists are left to the shell, which knows their code page
+      HDROP drop = static_cast<HDROP>(hDrop);
+      UINT count = DragQueryFileW(drop, 0xFFFFFFFF, nullptr, 0);
+      for (UINT i = 0; i < count; i++) {
+        UINT length = DragQueryFileW(drop, i, nullptr, 0);
+        std::wstring path(length, L'\0');
+        if (length > 0 && DragQueryFileW(drop, i, &path[0], length + 1) == length) {
+          paths->push_back(std::move(path));
+        }
+      }
     }
+    GlobalUnlock(hDrop);
+    return true;
+  }
+
+  static std::string WideToUtf8(const std::wstring& wide) {
+    const char16_t* utf16 = reinterpret_cast<const char16_t*>(wide.data());
+    std::string utf8(clipboard::Utf8LengthOfUtf16(utf16, wide.size()), '\0');
+    clipboard::Utf16ToUtf8(utf16, wide.size(), &utf8[0]);
+    return utf8;
   }
 
-  void HandlePasteImage(std::unique_ptr<flutter::MethodResult<EncodableValue>> result) {
+  // Text, HTML fragment, source URL and file paths from the open clipboard.
+  static clipboard::ClipboardContent ReadClipboardContent() {
+    clipboard::ClipboardContent content;
+    content.text = ReadClipboardText();
+    clipboard::CfHtmlFragment html = ReadClipboardHtml();
+    content.html = std::move(html.html);
+    content.source_url = std::move(html.source_url);
+    std::vector<std::wstring> paths;
+    if (ReadClipboardFileList(&paths)) {
+      content.file_paths.reserve(paths.size());
+      for (const auto& path : paths) {
+        content.file_paths.push_back(WideToUtf8(path));
+      }
+    }
+    return content;
+  }
+
+  // |content| in the shape EnhancedClipboardData.fromMap expects.
+  static EncodableMap ContentMap(clipboard::ClipboardContent content, int64_t timestamp_ms) {
     EncodableMap result_map;
-    
-    // Initialize GDI+
-    GdiplusStartupInput gdiplusStartupInput;
-    ULONG_PTR gdiplusToken;
-    GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, nullptr);
-
-    Bitmap* pBitmap = nullptr;
-    bool clipboardOpened = false;
-
-    // Try multiple approaches to get the image
-    // Method 1: Try CF_BITMAP (works for many apps)
-    if (!pBitmap && OpenClipboard(nullptr)) {
-      clipboardOpened = true;
-      if (IsClipboardFormatAvailable(CF_BITMAP)) {
-        HBITMAP hBitmap = (HBITMAP)GetClipboardData(CF_BITMAP);
-        if (hBitmap) {
-          // Create a copy of the bitmap before closing clipboard
-          HDC hdcScreen = GetDC(nullptr);
-          HDC hdcMem = CreateCompatibleDC(hdcScreen);
-          if (hdcMem) {
-            BITMAP bm;
-            GetObject(hBitmap, sizeof(BITMAP), &bm);
-            HBITMAP hBitmapCopy = CreateCompatibleBitmap(hdcScreen, bm.bmWidth, bm.bmHeight);
-            if (hBitmapCopy) {
-              SelectObject(hdcMem, hBitmapCopy);
-              HDC hdcSource = CreateCompatibleDC(hdcScreen);
-              if (hdcSource) {
-                SelectObject(hdcSource, hBitmap);
-                BitBlt(hdcMem, 0, 0, bm.bmWidth, bm.bmHeight, hdcSource, 0, 0, SRCCOPY);
-                DeleteDC(hdcSource);
-              }
-              // Close clipboard now that we have a copy
-              CloseClipboard();
-              clipboardOpened = false;
-              
-              pBitmap = Bitmap::FromHBITMAP(hBitmapCopy, nullptr);
-              DeleteObject(hBitmapCopy);
-              if (pBitmap && pBitmap->GetLastStatus() != Ok) {
-                delete pBitmap;
-                pBitmap = nullptr;
-              }
-            }
-            DeleteDC(hdcMem);
-          }
-          ReleaseDC(nullptr, hdcScreen);
+    result_map[EncodableValue("text")] = EncodableValue(std::move(content.text));
+    result_map[EncodableValue("html")] = EncodableValue(std::move(content.html));
+    if (!content.source_url.empty()) {
+      result_map[EncodableValue("sourceUrl")] = EncodableValue(std::move(content.source_url));
+    }
+    if (!content.image_png.empty()) {
+      result_map[EncodableValue("imageBytes")] = EncodableValue(std::move(content.image_png));
+    }
+    if (!content.file_paths.empty()) {
+      EncodableList file_paths;
+      file_paths.reserve(content.file_paths.size());
+      for (auto& path : content.file_paths) {
+        file_paths.emplace_back(std::move(path));
+      }
+      result_map[EncodableValue("filePaths")] = EncodableValue(std::move(file_paths));
+    }
+    result_map[EncodableValue("timestamp")] = EncodableValue(timestamp_ms);
+    return result_map;
+  }
+
+  // Rich text for pasteRichText and change events. The clipboard must be
+  // open.
+  static EncodableMap ReadRichTextMap() {
+    return ContentMap(ReadClipboardContent(), CurrentTimeMillis());
+  }
+
+  // Milliseconds since the Unix epoch, matching DateTime.fromMillisecondsSinceEpoch.
+  static int64_t CurrentTimeMillis() {
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    ULARGE_INTEGER ticks;
+    ticks.LowPart = now.dwLowDateTime;
+    ticks.HighPart = now.dwHighDateTime;
+    // FILETIME counts 100ns intervals since 1601-01-01
+    return static_cast<int64_t>((ticks.QuadPart - 116444736000000000ULL) / 10000);
+  }
+
+  // Starts delivering WM_CLIPBOARDUPDATE to the owner window.
+  bool StartMonitoring() {
+    if (monitoring_) {
+      return true;
+    }
+    if (!owner_window_ || !AddClipboardFormatListener(owner_window_)) {
+      return false;
+    }
+    monitoring_ = true;
+    return true;
+  }
+
+  // Keeps listening while history is recording.
+  void StopMonitoring() {
+    if (monitoring_ && !history_enabled_) {
+      RemoveClipboardFormatListener(owner_window_);
+      monitoring_ = false;
+      if (coalescing_) {
+        KillTimer(owner_window_, kCoalesceTimerId);
+        coalescing_ = false;
+        change_pending_ = false;
+      }
+    }
+  }
+
+  // Throttles WM_CLIPBOARDUPDATE to one OnClipboardUpdate per debounce
+  // window. A change after a quiet period is handled right away and opens a
+  // window; changes inside it are merged into a single update when it
+  // closes, which reads the clipboard as it is by then.
+  void OnClipboardChanged() {
+    changes_received_++;
+    const UINT debounce_ms = monitoring_debounce_ms_;
+    if (coalescing_) {
+      if (change_pending_) {
+        changes_coalesced_++;
+      }
+      change_pending_ = true;
+      return;
+    }
+    update_retries_ = 0;
+    if (OnClipboardUpdate()) {
+      if (debounce_ms > 0 && SetTimer(owner_window_, kCoalesceTimerId, debounce_ms, nullptr)) {
+        coalescing_ = true;
+      }
+    } else if (SetTimer(owner_window_, kCoalesceTimerId, RetryDelay(debounce_ms), nullptr)) {
+      coalescing_ = true;
+      change_pending_ = true;
+    }
+  }
+
+  // End of a debounce window: handles the changes it merged and opens the
+  // next window, or goes quiet if there were none. While another process
+  // keeps the clipboard busy, the update is retried a window later, up to
+  // kMaxUpdateRetries times in a row.
+  void OnCoalesceTimer() {
+    if (!change_pending_) {
+      KillTimer(owner_window_, kCoalesceTimerId);
+      coalescing_ = false;
+      return;
+    }
+    const UINT debounce_ms = monitoring_debounce_ms_;
+    if (!OnClipboardUpdate() && ++update_retries_ < kMaxUpdateRetries) {
+      SetTimer(owner_window_, kCoalesceTimerId, RetryDelay(debounce_ms), nullptr);
+      return;
+    }
+    change_pending_ = false;
+    update_retries_ = 0;
+    if (debounce_ms == 0) {
+      KillTimer(owner_window_, kCoalesceTimerId);
+      coalescing_ = false;
+    } else {
+      SetTimer(owner_window_, kCoalesceTimerId, debounce_ms, nullptr);
+    }
+  }
+
+  // Delay before retrying an update that found the clipboard busy.
+  static UINT RetryDelay(UINT debounce_ms) {
+    return debounce_ms > 0 ? debounce_ms : kUpdateRetryMs;
+  }
+
+  // The formats change events and getContentHash describe. Bit |format| of
+  // a subscriber mask selects one; the order matches ClipboardFormat in
+  // clipboard.dart.
+  enum ContentFormat { kTextFormat, kHtmlFormat, kImageFormat, kFilesFormat, kContentFormatCount };
+  static constexpr uint32_t kAllContentFormats = (1u << kContentFormatCount) - 1;
+
+  static const char* ContentFormatName(int format) {
+    static const char* const kNames[kContentFormatCount] = {"text", "html", "image", "files"};
+    return kNames[format];
+  }
+
+  // Hash and size of each format's payload on the open clipboard. Absent
+  // formats have hash 0 and size -1.
+  struct ContentDigest {
+    uint64_t hashes[kContentFormatCount] = {};
+    int64_t sizes[kContentFormatCount] = {-1, -1, -1, -1};
+
+    // Covers every format, so it changes whenever any of them does.
+    uint64_t combined() const { return clipboard::Xxh64(hashes, sizeof(hashes)); }
+
+    uint32_t present() const {
+      uint32_t mask = 0;
+      for (int format = 0; format < kContentFormatCount; format++) {
+        if (hashes[format] != 0) {
+          mask |= 1u << format;
         }
       }
-      // Close clipboard if Method 1 didn't succeed
-      if (clipboardOpened) {
-        CloseClipboard();
-        clipboardOpened = false;
+      return mask;
+    }
+
+    // Formats whose payload differs from |previous|, including ones that
+    // appeared or disappeared.
+    uint32_t ChangedSince(const ContentDigest& previous) const {
+      uint32_t mask = 0;
+      for (int format = 0; format < kContentFormatCount; format++) {
+        if (hashes[format] != previous.hashes[format]) {
+          mask |= 1u << format;
+        }
       }
+      return mask;
     }
 
-    // Method 2: Try CF_DIBV5 (Device Independent Bitmap V5 - preferred by modern apps)
-    if (!pBitmap && OpenClipboard(nullptr)) {
-      clipboardOpened = true;
-      UINT dibFormat = CF_DIBV5;
-      if (IsClipboardFormatAvailable(CF_DIBV5)) {
-        dibFormat = CF_DIBV5;
-      } else if (IsClipboardFormatAvailable(CF_DIB)) {
-        dibFormat = CF_DIB;
+    // {hash, formats: {name: hash}} for getContentHash. Dart ints are signed
+    // 64-bit, so hashes cross the channel reinterpreted as int64.
+    EncodableMap ToMap() const {
+      EncodableMap formats;
+      for (int format = 0; format < kContentFormatCount; format++) {
+        if (hashes[format] != 0) {
+          formats[EncodableValue(ContentFormatName(format))] =
+              EncodableValue(static_cast<int64_t>(hashes[format]));
+        }
       }
-      
-      if (dibFormat == CF_DIBV5 || dibFormat == CF_DIB) {
-        HGLOBAL hMem = GetClipboardData(dibFormat);
-        if (hMem) {
-          void* pDib = GlobalLock(hMem);
-          if (pDib) {
-            BITMAPINFOHEADER* pBih = (BITMAPINFOHEADER*)pDib;
-            
-            // For CF_DIBV5, use BITMAPV5HEADER which extends BITMAPINFOHEADER
-            DWORD headerSize = (dibFormat == CF_DIBV5) ? sizeof(BITMAPV5HEADER) : sizeof(BITMAPINFOHEADER);
-            
-            // Validate header
-            if (pBih->biSize >= sizeof(BITMAPINFOHEADER) && 
-                pBih->biWidth > 0 && pBih->biHeight != 0) {
-              
-              // Make a complete copy before closing clipboard
-              SIZE_T dibSizeT = GlobalSize(hMem);
-              DWORD dibSize = (dibSizeT > 0xFFFFFFFF) ? 0xFFFFFFFF : static_cast<DWORD>(dibSizeT);
-              std::vector<BYTE> dibData(dibSize);
-              memcpy(dibData.data(), pDib, dibSize);
-              
-              GlobalUnlock(hMem);
-              CloseClipboard();
-              clipboardOpened = false;
-              
-              // Now convert DIB to GDI+ Bitmap using CreateDIBSection
-              HDC hdc = CreateCompatibleDC(nullptr);
-              if (hdc) {
-                BITMAPINFO* pbmi = (BITMAPINFO*)dibData.data();
-                void* pBits = nullptr;
-                
-                // Create DIB section - this allocates memory for us
-                HBITMAP hDibSection = CreateDIBSection(hdc, pbmi, DIB_RGB_COLORS, &pBits, nullptr, 0);
-                if (hDibSection && pBits) {
-                  // Calculate source pixel data offset
-                  void* pSourceBits = dibData.data() + pBih->biSize;
-                  if (pBih->biBitCount <= 8) {
-                    int colorTableSize = static_cast<int>((1ULL << pBih->biBitCount) * sizeof(RGBQUAD));
-                    pSourceBits = dibData.data() + pBih->biSize + colorTableSize;
-                  }
-                  
-                  // Copy pixel data using SetDIBits (handles all conversions automatically)
-                  int height = abs(pBih->biHeight);
-                  SelectObject(hdc, hDibSection);
-                  SetDIBits(hdc, hDibSection, 0, height, pSourceBits, pbmi, DIB_RGB_COLORS);
-                  
-                  // Create GDI+ Bitmap from the DIB section
-                  pBitmap = Bitmap::FromHBITMAP(hDibSection, nullptr);
-                  DeleteObject(hDibSection);
-                  
-                  if (pBitmap && pBitmap->GetLastStatus() != Ok) {
-                    delete pBitmap;
-                    pBitmap = nullptr;
-                  }
-                }
-                DeleteDC(hdc);
-              }
-            } else {
-              GlobalUnlock(hMem);
-            }
-          }
+      return EncodableMap{
+          {EncodableValue("hash"), EncodableValue(static_cast<int64_t>(combined()))},
+          {EncodableValue("formats"), EncodableValue(std::move(formats))},
+      };
+    }
+  };
+
+  // Sends a change event after a clipboard update, and records the new
+  // content in the history when that is enabled. Only history recording
+  // reads payloads; events describe the change and listeners fetch what
+  // they need. Returns false if the clipboard could not be opened, leaving
+  // the change to be retried.
+  bool OnClipboardUpdate() {
+    const bool record = history_enabled_;
+    if (!has_event_listener_ && !record) {
+      return true;
+    }
+    DWORD sequence_number = GetClipboardSequenceNumber();
+    if (sequence_number == last_notified_sequence_) {
+      return true;
+    }
+    clipboard::ClipboardSession session(owner_window_, &clipboard_lock_);
+    if (!session.is_open()) {
+      return false;
+    }
+    // Only now: a change that could not be read must not look handled.
+    // The sequence number cannot move while the clipboard is open.
+    sequence_number = GetClipboardSequenceNumber();
+    last_notified_sequence_ = sequence_number;
+    const ContentDigest digest = ReadContentDigest();
+    clipboard::ClipboardContent content;
+    // Image files are not opened for history; their paths are recorded
+    CapturedImage capture;
+    if (record) {
+      content = ReadClipboardContent();
+      CaptureClipboardImage(false, &capture);
+    }
+    session.Close();
+    if (record) {
+      const char* image_error = nullptr;
+      EncodeCapturedImage(&capture, &content.image_png, &image_error);
+    }
+    CachePasteResult(sequence_number, "getContentHash", EncodableValue(digest.ToMap()), 0);
+    const uint32_t changed = digest.ChangedSince(last_event_digest_);
+    last_event_digest_ = digest;
+    const int64_t timestamp = CurrentTimeMillis();
+    if (has_event_listener_) {
+      SendChangeEvent(sequence_number, digest, changed, timestamp);
+    }
+    if (record) {
+      history_.Add(std::move(content), timestamp);
+    }
+    return true;
+  }
+
+  // Sends the metadata of a change: sequence number, formats present and
+  // changed, payload sizes and hashes. Once Dart has registered
+  // subscriptions, the event lists the subscribers whose format mask covers
+  // a changed format, and is not sent at all when there are none.
+  void SendChangeEvent(DWORD sequence_number, const ContentDigest& digest, uint32_t changed,
+                       int64_t timestamp) {
+    EncodableList subscribers;
+    bool filtered = false;
+    {
+      std::lock_guard<std::mutex> lock(event_subscriptions_mutex_);
+      filtered = has_event_subscriptions_;
+      for (const auto& subscription : event_subscriptions_) {
+        if ((subscription.second & changed) != 0) {
+          subscribers.emplace_back(subscription.first);
         }
       }
-      // Close clipboard if Method 2 didn't succeed
-      if (clipboardOpened) {
-        CloseClipboard();
-        clipboardOpened = false;
+    }
+    if (filtered && subscribers.empty()) {
+      changes_filtered_++;
+      return;
+    }
+    EncodableList formats;
+    EncodableList changed_formats;
+    EncodableMap sizes;
+    for (int format = 0; format < kContentFormatCount; format++) {
+      EncodableValue name(ContentFormatName(format));
+      if (digest.hashes[format] != 0) {
+        formats.push_back(name);
+        sizes[name] = EncodableValue(digest.sizes[format]);
+      }
+      if ((changed & (1u << format)) != 0) {
+        changed_formats.push_back(name);
       }
     }
+    EncodableMap hashes = digest.ToMap();
+    EncodableMap event{
+        {EncodableValue("sequenceNumber"), EncodableValue(static_cast<int64_t>(sequence_number))},
+        {EncodableValue("timestamp"), EncodableValue(timestamp)},
+        {EncodableValue("formats"), EncodableValue(std::move(formats))},
+        {EncodableValue("changedFormats"), EncodableValue(std::move(changed_formats))},
+        {EncodableValue("sizes"), EncodableValue(std::move(sizes))},
+        {EncodableValue("contentHash"), std::move(hashes[EncodableValue("hash")])},
+        {EncodableValue("formatHashes"), std::move(hashes[EncodableValue("formats")])},
+    };
+    if (filtered) {
+      event[EncodableValue("subscribers")] = EncodableValue(std::move(subscribers));
+    }
+    SendEvent(EncodableValue(std::move(event)));
+  }
 
-    // Method 3: Try CF_HDROP (file paths - when copying files from Explorer)
-    if (!pBitmap) {
-      if (!clipboardOpened) {
-        clipboardOpened = OpenClipboard(nullptr);
+  // Replaces the subscriber masks: {subscriptions: {id: mask}}, with bit
+  // n of a mask selecting ContentFormat n.
+  void HandleSetEventSubscriptions(const EncodableMap* arguments, OperationResult* result) {
+    const EncodableMap* subscriptions = nullptr;
+    if (arguments) {
+      auto it = arguments->find(EncodableValue("subscriptions"));
+      if (it != arguments->end()) {
+        subscriptions = std::get_if<EncodableMap>(&it->second);
       }
-      
-      if (clipboardOpened && IsClipboardFormatAvailable(CF_HDROP)) {
-        HDROP hDrop = (HDROP)GetClipboardData(CF_HDROP);
-        if (hDrop) {
-          // Get number of files
-          UINT fileCount = DragQueryFile(hDrop, 0xFFFFFFFF, nullptr, 0);
-          
-          // Try each file path
-          for (UINT i = 0; i < fileCount && !pBitmap; i++) {
-            // Get file path length
-            UINT pathLen = DragQueryFile(hDrop, i, nullptr, 0);
-            if (pathLen > 0) {
-              std::vector<wchar_t> filePath(pathLen + 1);
-              if (DragQueryFile(hDrop, i, filePath.data(), pathLen + 1) > 0) {
-                // Try to load image from file using GDI+
-                pBitmap = Bitmap::FromFile(filePath.data());
-                if (pBitmap) {
-                  if (pBitmap->GetLastStatus() != Ok) {
-                    delete pBitmap;
-                    pBitmap = nullptr;
-                  } else {
-                    // Check if it's actually an image file (by checking file extension)
-                    std::wstring path(filePath.data());
-                    std::wstring ext = path.substr(path.find_last_of(L".") + 1);
-                    // Convert to lowercase for comparison
-                    for (wchar_t& c : ext) {
-                      c = towlower(c);
-                    }
-                    
-                    // Supported image extensions
-                    if (ext != L"jpg" && ext != L"jpeg" && ext != L"png" && 
-                        ext != L"bmp" && ext != L"gif" && ext != L"tiff" && 
-                        ext != L"tif" && ext != L"ico" && ext != L"webp") {
-                      delete pBitmap;
-                      pBitmap = nullptr;
-                    }
-                  }
-                }
-              }
-            }
-          }
+    }
+    if (!subscriptions) {
+      result->Error("INVALID_ARGUMENT", "subscriptions must be a map");
+      return;
+    }
+    std::map<int64_t, uint32_t> masks;
+    for (const auto& entry : *subscriptions) {
+      int64_t id = 0;
+      int64_t mask = 0;
+      if (!ReadInt(entry.first, &id) || !ReadInt(entry.second, &mask) || mask < 0 ||
+          mask > kAllContentFormats) {
+        result->Error("INVALID_ARGUMENT", "subscriptions must map integer ids to format masks");
+        return;
+      }
+      masks[id] = static_cast<uint32_t>(mask);
+    }
+    std::lock_guard<std::mutex> lock(event_subscriptions_mutex_);
+    event_subscriptions_ = std::move(masks);
+    has_event_subscriptions_ = true;
+    result->Success(EncodableValue(true));
+  }
+
+  // The clipboard's CF_DIBV5, or CF_DIB without it. The clipboard must be
+  // open.
+  static HGLOBAL GetClipboardDib() {
+    if (IsClipboardFormatAvailable(CF_DIBV5)) {
+      return GetClipboardData(CF_DIBV5);
+    }
+    if (IsClipboardFormatAvailable(CF_DIB)) {
+      return GetClipboardData(CF_DIB);
+    }
+    return nullptr;
+  }
+
+  // Copies the whole of clipboard global |hMem| into |bytes|.
+  static bool CopyClipboardGlobal(HGLOBAL hMem, std::vector<uint8_t>* bytes) {
+    if (!hMem) {
+      return false;
+    }
+    const uint8_t* data = static_cast<const uint8_t*>(GlobalLock(hMem));
+    if (!data) {
+      return false;
+    }
+    bytes->assign(data, data + GlobalSize(hMem));
+    GlobalUnlock(hMem);
+    return true;
+  }
+
+  // Image data copied off the open clipboard by CaptureClipboardImage, so
+  // that decoding and encoding happen after the clipboard is closed.
+  struct CapturedImage {
+    enum class Source { kNone, kPng, kDib, kBitmap, kFile };
+    Source source = Source::kNone;
+    // kPng: the PNG file. kDib: the packed DIB. kBitmap: top-down 32-bit
+    // rows of |width| x |height| pixels whose fourth byte is undefined.
+    std::vector<uint8_t> bytes;
+    int width = 0;
+    int height = 0;
+    // kFile: the one file copied from Explorer.
+    std::wstring path;
+  };
+
+  // Copies the first image the clipboard offers, in order of fidelity: the
+  // registered "PNG" format (browsers and Office keep alpha there),
+  // CF_DIBV5 or CF_DIB, CF_BITMAP, then with |include_file| a single file
+  // from CF_HDROP. Nothing is parsed or converted here, so the clipboard is
+  // held only for the copy.
+  static bool CaptureClipboardImage(bool include_file, CapturedImage* capture) {
+    UINT cf_png = RegisterClipboardFormatA("PNG");
+    if (cf_png != 0 && IsClipboardFormatAvailable(cf_png) &&
+        CopyClipboardGlobal(GetClipboardData(cf_png), &capture->bytes)) {
+      const size_t png_size = clipboard::PngFileSize(capture->bytes.data(), capture->bytes.size());
+      if (png_size > 0) {
+        capture->bytes.resize(png_size);
+        capture->source = CapturedImage::Source::kPng;
+        return true;
+      }
+    }
+    if (CopyClipboardGlobal(GetClipboardDib(), &capture->bytes)) {
+      capture->source = CapturedImage::Source::kDib;
+      return true;
+    }
+    if (CopyClipboardBitmapBits(&capture->width, &capture->height, &capture->bytes)) {
+      capture->source = CapturedImage::Source::kBitmap;
+      return true;
+    }
+    capture->bytes.clear();
+    std::vector<std::wstring> paths;
+    if (include_file && ReadClipboardFileList(&paths) && paths.size() == 1) {
+      capture->path = std::move(paths[0]);
+      capture->source = CapturedImage::Source::kFile;
+      return true;
+    }
+    return false;
+  }
+
+  // PNG encoder settings from setImageEncodingOptions. Worker thread only.
+  clipboard::PngEncodeOptions ImageEncodeOptions() {
+    clipboard::PngEncodeOptions options;
+    options.max_threads = image_encode_threads_;
+    if (options.max_threads != 1) {
+      options.thread_pool = GetThreadPool();
+    }
+    return options;
+  }
+
+  static constexpr const char* kNoImageMessage =
+      "No image found in clipboard. Copy an image (not a file) or try pasting after copying "
+      "image data from a browser/app.";
+
+  // Turns |capture| into PNG bytes, with the clipboard closed. PNG is
+  // passed through; DIBs the parser reads and CF_BITMAP pixels go through
+  // the built-in encoder; other DIBs (palettes, 16-bit, RLE) and other file
+  // formats are decoded by GDI+. Sets |error| when no PNG could be made.
+  bool EncodeCapturedImage(CapturedImage* capture, std::vector<uint8_t>* png,
+                           const char** error) {
+    *error = "Failed to convert image to PNG format";
+    Bitmap* bitmap = nullptr;
+    switch (capture->source) {
+      case CapturedImage::Source::kNone:
+        *error = kNoImageMessage;
+        return false;
+      case CapturedImage::Source::kPng:
+        *png = std::move(capture->bytes);
+        return true;
+      case CapturedImage::Source::kBitmap: {
+        clipboard::DibImage image;
+        image.pixels = capture->bytes.data();
+        image.stride = static_cast<ptrdiff_t>(capture->width) * 4;
+        image.width = capture->width;
+        image.height = capture->height;
+        image.format = clipboard::DibPixelFormat::kBgrx;
+        return clipboard::EncodePng(image, png, ImageEncodeOptions());
+      }
+      case CapturedImage::Source::kDib: {
+        clipboard::DibImage image;
+        if (clipboard::ParseDib(capture->bytes.data(), capture->bytes.size(), &image)) {
+          return clipboard::EncodePng(image, png, ImageEncodeOptions());
         }
+        if (!gdiplus_.EnsureStarted()) {
+          *error = "Failed to initialize GDI+";
+          return false;
+        }
+        bitmap = BitmapFromDib(&capture->bytes);
+        break;
       }
+      case CapturedImage::Source::kFile:
+        if (!gdiplus_.EnsureStarted()) {
+          *error = "Failed to initialize GDI+";
+          return false;
+        }
+        if (!ReadImageFile(capture->path, png, &bitmap)) {
+          *error = kNoImageMessage;
+          return false;
+        }
+        if (!bitmap) {
+          return true;
+        }
+        break;
     }
+    const bool saved = bitmap && SaveBitmapAsPng(bitmap, png);
+    delete bitmap;
+    return saved;
+  }
 
-    // Close clipboard if still open
-    if (clipboardOpened) {
-      CloseClipboard();
+  // Decodes a packed DIB the built-in parser rejected through a DIB
+  // section. Requires gdiplus_.EnsureStarted().
+  static Bitmap* BitmapFromDib(std::vector<uint8_t>* dib) {
+    if (dib->size() < sizeof(BITMAPINFOHEADER)) {
+      return nullptr;
+    }
+    const auto* header = reinterpret_cast<const BITMAPINFOHEADER*>(dib->data());
+    if (header->biSize < sizeof(BITMAPINFOHEADER) || header->biWidth <= 0 ||
+        header->biHeight == 0) {
+      return nullptr;
+    }
+    // Pixels follow the header, the masks of a plain BI_BITFIELDS header
+    // and the color table
+    size_t pixel_offset = header->biSize;
+    if (header->biSize == sizeof(BITMAPINFOHEADER) && header->biCompression == BI_BITFIELDS) {
+      pixel_offset += 3 * sizeof(DWORD);
+    }
+    size_t colors = header->biClrUsed;
+    if (colors == 0 && header->biBitCount <= 8) {
+      colors = size_t{1} << header->biBitCount;
+    }
+    pixel_offset += colors * sizeof(RGBQUAD);
+    if (pixel_offset >= dib->size()) {
+      return nullptr;
     }
 
-    // If we still don't have a bitmap, return error
-    if (!pBitmap) {
-      GdiplusShutdown(gdiplusToken);
-      result->Error("PASTE_IMAGE_ERROR", "No image found in clipboard. Copy an image (not a file) or try pasting after copying image data from a browser/app.");
-      return;
+    Bitmap* bitmap = nullptr;
+    HDC hdc = CreateCompatibleDC(nullptr);
+    if (!hdc) {
+      return nullptr;
+    }
+    const auto* info = reinterpret_cast<const BITMAPINFO*>(dib->data());
+    void* bits = nullptr;
+    HBITMAP section = CreateDIBSection(hdc, info, DIB_RGB_COLORS, &bits, nullptr, 0);
+    if (section && bits) {
+      // SetDIBits handles every bit depth and compression GDI knows
+      SetDIBits(hdc, section, 0, abs(header->biHeight), dib->data() + pixel_offset, info,
+                DIB_RGB_COLORS);
+      bitmap = Bitmap::FromHBITMAP(section, nullptr);
+      if (bitmap && bitmap->GetLastStatus() != Ok) {
+        delete bitmap;
+        bitmap = nullptr;
+      }
+    }
+    if (section) {
+      DeleteObject(section);
     }
+    DeleteDC(hdc);
+    return bitmap;
+  }
 
-    // Convert bitmap to PNG bytes
-    IStream* pStream = nullptr;
-    if (CreateStreamOnHGlobal(nullptr, TRUE, &pStream) != S_OK) {
-      delete pBitmap;
-      GdiplusShutdown(gdiplusToken);
-      result->Error("PASTE_IMAGE_ERROR", "Failed to create stream");
-      return;
-    }
-
-    // Save as PNG
-    CLSID clsidPng;
-    if (CLSIDFromString(L"{557CF406-1A04-11D3-9A73-0000F81EF32E}", &clsidPng) == S_OK) {
-      if (pBitmap->Save(pStream, &clsidPng, nullptr) == Ok) {
-        // Get stream size
-        STATSTG stat;
-        if (pStream->Stat(&stat, STATFLAG_NONAME) == S_OK) {
-          ULARGE_INTEGER pos;
-          LARGE_INTEGER zero = {0};
-          pStream->Seek(zero, STREAM_SEEK_SET, &pos);
-
-          // Read PNG bytes
-          ULONG bytesRead = 0;
-          std::vector<uint8_t> pngBytes(stat.cbSize.LowPart);
-          HRESULT hr = pStream->Read(pngBytes.data(), stat.cbSize.LowPart, &bytesRead);
-          
-          if (SUCCEEDED(hr) && bytesRead > 0) {
-            // Convert to EncodableList for Flutter
-            EncodableList imageBytes;
-            imageBytes.reserve(bytesRead);
-            for (ULONG i = 0; i < bytesRead; i++) {
-              imageBytes.push_back(EncodableValue(static_cast<int32_t>(pngBytes[i])));
-            }
-            result_map[EncodableValue("imageBytes")] = EncodableValue(imageBytes);
-          }
+  // Saves |bitmap| with the GDI+ PNG encoder into |png|.
+  bool SaveBitmapAsPng(Bitmap* bitmap, std::vector<uint8_t>* png) {
+    const CLSID* clsid_png = gdiplus_.GetEncoderClsid(L"image/png");
+    IStream* stream = nullptr;
+    if (!clsid_png || CreateStreamOnHGlobal(nullptr, TRUE, &stream) != S_OK) {
+      return false;
+    }
+    bool saved = false;
+    STATSTG stat;
+    if (bitmap->Save(stream, clsid_png, nullptr) == Ok &&
+        stream->Stat(&stat, STATFLAG_NONAME) == S_OK) {
+      LARGE_INTEGER zero = {};
+      stream->Seek(zero, STREAM_SEEK_SET, nullptr);
+      ULONG bytes_read = 0;
+      png->resize(stat.cbSize.LowPart);
+      saved = SUCCEEDED(stream->Read(png->data(), stat.cbSize.LowPart, &bytes_read)) &&
+              bytes_read > 0;
+      png->resize(saved ? bytes_read : 0);
+    }
+    stream->Release();
+    return saved;
+  }
+
+  // Reads the image file at |path| after sniffing its signature, so other
+  // files are rejected without decoding. PNG bytes are returned as they are
+  // and BMPs the DIB parser understands are encoded directly, both in
+  // |png|; other formats are decoded by GDI+ into |bitmap| (requires
+  // gdiplus_.EnsureStarted()). Returns false for non-images.
+  bool ReadImageFile(const std::wstring& path, std::vector<uint8_t>* png, Bitmap** bitmap) {
+    MappedFile file(path);
+    if (!file.is_valid()) {
+      return false;
+    }
+    // Every signature fits in the first few bytes; they go through the
+    // guarded copy like the rest of the file.
+    uint8_t head[32];
+    const size_t head_size = std::min(sizeof(head), file.size());
+    if (!CopyMappedBytes(file.data(), head_size, head)) {
+      return false;
+    }
+    switch (clipboard::SniffImageFormat(head, head_size)) {
+      case clipboard::ImageFileFormat::kUnknown:
+        return false;
+      case clipboard::ImageFileFormat::kPng:
+        png->resize(file.size());
+        if (!CopyMappedBytes(file.data(), file.size(), png->data())) {
+          png->clear();
+          return false;
+        }
+        return true;
+      case clipboard::ImageFileFormat::kBmp: {
+        // Parsing reads the view in place, so copy first: a page fault
+        // there would not be caught the way CopyMappedBytes catches it.
+        std::vector<uint8_t> bmp(file.size());
+        if (!CopyMappedBytes(file.data(), file.size(), bmp.data())) {
+          return false;
         }
+        // bfOffBits: where the pixels start, from the start of the file
+        const size_t dib_size = bmp.size() - clipboard::kBmpFileHeaderSize;
+        const uint32_t pixel_offset = static_cast<uint32_t>(bmp[10]) |
+                                      static_cast<uint32_t>(bmp[11]) << 8 |
+                                      static_cast<uint32_t>(bmp[12]) << 16 |
+                                      static_cast<uint32_t>(bmp[13]) << 24;
+        clipboard::DibImage image;
+        if (pixel_offset > clipboard::kBmpFileHeaderSize && pixel_offset < bmp.size() &&
+            clipboard::ParseDib(bmp.data() + clipboard::kBmpFileHeaderSize, dib_size,
+                                pixel_offset - clipboard::kBmpFileHeaderSize, &image) &&
+            clipboard::EncodePng(image, png)) {
+          return true;
+        }
+        break;
       }
+      default:
+        break;
+    }
+    *bitmap = Bitmap::FromFile(path.c_str());
+    if (*bitmap && (*bitmap)->GetLastStatus() != Ok) {
+      delete *bitmap;
+      *bitmap = nullptr;
     }
+    return *bitmap != nullptr;
+  }
 
-    pStream->Release();
-    delete pBitmap;
-    GdiplusShutdown(gdiplusToken);
+  // The clipboard is held only while the image is copied off it; parsing,
+  // GDI+ decoding and PNG encoding all run after it is closed.
+  void HandlePasteImage(OperationResult* result) {
+    DWORD sequence = GetClipboardSequenceNumber();
+    if (auto cached = paste_cache_.Find(sequence, "pasteImage")) {
+      result->Success(cached);
+      return;
+    }
 
-    if (result_map.find(EncodableValue("imageBytes")) != result_map.end()) {
-      result->Success(EncodableValue(result_map));
-    } else {
-      result->Error("PASTE_IMAGE_ERROR", "Failed to convert image to PNG format");
+    clipboard::ClipboardSession session(nullptr, &clipboard_lock_, AcquireOptions());
+    if (!session.is_open()) {
+      ReportOpenFailure(result, "PASTE_IMAGE_ERROR", session);
+      return;
+    }
+    // Cannot change while the clipboard is open
+    sequence = GetClipboardSequenceNumber();
+    CapturedImage capture;
+    CaptureClipboardImage(true, &capture);
+    session.Close();
+
+    std::vector<uint8_t> png;
+    const char* error = nullptr;
+    if (!EncodeCapturedImage(&capture, &png, &error)) {
+      result->Error("PASTE_IMAGE_ERROR", error);
+      return;
+    }
+    const size_t png_size = png.size();
+    EncodableMap result_map;
+    result_map[EncodableValue("imageBytes")] = EncodableValue(std::move(png));
+    auto value = CachePasteResult(sequence, "pasteImage", EncodableValue(std::move(result_map)),
+                                  png_size);
+    result->Success(value);
+  }
+
+
+  // Pixel layout requested by pasteImageRaw; see ReadRawImageRequest.
+  struct RawImageRequest {
+    bool bgra = false;
+    bool premultiplied = false;
+
+    std::string CacheKey() const {
+      return std::string(bgra ? "pasteImageRaw:bgra8888" : "pasteImageRaw:rgba8888") +
+             (premultiplied ? ":premultiplied" : "");
+    }
+  };
+
+  // Reads the optional "pixelFormat" ("rgba8888" or "bgra8888") and
+  // "premultiplied" arguments. Returns false for anything else.
+  static bool ReadRawImageRequest(const EncodableMap* arguments, RawImageRequest* request) {
+    if (!arguments) {
+      return true;
+    }
+    auto format_it = arguments->find(EncodableValue("pixelFormat"));
+    if (format_it != arguments->end() && !format_it->second.IsNull()) {
+      const auto* format = std::get_if<std::string>(&format_it->second);
+      if (!format || (*format != "rgba8888" && *format != "bgra8888")) {
+        return false;
+      }
+      request->bgra = *format == "bgra8888";
+    }
+    auto premultiplied_it = arguments->find(EncodableValue("premultiplied"));
+    if (premultiplied_it != arguments->end() && !premultiplied_it->second.IsNull()) {
+      const auto* premultiplied = std::get_if<bool>(&premultiplied_it->second);
+      if (!premultiplied) {
+        return false;
+      }
+      request->premultiplied = *premultiplied;
+    }
+    return true;
+  }
+
+  // Copies the clipboard's CF_DIBV5 or CF_DIB into |pixels| as tightly
+  // packed 32-bit rows. Returns false for DIBs the parser does not handle.
+  bool ReadClipboardDibPixels(const clipboard::PixelConvertOptions& options, int* width,
+                              int* height, std::vector<uint8_t>* pixels) {
+    HGLOBAL hMem = GetClipboardDib();
+    if (!hMem) {
+      return false;
+    }
+    const uint8_t* dib = static_cast<const uint8_t*>(GlobalLock(hMem));
+    if (!dib) {
+      return false;
+    }
+    clipboard::DibImage image;
+    bool parsed = clipboard::ParseDib(dib, GlobalSize(hMem), &image);
+    if (parsed) {
+      *width = image.width;
+      *height = image.height;
+      pixels->resize(static_cast<size_t>(image.width) * image.height * 4);
+      clipboard::CopyDibPixels(image, options, pixels->data());
+    }
+    GlobalUnlock(hMem);
+    return parsed;
+  }
+
+  // Reads CF_BITMAP through GetDIBits as top-down 32bpp BGRX, then applies
+  // |options| in place. GDI leaves the fourth byte undefined, so the result
+  // is always opaque.
+  static bool ReadClipboardBitmapPixels(const clipboard::PixelConvertOptions& options, int* width,
+                                        int* height, std::vector<uint8_t>* pixels) {
+    if (!CopyClipboardBitmapBits(width, height, pixels)) {
+      return false;
+    }
+    clipboard::PixelConvertOptions convert = options;
+    convert.force_opaque = true;
+    const ptrdiff_t stride = static_cast<ptrdiff_t>(*width) * 4;
+    clipboard::ConvertPixelRows(pixels->data(), stride, pixels->data(), stride, *width, *height,
+                                convert);
+    return true;
+  }
+
+  // CF_BITMAP through GetDIBits as top-down 32bpp rows, the fourth byte
+  // left as GDI wrote it.
+  static bool CopyClipboardBitmapBits(int* width, int* height, std::vector<uint8_t>* pixels) {
+    if (!IsClipboardFormatAvailable(CF_BITMAP)) {
+      return false;
+    }
+    HBITMAP hBitmap = static_cast<HBITMAP>(GetClipboardData(CF_BITMAP));
+    BITMAP bm;
+    if (!hBitmap || !GetObject(hBitmap, sizeof(bm), &bm) || bm.bmWidth <= 0 ||
+        bm.bmHeight <= 0) {
+      return false;
+    }
+    BITMAPINFO bmi = {};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = bm.bmWidth;
+    bmi.bmiHeader.biHeight = -bm.bmHeight;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    pixels->resize(static_cast<size_t>(bm.bmWidth) * bm.bmHeight * 4);
+    HDC hdc = GetDC(nullptr);
+    int rows = GetDIBits(hdc, hBitmap, 0, bm.bmHeight, pixels->data(), &bmi, DIB_RGB_COLORS);
+    ReleaseDC(nullptr, hdc);
+    if (rows != bm.bmHeight) {
+      pixels->clear();
+      return false;
+    }
+    *width = bm.bmWidth;
+    *height = bm.bmHeight;
+    return true;
+  }
+
+  // Returns the clipboard image as uncompressed pixels for
+  // decodeImageFromPixels: no PNG on this side, no codec on the Dart side.
+  void HandlePasteImageRaw(const EncodableMap* arguments, OperationResult* result) {
+    RawImageRequest request;
+    if (!ReadRawImageRequest(arguments, &request)) {
+      result->Error("INVALID_ARGUMENT",
+                    "pixelFormat must be rgba8888 or bgra8888 and premultiplied a bool");
+      return;
+    }
+    const std::string cache_key = request.CacheKey();
+    DWORD sequence = GetClipboardSequenceNumber();
+    if (auto cached = paste_cache_.Find(sequence, cache_key)) {
+      result->Success(cached);
+      return;
     }
+
+    clipboard::ClipboardSession session(nullptr, &clipboard_lock_, AcquireOptions());
+    if (!session.is_open()) {
+      ReportOpenFailure(result, "PASTE_IMAGE_ERROR", session);
+      return;
+    }
+    clipboard::PixelConvertOptions options;
+    options.swap_red_blue = !request.bgra;
+    options.premultiply_alpha = request.premultiplied;
+    if (image_encode_threads_ != 1) {
+      options.thread_pool = GetThreadPool();
+    }
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;
+    bool found = ReadClipboardDibPixels(options, &width, &height, &pixels) ||
+                 ReadClipboardBitmapPixels(options, &width, &height, &pixels);
+    session.Close();
+    if (!found) {
+      result->Error("PASTE_IMAGE_ERROR", "No image found in clipboard");
+      return;
+    }
+
+    const size_t size = pixels.size();
+    EncodableMap result_map;
+    result_map[EncodableValue("width")] = EncodableValue(width);
+    result_map[EncodableValue("height")] = EncodableValue(height);
+    result_map[EncodableValue("stride")] = EncodableValue(static_cast<int64_t>(width) * 4);
+    result_map[EncodableValue("pixelFormat")] =
+        EncodableValue(request.bgra ? "bgra8888" : "rgba8888");
+    result_map[EncodableValue("premultiplied")] = EncodableValue(request.premultiplied);
+    result_map[EncodableValue("bytes")] = EncodableValue(std::move(pixels));
+    auto value = CachePasteResult(sequence, cache_key, EncodableValue(std::move(result_map)), size);
+    result->Success(value);
   }
 
-  void HandleGetContentType(std::unique_ptr<flutter::MethodResult<EncodableValue>> result) {
-    // Don't access clipboard automatically
-    result->Success(EncodableValue("unknown"));
+  // Shrinks |image| to fit |max_dimension| and filters the result for PNG.
+  // Images that already fit are filtered as they are.
+  static bool FilterThumbnailRows(const clipboard::DibImage& image, int max_dimension,
+                                  clipboard::ScaleFilter filter,
+                                  clipboard::PngScanlines* scanlines) {
+    clipboard::DibImage thumbnail;
+    clipboard::FitWithin(image.width, image.height, max_dimension, &thumbnail.width,
+                         &thumbnail.height);
+    if (thumbnail.width == image.width && thumbnail.height == image.height) {
+      return clipboard::FilterPngRows(image, scanlines);
+    }
+    std::vector<uint8_t> pixels(static_cast<size_t>(thumbnail.width) * thumbnail.height * 4);
+    clipboard::ScaleDibImage(image, thumbnail.width, thumbnail.height, filter, pixels.data());
+    thumbnail.pixels = pixels.data();
+    thumbnail.stride = static_cast<ptrdiff_t>(thumbnail.width) * 4;
+    thumbnail.format = image.format == clipboard::DibPixelFormat::kBgra
+                           ? clipboard::DibPixelFormat::kBgra
+                           : clipboard::DibPixelFormat::kBgrx;
+    return clipboard::FilterPngRows(thumbnail, scanlines);
+  }
+
+  // Reads the required "maxDimension" and optional "filter" ("box" or
+  // "lanczos") arguments of pasteImageThumbnail.
+  static bool ReadThumbnailRequest(const EncodableMap* arguments, int* max_dimension,
+                                   clipboard::ScaleFilter* filter) {
+    if (!arguments) {
+      return false;
+    }
+    auto size_it = arguments->find(EncodableValue("maxDimension"));
+    if (size_it == arguments->end()) {
+      return false;
+    }
+    int64_t size = 0;
+    if (const auto* size32 = std::get_if<int32_t>(&size_it->second)) {
+      size = *size32;
+    } else if (const auto* size64 = std::get_if<int64_t>(&size_it->second)) {
+      size = *size64;
+    }
+    if (size < 1 || size > kMaxThumbnailDimension) {
+      return false;
+    }
+    *max_dimension = static_cast<int>(size);
+    *filter = clipboard::ScaleFilter::kBox;
+    auto filter_it = arguments->find(EncodableValue("filter"));
+    if (filter_it != arguments->end() && !filter_it->second.IsNull()) {
+      const auto* name = std::get_if<std::string>(&filter_it->second);
+      if (!name || (*name != "box" && *name != "lanczos")) {
+        return false;
+      }
+      if (*name == "lanczos") {
+        *filter = clipboard::ScaleFilter::kLanczos3;
+      }
+    }
+    return true;
   }
 
-  void HandleHasData(std::unique_ptr<flutter::MethodResult<EncodableValue>> result) {
-    // Don't access clipboard automatically
-    result->Success(EncodableValue(false));
+  static std::string ThumbnailCacheKey(int max_dimension, clipboard::ScaleFilter filter) {
+    return "pasteImageThumbnail:" + std::to_string(max_dimension) +
+           (filter == clipboard::ScaleFilter::kBox ? ":box" : ":lanczos");
   }
 
-  void HandleClear(std::unique_ptr<flutter::MethodResult<EncodableValue>> result) {
-    if (OpenClipboard(nullptr)) {
+  // PNG of the clipboard image shrunk to fit |maxDimension|, resampled from
+  // the DIB or CF_BITMAP before encoding so previews never pay for the
+  // full-resolution PNG.
+  void HandlePasteImageThumbnail(const EncodableMap* arguments, OperationResult* result) {
+    int max_dimension = 0;
+    clipboard::ScaleFilter filter = clipboard::ScaleFilter::kBox;
+    if (!ReadThumbnailRequest(arguments, &max_dimension, &filter)) {
+      result->Error("INVALID_ARGUMENT",
+                    "maxDimension must be between 1 and 16384 and filter box or lanczos");
+      return;
+    }
+    const std::string cache_key = ThumbnailCacheKey(max_dimension, filter);
+    DWORD sequence = GetClipboardSequenceNumber();
+    if (auto cached = paste_cache_.Find(sequence, cache_key)) {
+      result->Success(cached);
+      return;
+    }
+
+    clipboard::ClipboardSession session(nullptr, &clipboard_lock_, AcquireOptions());
+    if (!session.is_open()) {
+      ReportOpenFailure(result, "PASTE_IMAGE_ERROR", session);
+      return;
+    }
+    // Only copies are taken while the clipboard is open; other applications
+    // wait on it, and resampling a 4K capture takes tens of milliseconds.
+    // Parsing only reads the header, so an unusable DIB still falls back to
+    // CF_BITMAP.
+    std::vector<uint8_t> dib;
+    std::vector<uint8_t> pixels;
+    clipboard::DibImage image;
+    bool found = CopyClipboardGlobal(GetClipboardDib(), &dib) &&
+                 clipboard::ParseDib(dib.data(), dib.size(), &image);
+    if (!found && ReadClipboardBitmapPixels(clipboard::PixelConvertOptions(), &image.width,
+                                            &image.height, &pixels)) {
+      image.pixels = pixels.data();
+      image.stride = static_cast<ptrdiff_t>(image.width) * 4;
+      image.format = clipboard::DibPixelFormat::kBgrx;
+      found = true;
+    }
+    session.Close();
+
+    clipboard::PngScanlines scanlines;
+    found = found && FilterThumbnailRows(image, max_dimension, filter, &scanlines);
+    if (!found) {
+      result->Error("PASTE_IMAGE_ERROR", "No image found in clipboard");
+      return;
+    }
+
+    std::vector<uint8_t> png;
+    clipboard::WritePng(scanlines, &png);
+    const size_t png_size = png.size();
+    EncodableMap result_map;
+    result_map[EncodableValue("width")] = EncodableValue(scanlines.width);
+    result_map[EncodableValue("height")] = EncodableValue(scanlines.height);
+    result_map[EncodableValue("imageBytes")] = EncodableValue(std::move(png));
+    auto value =
+        CachePasteResult(sequence, cache_key, EncodableValue(std::move(result_map)), png_size);
+    result->Success(value);
+  }
+
+  // Classifies the clipboard from format availability alone; this does not
+  // open the clipboard or touch any payload.
+  void HandleGetContentType(OperationResult* result) {
+    if (CountClipboardFormats() == 0) {
+      result->Success(EncodableValue("empty"));
+      return;
+    }
+
+    UINT cf_html = RegisterClipboardFormatA("HTML Format");
+    UINT cf_png = RegisterClipboardFormatA("PNG");
+    bool has_text = IsClipboardFormatAvailable(CF_UNICODETEXT) || IsClipboardFormatAvailable(CF_TEXT);
+    bool has_html = cf_html != 0 && IsClipboardFormatAvailable(cf_html);
+    bool has_image = (cf_png != 0 && IsClipboardFormatAvailable(cf_png)) ||
+                     IsClipboardFormatAvailable(CF_DIBV5) || IsClipboardFormatAvailable(CF_DIB) ||
+                     IsClipboardFormatAvailable(CF_BITMAP);
+    bool has_files = IsClipboardFormatAvailable(CF_HDROP) != FALSE;
+
+    // Producers put one item on the clipboard in several kinds: browsers
+    // and Office add text next to HTML, and HTML or text next to images and
+    // files. The richest kind wins; only files with an image, which callers
+    // handle in unrelated ways, are reported as mixed.
+    const char* type = "unknown";
+    if (has_files && has_image) {
+      type = "mixed";
+    } else if (has_files) {
+      type = "files";
+    } else if (has_image) {
+      type = "image";
+    } else if (has_html) {
+      type = "html";
+    } else if (has_text) {
+      type = "text";
+    }
+    result->Success(EncodableValue(type));
+  }
+
+  void HandleHasData(OperationResult* result) {
+    // Counting formats needs no clipboard lock
+    result->Success(EncodableValue(CountClipboardFormats() > 0));
+  }
+
+  void HandleClear(OperationResult* result) {
+    clipboard::ClipboardSession session(owner_window_, &clipboard_lock_, AcquireOptions());
+    if (session.is_open()) {
       EmptyClipboard();
-      CloseClipboard();
+      session.Close();
       result->Success(EncodableValue(true));
     } else {
-      result->Error("CLEAR_ERROR", "Failed to open clipboard");
+      ReportOpenFailure(result, "CLEAR_ERROR", session);
     }
   }
 
-  void HandleGetDataSize(std::unique_ptr<flutter::MethodResult<EncodableValue>> result) {
-    // Don't access clipboard automatically
-    result->Success(EncodableValue(0));
+  // Sum of the measurable format sizes reported by ProbeClipboardFormats.
+  void HandleGetDataSize(OperationResult* result) {
+    clipboard::ClipboardSession session(owner_window_, &clipboard_lock_, AcquireOptions());
+    if (!session.is_open()) {
+      ReportOpenFailure(result, "DATA_SIZE_ERROR", session);
+      return;
+    }
+    std::vector<ClipboardFormatInfo> formats = ProbeClipboardFormats();
+    session.Close();
+    int64_t total = 0;
+    for (const auto& format : formats) {
+      if (format.size > 0) {
+        total += format.size;
+      }
+    }
+    result->Success(EncodableValue(total));
+  }
+
+  // Per-format size breakdown: format name -> bytes, -1 if not measurable.
+  void HandleGetFormatSizes(OperationResult* result) {
+    clipboard::ClipboardSession session(owner_window_, &clipboard_lock_, AcquireOptions());
+    if (!session.is_open()) {
+      ReportOpenFailure(result, "DATA_SIZE_ERROR", session);
+      return;
+    }
+    std::vector<ClipboardFormatInfo> formats = ProbeClipboardFormats();
+    session.Close();
+    EncodableMap sizes;
+    for (const auto& format : formats) {
+      sizes[EncodableValue(format.name)] = EncodableValue(format.size);
+    }
+    result->Success(EncodableValue(sizes));
+  }
+
+  // How much of a clipboard global HashClipboardGlobal covers.
+  enum class HashExtent { kWhole, kNarrowString, kWideString };
+
+  // Hashes the bytes of |hMem| in place, up to the terminator for strings
+  // (the allocation may be rounded up past it), into entry |format| of
+  // |digest|. Leaves it absent without a handle.
+  static void HashClipboardGlobal(HGLOBAL hMem, HashExtent extent, ContentFormat format,
+                                  ContentDigest* digest) {
+    if (!hMem) {
+      return;
+    }
+    const void* data = GlobalLock(hMem);
+    if (!data) {
+      return;
+    }
+    size_t size = GlobalSize(hMem);
+    if (extent == HashExtent::kNarrowString) {
+      size = strnlen(static_cast<const char*>(data), size);
+    } else if (extent == HashExtent::kWideString) {
+      size = wcsnlen(static_cast<const wchar_t*>(data), size / sizeof(wchar_t)) * sizeof(wchar_t);
+    }
+    digest->hashes[format] = clipboard::Xxh64(data, size);
+    digest->sizes[format] = static_cast<int64_t>(size);
+    GlobalUnlock(hMem);
+  }
+
+  // Fingerprints the open clipboard without decoding or copying anything:
+  // text and HTML as stored, the DIB and the CF_HDROP list byte for byte.
+  static ContentDigest ReadContentDigest() {
+    ContentDigest digest;
+    if (IsClipboardFormatAvailable(CF_UNICODETEXT)) {
+      HashClipboardGlobal(GetClipboardData(CF_UNICODETEXT), HashExtent::kWideString, kTextFormat,
+                          &digest);
+    }
+    UINT cf_html = RegisterClipboardFormatA("HTML Format");
+    if (cf_html != 0 && IsClipboardFormatAvailable(cf_html)) {
+      HashClipboardGlobal(GetClipboardData(cf_html), HashExtent::kNarrowString, kHtmlFormat,
+                          &digest);
+    }
+    HashClipboardGlobal(GetClipboardDib(), HashExtent::kWhole, kImageFormat, &digest);
+    if (IsClipboardFormatAvailable(CF_HDROP)) {
+      HashClipboardGlobal(GetClipboardData(CF_HDROP), HashExtent::kWhole, kFilesFormat, &digest);
+    }
+    return digest;
+  }
+
+  // Cached per sequence number like the pastes, so polling it is nearly free
+  // until the clipboard changes.
+  void HandleGetContentHash(OperationResult* result) {
+    DWORD sequence = GetClipboardSequenceNumber();
+    if (auto cached = paste_cache_.Find(sequence, "getContentHash")) {
+      result->Success(cached);
+      return;
+    }
+    clipboard::ClipboardSession session(nullptr, &clipboard_lock_, AcquireOptions());
+    if (!session.is_open()) {
+      ReportOpenFailure(result, "CONTENT_HASH_ERROR", session);
+      return;
+    }
+    const ContentDigest digest = ReadContentDigest();
+    session.Close();
+    result->Success(
+        CachePasteResult(sequence, "getContentHash", EncodableValue(digest.ToMap()), 0));
+  }
+
+  struct ClipboardFormatInfo {
+    UINT format;
+    std::string name;
+    int64_t size;  // -1 when the size is unknown without rendering
+  };
+
+  // Lists the formats on the open clipboard with their GlobalSize, without
+  // making anything render. A format is measured (GetClipboardData, then
+  // GlobalSize; its memory is never locked or copied) only when it is
+  // already stored as memory:
+  //  - the owner is this plugin and the format is not one of our delayed
+  //    ones, or the clipboard has no owner window, so nothing is delayed.
+  //    Another application's formats may be delayed, and Win32 cannot tell
+  //    which, so they all report -1;
+  //  - it is the first of its family in EnumClipboardFormats order, which
+  //    lists formats as set before the ones Windows synthesizes from them
+  //    (the text formats from each other, CF_DIB and CF_DIBV5 from each
+  //    other or from CF_BITMAP);
+  //  - it is not held as a GDI handle (bitmaps, palettes, metafiles).
+  // Everything else reports -1.
+  std::vector<ClipboardFormatInfo> ProbeClipboardFormats() {
+    std::vector<ClipboardFormatInfo> formats;
+    const HWND owner = GetClipboardOwner();
+    const bool owner_may_delay = owner != nullptr && owner != owner_window_;
+    bool seen_text = false;
+    bool seen_bitmap = false;
+    UINT format = 0;
+    while ((format = EnumClipboardFormats(format)) != 0) {
+      int64_t size = -1;
+      bool measurable = !owner_may_delay;
+      switch (format) {
+        case CF_BITMAP:
+          measurable = false;
+          seen_bitmap = true;
+          break;
+        case CF_PALETTE:
+        case CF_METAFILEPICT:
+        case CF_ENHMETAFILE:
+        case CF_DSPBITMAP:
+        case CF_DSPENHMETAFILE:
+        case CF_DSPMETAFILEPICT:
+        case CF_OWNERDISPLAY:
+          measurable = false;
+          break;
+        case CF_TEXT:
+        case CF_OEMTEXT:
+        case CF_UNICODETEXT:
+          measurable = measurable && !seen_text;
+          seen_text = true;
+          break;
+        case CF_DIB:
+        case CF_DIBV5:
+          measurable = measurable && !seen_bitmap;
+          seen_bitmap = true;
+          break;
+      }
+      if (measurable && owner == owner_window_ && HasDelayedRender(format)) {
+        measurable = false;
+      }
+      if (measurable) {
+        HANDLE hData = GetClipboardData(format);
+        if (hData) {
+          size = static_cast<int64_t>(GlobalSize(hData));
+        }
+      }
+      formats.push_back({format, ClipboardFormatName(format), size});
+    }
+    return formats;
+  }
+
+  static std::string ClipboardFormatName(UINT format) {
+    switch (format) {
+      case CF_TEXT: return "CF_TEXT";
+      case CF_BITMAP: return "CF_BITMAP";
+      case CF_METAFILEPICT: return "CF_METAFILEPICT";
+      case CF_SYLK: return "CF_SYLK";
+      case CF_DIF: return "CF_DIF";
+      case CF_TIFF: return "CF_TIFF";
+      case CF_OEMTEXT: return "CF_OEMTEXT";
+      case CF_DIB: return "CF_DIB";
+      case CF_PALETTE: return "CF_PALETTE";
+      case CF_PENDATA: return "CF_PENDATA";
+      case CF_RIFF: return "CF_RIFF";
+      case CF_WAVE: return "CF_WAVE";
+      case CF_UNICODETEXT: return "CF_UNICODETEXT";
+      case CF_ENHMETAFILE: return "CF_ENHMETAFILE";
+      case CF_HDROP: return "CF_HDROP";
+      case CF_LOCALE: return "CF_LOCALE";
+      case CF_DIBV5: return "CF_DIBV5";
+    }
+    wchar_t name[256];
+    int length = GetClipboardFormatNameW(format, name, 256);
+    if (length > 0) {
+      int size_needed = WideCharToMultiByte(CP_UTF8, 0, name, length, NULL, 0, NULL, NULL);
+      std::string utf8(size_needed, '\0');
+      WideCharToMultiByte(CP_UTF8, 0, name, length, &utf8[0], size_needed, NULL, NULL);
+      return utf8;
+    }
+    return "#" + std::to_string(format);
+  }
+
+  // Created on first use by large image conversions.
+  clipboard::ThreadPool* GetThreadPool() {
+    if (!thread_pool_) {
+      thread_pool_ = std::make_unique<clipboard::ThreadPool>(
+          clipboard::ThreadPool::DefaultWorkerCount());
+    }
+    return thread_pool_.get();
   }
 
-  flutter::EventSink<flutter::EncodableValue>* event_sink_ = nullptr;
+  // Text at least this large (UTF-8 bytes) is converted on demand.
+  static constexpr size_t kDelayedTextThreshold = 64 * 1024;
+  // Copies up to this many bytes of text and HTML run on the platform thread.
+  static constexpr size_t kInlineTextThreshold = 4 * 1024;
+  static constexpr int64_t kMaxEncodeThreads = 64;
+  static constexpr int64_t kMaxThumbnailDimension = 16384;
+  static constexpr int64_t kDefaultHistoryPageSize = 50;
+  static constexpr size_t kHistoryPreviewBytes = 256;
+  static constexpr UINT_PTR kCoalesceTimerId = 1;
+  // Retries of an update that found the clipboard busy, and their interval
+  // when there is no debounce window to wait for.
+  static constexpr int kMaxUpdateRetries = 10;
+  static constexpr UINT kUpdateRetryMs = 20;
+  static constexpr UINT kDefaultDebounceMs = 50;
+  static constexpr int64_t kMaxQueuedEvents = 1024;
+
+  clipboard::PasteCache<EncodableValue> paste_cache_;
+  clipboard::ClipboardLock clipboard_lock_;
+  const DWORD platform_thread_id_;
+  HWND owner_window_ = nullptr;
+  // Inline copies register delayed formats from the platform thread while
+  // the worker renders them.
+  std::mutex delayed_renders_mutex_;
+  std::map<UINT, std::function<HGLOBAL()>> delayed_renders_;
+  std::atomic<bool> has_event_listener_{false};
+  std::atomic<UINT> monitoring_debounce_ms_{kDefaultDebounceMs};
+  std::atomic<uint64_t> changes_received_{0};
+  std::atomic<uint64_t> changes_coalesced_{0};
+  // Changes no subscriber's format mask selected.
+  std::atomic<uint64_t> changes_filtered_{0};
+  std::atomic<uint64_t> events_delivered_{0};
+  clipboard::EventQueue<EncodableValue> event_queue_;
+  // Subscriber id -> ContentFormat mask, set from Dart. Until the first
+  // setEventSubscriptions every change is sent, unfiltered.
+  std::mutex event_subscriptions_mutex_;
+  std::map<int64_t, uint32_t> event_subscriptions_;
+  bool has_event_subscriptions_ = false;
+  // Threads for PNG encoding on paste; 0 uses the whole pool.
+  std::atomic<uint32_t> image_encode_threads_{0};
+  clipboard::ClipboardHistory history_;
+  std::atomic<bool> history_enabled_{false};
+  // Worker thread only.
+  GdiplusRuntime gdiplus_;
+  size_t history_max_bytes_ = clipboard::ClipboardHistory::kDefaultMaxBytes;
+  size_t history_max_entries_ = clipboard::ClipboardHistory::kDefaultMaxEntries;
+  std::unique_ptr<clipboard::ThreadPool> thread_pool_;
+  bool monitoring_ = false;
+  // A debounce window is open, and a change arrived during it.
+  bool coalescing_ = false;
+  bool change_pending_ = false;
+  int update_retries_ = 0;
+  DWORD last_notified_sequence_ = 0;
+  ContentDigest last_event_digest_;
+  // Platform thread only.
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> event_sink_;
+  bool acknowledge_events_ = false;
+  size_t events_in_flight_ = 0;
+  std::unique_ptr<clipboard::PlatformTaskRunner> platform_runner_;
+  // Declared last so it is destroyed first.
+  std::unique_ptr<clipboard::ClipboardWorker> worker_;
 };
 
 }  // namespace
 
 FLUTTER_PLUGIN_EXPORT void ClipboardPluginRegisterWithRegistrar(
     FlutterDesktopPluginRegistrarRef registrar) {
-  ClipboardPluginImpl::RegisterWithRegistrar(registrar);
+  ClipboardPluginImpl::RegisterWithRegistrar(
+      flutter::PluginRegistrarManager::GetInstance()
+          ->GetRegistrar<flutter::PluginRegistrarWindows>(registrar));
 }
 
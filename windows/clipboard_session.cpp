@@ -0,0 +1,169 @@
+#include "clipboard_session.h"
+
+#include <algorithm>
+
+namespace clipboard {
+
+namespace {
+
+// Whether a ClipboardBatch holds the clipboard open on this thread.
+thread_local bool t_in_batch = false;
+
+uint64_t ElapsedMicros(std::chrono::steady_clock::time_point since) {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - since)
+          .count());
+}
+
+// Waits up to |milliseconds| while dispatching messages sent to this
+// thread's windows. A plain Sleep would stall another process that holds the
+// clipboard while it asks us to render a delayed format.
+void WaitDispatchingSentMessages(uint32_t milliseconds) {
+  const auto end = std::chrono::steady_clock::now() +
+                   std::chrono::milliseconds(milliseconds);
+  for (;;) {
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= end) {
+      return;
+    }
+    const auto remaining =
+        std::chrono::duration_cast<std::chrono::milliseconds>(end - now).count();
+    DWORD wait = MsgWaitForMultipleObjectsEx(
+        0, nullptr, static_cast<DWORD>(std::max<long long>(remaining, 1)),
+        QS_SENDMESSAGE, 0);
+    if (wait != WAIT_OBJECT_0) {
+      return;
+    }
+    // Peeking delivers the pending sent messages; nothing is removed.
+    MSG message;
+    PeekMessageW(&message, nullptr, 0, 0, PM_NOREMOVE | PM_QS_SENDMESSAGE);
+  }
+}
+
+}  // namespace
+
+ClipboardAcquireOptions ClipboardLock::options() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return options_;
+}
+
+void ClipboardLock::set_options(const ClipboardAcquireOptions& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  options_ = options;
+}
+
+ClipboardLockStats ClipboardLock::stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void ClipboardLock::RecordAcquire(bool success, uint32_t attempts,
+                                  uint64_t wait_micros) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (success) {
+    stats_.acquisitions++;
+  } else {
+    stats_.failures++;
+  }
+  if (attempts > 1) {
+    stats_.contended++;
+  }
+  stats_.attempts += attempts;
+  stats_.wait_micros += wait_micros;
+  stats_.max_wait_micros = std::max(stats_.max_wait_micros, wait_micros);
+}
+
+void ClipboardLock::RecordRelease(uint64_t hold_micros) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.hold_micros += hold_micros;
+  stats_.max_hold_micros = std::max(stats_.max_hold_micros, hold_micros);
+}
+
+ClipboardSession::ClipboardSession(HWND owner, ClipboardLock* lock)
+    : ClipboardSession(owner, lock, lock->options()) {}
+
+ClipboardSession::ClipboardSession(HWND owner, ClipboardLock* lock,
+                                   const ClipboardAcquireOptions& options)
+    : owner_(owner), lock_(lock), options_(options) {
+  Open();
+}
+
+ClipboardSession::~ClipboardSession() {
+  Close();
+}
+
+bool ClipboardSession::Open() {
+  if (open_) {
+    return true;
+  }
+  if (t_in_batch) {
+    open_ = true;
+    joined_ = true;
+    return true;
+  }
+  const auto start = Clock::now();
+  const auto deadline = start + std::chrono::milliseconds(options_.timeout_ms);
+  uint32_t backoff = options_.initial_backoff_ms;
+  uint32_t attempts = 0;
+  for (;;) {
+    attempts++;
+    if (OpenClipboard(owner_)) {
+      open_ = true;
+      break;
+    }
+    const auto now = Clock::now();
+    if (now >= deadline) {
+      break;
+    }
+    const auto remaining =
+        std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now)
+            .count();
+    WaitDispatchingSentMessages(static_cast<uint32_t>(
+        std::min<long long>(backoff, std::max<long long>(remaining, 1))));
+    backoff = std::min(std::max(backoff * 2, 1u), options_.max_backoff_ms);
+  }
+
+  const uint64_t wait_micros = ElapsedMicros(start);
+  attempts_ += attempts;
+  wait_micros_ += wait_micros;
+  if (lock_) {
+    lock_->RecordAcquire(open_, attempts, wait_micros);
+  }
+  opened_at_ = Clock::now();
+  return open_;
+}
+
+void ClipboardSession::Close() {
+  if (!open_) {
+    return;
+  }
+  if (joined_) {
+    open_ = false;
+    joined_ = false;
+    return;
+  }
+  CloseClipboard();
+  open_ = false;
+  if (lock_) {
+    lock_->RecordRelease(ElapsedMicros(opened_at_));
+  }
+}
+
+ClipboardBatch::ClipboardBatch(HWND owner, ClipboardLock* lock,
+                               const ClipboardAcquireOptions& options)
+    : session_(owner, lock, options) {
+  if (session_.is_open() && !t_in_batch) {
+    outermost_ = true;
+    t_in_batch = true;
+  }
+}
+
+// Clears the flag before |session_| is destroyed, so that it really closes.
+ClipboardBatch::~ClipboardBatch() {
+  if (outermost_) {
+    t_in_batch = false;
+  }
+}
+
+}  // namespace clipboard
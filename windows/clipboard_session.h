@@ -0,0 +1,130 @@
+#ifndef CLIPBOARD_SESSION_H_
+#define CLIPBOARD_SESSION_H_
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace clipboard {
+
+// How long to keep retrying OpenClipboard while another process holds the
+// clipboard. Waits start at |initial_backoff_ms| and double up to
+// |max_backoff_ms|; a |timeout_ms| of 0 makes a single attempt.
+struct ClipboardAcquireOptions {
+  uint32_t timeout_ms = 500;
+  uint32_t initial_backoff_ms = 1;
+  uint32_t max_backoff_ms = 50;
+};
+
+struct ClipboardLockStats {
+  // Successful opens, and opens abandoned at the deadline.
+  uint64_t acquisitions = 0;
+  uint64_t failures = 0;
+  // Opens (successful or not) that needed more than one attempt.
+  uint64_t contended = 0;
+  // OpenClipboard calls in total.
+  uint64_t attempts = 0;
+  // Time spent waiting for the lock and holding it, in microseconds.
+  uint64_t wait_micros = 0;
+  uint64_t max_wait_micros = 0;
+  uint64_t hold_micros = 0;
+  uint64_t max_hold_micros = 0;
+};
+
+// Acquisition policy and counters shared by all sessions. Thread-safe.
+class ClipboardLock {
+ public:
+  ClipboardLock() {}
+
+  ClipboardLock(const ClipboardLock&) = delete;
+  ClipboardLock& operator=(const ClipboardLock&) = delete;
+
+  ClipboardAcquireOptions options();
+  void set_options(const ClipboardAcquireOptions& options);
+
+  ClipboardLockStats stats();
+
+ private:
+  friend class ClipboardSession;
+
+  void RecordAcquire(bool success, uint32_t attempts, uint64_t wait_micros);
+  void RecordRelease(uint64_t hold_micros);
+
+  std::mutex mutex_;
+  ClipboardAcquireOptions options_;
+  ClipboardLockStats stats_;
+};
+
+// Holds the system clipboard open for its lifetime. Opening retries with
+// exponential backoff until the deadline; while waiting, messages sent to
+// the calling thread's windows (such as WM_RENDERFORMAT from the process
+// holding the lock) are still answered. Inside a ClipboardBatch on the same
+// thread a session joins the batch instead: it opens at once, and closing
+// it leaves the clipboard open.
+class ClipboardSession {
+ public:
+  // Opens the clipboard for |owner| (may be nullptr) using the options of
+  // |lock|, which also receives the timings.
+  ClipboardSession(HWND owner, ClipboardLock* lock);
+  ClipboardSession(HWND owner, ClipboardLock* lock,
+                   const ClipboardAcquireOptions& options);
+  ~ClipboardSession();
+
+  ClipboardSession(const ClipboardSession&) = delete;
+  ClipboardSession& operator=(const ClipboardSession&) = delete;
+
+  // Acquires the clipboard again after Close(). Returns is_open().
+  bool Open();
+
+  // Releases the clipboard early.
+  void Close();
+
+  bool is_open() const { return open_; }
+
+  // OpenClipboard calls and total wait across all Open() calls.
+  uint32_t attempts() const { return attempts_; }
+  uint64_t wait_micros() const { return wait_micros_; }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  HWND owner_;
+  ClipboardLock* lock_;
+  ClipboardAcquireOptions options_;
+  bool open_ = false;
+  // Open only as part of the enclosing batch's acquisition.
+  bool joined_ = false;
+  uint32_t attempts_ = 0;
+  uint64_t wait_micros_ = 0;
+  Clock::time_point opened_at_;
+};
+
+// Keeps the clipboard open on the calling thread for its lifetime, so that
+// the sessions of several operations share a single acquisition. Nested
+// batches join the outermost one.
+class ClipboardBatch {
+ public:
+  ClipboardBatch(HWND owner, ClipboardLock* lock,
+                 const ClipboardAcquireOptions& options);
+  ~ClipboardBatch();
+
+  ClipboardBatch(const ClipboardBatch&) = delete;
+  ClipboardBatch& operator=(const ClipboardBatch&) = delete;
+
+  bool is_open() const { return session_.is_open(); }
+
+  const ClipboardSession& session() const { return session_; }
+
+ private:
+  ClipboardSession session_;
+  bool outermost_ = false;
+};
+
+}  // namespace clipboard
+
+#endif  // CLIPBOARD_SESSION_H_
@@ -0,0 +1,176 @@
+#include "clipboard_worker.h"
+
+#include <utility>
+
+namespace clipboard {
+
+namespace {
+
+// Posted to a worker or runner window when its task queue becomes non-empty.
+constexpr UINT kRunTasksMessage = WM_APP + 1;
+
+HWND CreateMessageWindow(const wchar_t* class_name, WNDPROC window_proc,
+                         void* instance) {
+  HMODULE module = nullptr;
+  GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                         GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                     reinterpret_cast<LPCWSTR>(window_proc), &module);
+
+  WNDCLASSEXW window_class = {};
+  if (!GetClassInfoExW(module, class_name, &window_class)) {
+    window_class.cbSize = sizeof(window_class);
+    window_class.lpfnWndProc = window_proc;
+    window_class.hInstance = module;
+    window_class.lpszClassName = class_name;
+    RegisterClassExW(&window_class);
+  }
+
+  return CreateWindowExW(0, class_name, L"", 0, 0, 0, 0, 0, HWND_MESSAGE,
+                         nullptr, module, instance);
+}
+
+// Stores the CreateWindowExW parameter on WM_NCCREATE and returns it for
+// every later message; nullptr until then.
+template <typename T>
+T* InstanceFromWindow(HWND hwnd, UINT message, LPARAM lparam) {
+  if (message == WM_NCCREATE) {
+    auto* create_struct = reinterpret_cast<CREATESTRUCTW*>(lparam);
+    SetWindowLongPtrW(hwnd, GWLP_USERDATA,
+                      reinterpret_cast<LONG_PTR>(create_struct->lpCreateParams));
+  }
+  return reinterpret_cast<T*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+}
+
+// Appends |task| and reports whether the queue was empty, i.e. whether the
+// consumer needs a new wake-up message.
+bool PushTask(std::mutex& mutex, std::deque<std::function<void()>>& tasks,
+              std::function<void()> task) {
+  std::lock_guard<std::mutex> lock(mutex);
+  bool was_empty = tasks.empty();
+  tasks.push_back(std::move(task));
+  return was_empty;
+}
+
+bool PopTask(std::mutex& mutex, std::deque<std::function<void()>>& tasks,
+             std::function<void()>* task) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (tasks.empty()) {
+    return false;
+  }
+  *task = std::move(tasks.front());
+  tasks.pop_front();
+  return true;
+}
+
+}  // namespace
+
+PlatformTaskRunner::PlatformTaskRunner() {
+  window_ = CreateMessageWindow(L"ClipboardPluginPlatformTaskWindow",
+                                &PlatformTaskRunner::WindowProc, this);
+}
+
+PlatformTaskRunner::~PlatformTaskRunner() {
+  if (window_) {
+    DestroyWindow(window_);
+    window_ = nullptr;
+  }
+}
+
+void PlatformTaskRunner::Post(std::function<void()> task) {
+  if (PushTask(mutex_, tasks_, std::move(task)) && window_) {
+    PostMessageW(window_, kRunTasksMessage, 0, 0);
+  }
+}
+
+void PlatformTaskRunner::RunPendingTasks() {
+  std::function<void()> task;
+  while (PopTask(mutex_, tasks_, &task)) {
+    task();
+  }
+}
+
+LRESULT CALLBACK PlatformTaskRunner::WindowProc(HWND hwnd, UINT message,
+                                                WPARAM wparam, LPARAM lparam) {
+  auto* runner = InstanceFromWindow<PlatformTaskRunner>(hwnd, message, lparam);
+  if (runner && message == kRunTasksMessage) {
+    runner->RunPendingTasks();
+    return 0;
+  }
+  return DefWindowProcW(hwnd, message, wparam, lparam);
+}
+
+ClipboardWorker::ClipboardWorker(WindowMessageHandler handler)
+    : handler_(std::move(handler)) {
+  HANDLE ready_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+  if (!ready_event) {
+    return;
+  }
+  thread_ = std::thread([this, ready_event] { ThreadMain(ready_event); });
+  WaitForSingleObject(ready_event, INFINITE);
+  CloseHandle(ready_event);
+}
+
+ClipboardWorker::~ClipboardWorker() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  if (window_) {
+    // Queued behind all earlier tasks, so those still run.
+    Post([] { PostQuitMessage(0); });
+  }
+  thread_.join();
+}
+
+void ClipboardWorker::Post(std::function<void()> task) {
+  outstanding_tasks_++;
+  if (PushTask(mutex_, tasks_, std::move(task)) && window_) {
+    PostMessageW(window_, kRunTasksMessage, 0, 0);
+  }
+}
+
+void ClipboardWorker::ThreadMain(HANDLE ready_event) {
+  window_ = CreateMessageWindow(L"ClipboardPluginOwnerWindow",
+                                &ClipboardWorker::WindowProc, this);
+  SetEvent(ready_event);
+  if (!window_) {
+    return;
+  }
+
+  MSG message;
+  while (GetMessageW(&message, nullptr, 0, 0) > 0) {
+    TranslateMessage(&message);
+    DispatchMessageW(&message);
+  }
+
+  // Destroying the clipboard owner sends WM_RENDERALLFORMATS, which the
+  // handler answers here, on the thread that owns the window.
+  DestroyWindow(window_);
+}
+
+void ClipboardWorker::RunPendingTasks() {
+  std::function<void()> task;
+  while (PopTask(mutex_, tasks_, &task)) {
+    task();
+    task = nullptr;
+    outstanding_tasks_--;
+  }
+}
+
+LRESULT CALLBACK ClipboardWorker::WindowProc(HWND hwnd, UINT message,
+                                             WPARAM wparam, LPARAM lparam) {
+  auto* worker = InstanceFromWindow<ClipboardWorker>(hwnd, message, lparam);
+  if (worker) {
+    if (message == kRunTasksMessage) {
+      worker->RunPendingTasks();
+      return 0;
+    }
+    LRESULT result = 0;
+    if (worker->handler_ &&
+        worker->handler_(hwnd, message, wparam, lparam, &result)) {
+      return result;
+    }
+  }
+  return DefWindowProcW(hwnd, message, wparam, lparam);
+}
+
+}  // namespace clipboard
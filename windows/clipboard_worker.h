@@ -0,0 +1,92 @@
+#ifndef CLIPBOARD_WORKER_H_
+#define CLIPBOARD_WORKER_H_
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace clipboard {
+
+// Handles a message sent to a worker or runner window. Returns true and sets
+// |result| if the message was consumed.
+using WindowMessageHandler =
+    std::function<bool(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam,
+                       LRESULT* result)>;
+
+// Runs tasks posted from any thread on the thread that created it. Tasks are
+// delivered through a message-only window, so the creating thread must pump
+// messages; the Flutter runner's main loop does this for the platform thread.
+class PlatformTaskRunner {
+ public:
+  PlatformTaskRunner();
+  ~PlatformTaskRunner();
+
+  PlatformTaskRunner(const PlatformTaskRunner&) = delete;
+  PlatformTaskRunner& operator=(const PlatformTaskRunner&) = delete;
+
+  // False if the message window could not be created.
+  bool is_valid() const { return window_ != nullptr; }
+
+  void Post(std::function<void()> task);
+
+ private:
+  static LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wparam,
+                                     LPARAM lparam);
+  void RunPendingTasks();
+
+  HWND window_ = nullptr;
+  std::mutex mutex_;
+  std::deque<std::function<void()>> tasks_;
+};
+
+// Dedicated clipboard thread. It runs posted tasks in order and pumps a
+// message loop for a message-only window it owns, which can serve as the
+// clipboard owner (WM_RENDERFORMAT) and listener (WM_CLIPBOARDUPDATE) so
+// that those messages are handled off the platform thread.
+class ClipboardWorker {
+ public:
+  // |handler| receives every message for the worker window that is not a
+  // task notification. It runs on the worker thread.
+  explicit ClipboardWorker(WindowMessageHandler handler);
+
+  // Runs the tasks still queued, destroys the window on the worker thread
+  // (which renders pending delayed formats) and joins the thread.
+  ~ClipboardWorker();
+
+  ClipboardWorker(const ClipboardWorker&) = delete;
+  ClipboardWorker& operator=(const ClipboardWorker&) = delete;
+
+  // False if the thread or its window could not be started.
+  bool is_valid() const { return window_ != nullptr; }
+
+  HWND window() const { return window_; }
+
+  void Post(std::function<void()> task);
+
+  // True when no task is queued or running.
+  bool IsIdle() const { return outstanding_tasks_.load() == 0; }
+
+ private:
+  static LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wparam,
+                                     LPARAM lparam);
+  void ThreadMain(HANDLE ready_event);
+  void RunPendingTasks();
+
+  WindowMessageHandler handler_;
+  HWND window_ = nullptr;
+  std::thread thread_;
+  std::mutex mutex_;
+  std::deque<std::function<void()>> tasks_;
+  std::atomic<int> outstanding_tasks_{0};
+};
+
+}  // namespace clipboard
+
+#endif  // CLIPBOARD_WORKER_H_
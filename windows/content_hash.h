@@ -0,0 +1,19 @@
+#ifndef CONTENT_HASH_H_
+#define CONTENT_HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace clipboard {
+
+// XXH64 (xxHash, 64-bit variant) for fingerprinting clipboard payloads, so
+// changes can be detected by comparing one integer instead of transferring
+// the data. Not cryptographic. Input is consumed 32 bytes at a time by four
+// independent accumulators, which keeps the multipliers busy in parallel;
+// results match the reference implementation, so hashes are stable across
+// runs and machines and may be persisted.
+uint64_t Xxh64(const void* data, size_t size, uint64_t seed = 0);
+
+}  // namespace clipboard
+
+#endif  // CONTENT_HASH_H_
@@ -0,0 +1,705 @@
+#include "deflate.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "thread_pool.h"
+
+namespace clipboard {
+
+namespace {
+
+constexpr size_t kWindowSize = 1 << 15;
+constexpr size_t kWindowMask = kWindowSize - 1;
+// Distances reach one short of the window so a chain never revisits the
+// slot of the position being inserted.
+constexpr size_t kMaxDistance = kWindowSize - 1;
+constexpr int kHashBits = 15;
+constexpr size_t kMinMatch = 3;
+constexpr size_t kMaxMatch = 258;
+// Search effort: candidates tried per position, and the length at which the
+// first match found is taken.
+constexpr int kMaxChain = 16;
+constexpr size_t kNiceMatch = 64;
+// Symbols gathered before a block is written with its own Huffman code.
+constexpr size_t kBlockSymbols = 1 << 16;
+constexpr size_t kMaxStoredBlock = 65535;
+// Smallest input piece worth compressing on its own thread.
+constexpr size_t kMinPieceSize = 256 * 1024;
+
+constexpr int kLiteralLengthCodes = 286;
+constexpr int kFixedLiteralLengthCodes = 288;
+constexpr int kDistanceCodes = 30;
+constexpr int kCodeLengthCodes = 19;
+constexpr int kEndOfBlock = 256;
+constexpr int kMaxCodeBits = 15;
+constexpr int kMaxCodeLengthBits = 7;
+
+constexpr uint16_t kLengthBase[29] = {
+    3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+    31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr uint8_t kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                      1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                      4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr uint16_t kDistanceBase[30] = {
+    1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+    33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr uint8_t kDistanceExtra[30] = {0, 0, 0, 0, 1, 1, 2,  2,  3,  3,
+                                        4, 4, 5, 5, 6, 6, 7,  7,  8,  8,
+                                        9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+constexpr uint8_t kCodeLengthOrder[kCodeLengthCodes] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+constexpr uint8_t kCodeLengthExtra[kCodeLengthCodes] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 3, 7};
+
+struct Tables {
+  uint8_t length_code[kMaxMatch + 1];
+  // Indexed by distance - 1 below 256, else by 256 + ((distance - 1) >> 7).
+  uint8_t distance_code[512];
+  uint8_t fixed_literal_lengths[kFixedLiteralLengthCodes];
+  uint8_t fixed_distance_lengths[kDistanceCodes];
+  uint32_t crc[256];
+};
+
+const Tables& GetTables() {
+  static const Tables tables = [] {
+    Tables t = {};
+    for (int code = 0; code < 29; code++) {
+      for (size_t length = kLengthBase[code];
+           length < kLengthBase[code] + (1u << kLengthExtra[code]) &&
+           length <= kMaxMatch;
+           length++) {
+        t.length_code[length] = static_cast<uint8_t>(code);
+      }
+    }
+    for (int i = 0; i < 512; i++) {
+      const uint32_t index = static_cast<uint32_t>(i);
+      const uint32_t distance = i < 256 ? index + 1 : ((index - 256) << 7) + 1;
+      uint8_t code = 0;
+      while (code + 1 < kDistanceCodes && kDistanceBase[code + 1] <= distance) {
+        code++;
+      }
+      t.distance_code[i] = code;
+    }
+    for (int i = 0; i < kFixedLiteralLengthCodes; i++) {
+      t.fixed_literal_lengths[i] =
+          static_cast<uint8_t>(i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8);
+    }
+    for (int i = 0; i < kDistanceCodes; i++) {
+      t.fixed_distance_lengths[i] = 5;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++) {
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      }
+      t.crc[i] = c;
+    }
+    return t;
+  }();
+  return tables;
+}
+
+inline int DistanceCode(const Tables& tables, size_t distance) {
+  const size_t d = distance - 1;
+  return tables.distance_code[d < 256 ? d : 256 + (d >> 7)];
+}
+
+// One LZ77 output: a literal byte (length 0) or a back reference.
+struct Symbol {
+  uint16_t length;
+  uint16_t value;  // Literal byte or match distance.
+};
+
+// Packs bits LSB first, as deflate requires.
+class BitWriter {
+ public:
+  explicit BitWriter(std::vector<uint8_t>* out) : out_(out) {}
+
+  void Write(uint32_t bits, int count) {
+    buffer_ |= static_cast<uint64_t>(bits) << count_;
+    count_ += count;
+    while (count_ >= 8) {
+      out_->push_back(static_cast<uint8_t>(buffer_));
+      buffer_ >>= 8;
+      count_ -= 8;
+    }
+  }
+
+  void AlignToByte() {
+    if (count_ > 0) {
+      out_->push_back(static_cast<uint8_t>(buffer_));
+    }
+    buffer_ = 0;
+    count_ = 0;
+  }
+
+  // Appends whole bytes; the writer must be byte aligned.
+  void WriteBytes(const uint8_t* data, size_t size) {
+    out_->insert(out_->end(), data, data + size);
+  }
+
+ private:
+  std::vector<uint8_t>* out_;
+  uint64_t buffer_ = 0;
+  int count_ = 0;
+};
+
+// Builds Huffman code lengths for |freqs| with no code longer than
+// |max_bits|. Unused symbols get length 0. When the optimal tree is too
+// deep the frequencies are flattened and the tree rebuilt.
+void BuildCodeLengths(const uint32_t* freqs, int count, int max_bits,
+                      uint8_t* lengths) {
+  std::vector<std::pair<uint32_t, int>> leaves;
+  for (int i = 0; i < count; i++) {
+    lengths[i] = 0;
+    if (freqs[i] > 0) {
+      leaves.emplace_back(freqs[i], i);
+    }
+  }
+  if (leaves.empty()) {
+    return;
+  }
+  if (leaves.size() == 1) {
+    lengths[leaves[0].second] = 1;
+    return;
+  }
+
+  const size_t n = leaves.size();
+  std::vector<uint64_t> internal(n - 1);
+  std::vector<size_t> parent(2 * n - 1);
+  std::vector<int> depth(2 * n - 1);
+  for (;;) {
+    std::stable_sort(
+        leaves.begin(), leaves.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+    // Two-queue construction: leaves in sorted order, internal nodes in
+    // creation order (which is also sorted).
+    size_t next_leaf = 0;
+    size_t next_internal = 0;
+    auto take_smallest = [&](size_t created) {
+      if (next_leaf < n &&
+          (next_internal >= created ||
+           leaves[next_leaf].first <= internal[next_internal])) {
+        const size_t index = next_leaf++;
+        return std::make_pair(static_cast<uint64_t>(leaves[index].first),
+                              index);
+      }
+      const size_t index = next_internal++;
+      return std::make_pair(internal[index], n + index);
+    };
+    for (size_t k = 0; k < n - 1; k++) {
+      auto a = take_smallest(k);
+      auto b = take_smallest(k);
+      internal[k] = a.first + b.first;
+      parent[a.second] = n + k;
+      parent[b.second] = n + k;
+    }
+    depth[2 * n - 2] = 0;
+    for (size_t node = 2 * n - 2; node-- > 0;) {
+      depth[node] = depth[parent[node]] + 1;
+    }
+    bool fits = true;
+    for (size_t i = 0; i < n; i++) {
+      fits = fits && depth[i] <= max_bits;
+    }
+    if (fits) {
+      for (size_t i = 0; i < n; i++) {
+        lengths[leaves[i].second] = static_cast<uint8_t>(depth[i]);
+      }
+      return;
+    }
+    for (auto& leaf : leaves) {
+      leaf.first = (leaf.first + 1) / 2;
+    }
+  }
+}
+
+// Canonical codes for |lengths|, bit-reversed for the LSB-first writer.
+void BuildCodes(const uint8_t* lengths, int count, uint16_t* codes) {
+  int length_count[kMaxCodeBits + 1] = {};
+  for (int i = 0; i < count; i++) {
+    length_count[lengths[i]]++;
+  }
+  length_count[0] = 0;
+  uint32_t next_code[kMaxCodeBits + 1] = {};
+  uint32_t code = 0;
+  for (int bits = 1; bits <= kMaxCodeBits; bits++) {
+    code = (code + static_cast<uint32_t>(length_count[bits - 1])) << 1;
+    next_code[bits] = code;
+  }
+  for (int i = 0; i < count; i++) {
+    const int length = lengths[i];
+    if (length == 0) {
+      codes[i] = 0;
+      continue;
+    }
+    uint32_t value = next_code[length]++;
+    uint32_t reversed = 0;
+    for (int bit = 0; bit < length; bit++) {
+      reversed = (reversed << 1) | (value & 1);
+      value >>= 1;
+    }
+    codes[i] = static_cast<uint16_t>(reversed);
+  }
+}
+
+// Gives at least two symbols a nonzero frequency; inflaters reject
+// single-code trees for some alphabets.
+void EnsureTwoCodes(uint32_t* freqs, int count) {
+  int used = 0;
+  for (int i = 0; i < count; i++) {
+    used += freqs[i] > 0 ? 1 : 0;
+  }
+  for (int i = 0; i < count && used < 2; i++) {
+    if (freqs[i] == 0) {
+      freqs[i] = 1;
+      used++;
+    }
+  }
+}
+
+struct CodeLengthSymbol {
+  uint8_t symbol;
+  uint8_t extra;
+};
+
+// Run-length codes the concatenated code lengths with symbols 16-18.
+void EncodeCodeLengths(const uint8_t* lengths, size_t count,
+                       std::vector<CodeLengthSymbol>* out) {
+  auto emit = [out](int symbol, size_t extra) {
+    out->push_back({static_cast<uint8_t>(symbol), static_cast<uint8_t>(extra)});
+  };
+  size_t i = 0;
+  while (i < count) {
+    const uint8_t length = lengths[i];
+    size_t run = 1;
+    while (i + run < count && lengths[i + run] == length) {
+      run++;
+    }
+    i += run;
+    if (length == 0) {
+      while (run >= 11) {
+        const size_t repeat = std::min<size_t>(run, 138);
+        emit(18, repeat - 11);
+        run -= repeat;
+      }
+      if (run >= 3) {
+        emit(17, run - 3);
+        run = 0;
+      }
+    } else {
+      emit(length, 0);
+      run--;
+      while (run >= 3) {
+        const size_t repeat = std::min<size_t>(run, 6);
+        emit(16, repeat - 3);
+        run -= repeat;
+      }
+    }
+    for (; run > 0; run--) {
+      emit(length, 0);
+    }
+  }
+}
+
+// Bits needed for the block's symbols (excluding headers) under a code.
+uint64_t SymbolCost(const uint32_t* literal_freqs,
+                    const uint8_t* literal_lengths,
+                    const uint32_t* distance_freqs,
+                    const uint8_t* distance_lengths) {
+  uint64_t bits = 0;
+  for (int i = 0; i < kLiteralLengthCodes; i++) {
+    bits += static_cast<uint64_t>(literal_freqs[i]) * literal_lengths[i];
+  }
+  for (int i = 0; i < 29; i++) {
+    bits += static_cast<uint64_t>(literal_freqs[kEndOfBlock + 1 + i]) *
+            kLengthExtra[i];
+  }
+  for (int i = 0; i < kDistanceCodes; i++) {
+    bits += static_cast<uint64_t>(distance_freqs[i]) *
+            (distance_lengths[i] + kDistanceExtra[i]);
+  }
+  return bits;
+}
+
+void WriteStored(const uint8_t* data, size_t size, bool final,
+                 BitWriter* writer) {
+  do {
+    const size_t chunk = std::min(size, kMaxStoredBlock);
+    const bool last = final && chunk == size;
+    writer->Write(last ? 1 : 0, 3);
+    writer->AlignToByte();
+    const uint8_t header[4] = {
+        static_cast<uint8_t>(chunk), static_cast<uint8_t>(chunk >> 8),
+        static_cast<uint8_t>(~chunk), static_cast<uint8_t>(~chunk >> 8)};
+    writer->WriteBytes(header, sizeof(header));
+    writer->WriteBytes(data, chunk);
+    data += chunk;
+    size -= chunk;
+  } while (size > 0);
+}
+
+void WriteSymbols(const Symbol* symbols, size_t count,
+                  const uint8_t* literal_lengths,
+                  const uint16_t* literal_codes,
+                  const uint8_t* distance_lengths,
+                  const uint16_t* distance_codes, BitWriter* writer) {
+  const Tables& tables = GetTables();
+  for (size_t i = 0; i < count; i++) {
+    const Symbol& symbol = symbols[i];
+    if (symbol.length == 0) {
+      writer->Write(literal_codes[symbol.value], literal_lengths[symbol.value]);
+      continue;
+    }
+    const int length_code = tables.length_code[symbol.length];
+    const int literal = kEndOfBlock + 1 + length_code;
+    writer->Write(literal_codes[literal], literal_lengths[literal]);
+    if (kLengthExtra[length_code] > 0) {
+      writer->Write(
+          static_cast<uint32_t>(symbol.length - kLengthBase[length_code]),
+          kLengthExtra[length_code]);
+    }
+    const int distance_code = DistanceCode(tables, symbol.value);
+    writer->Write(distance_codes[distance_code],
+                  distance_lengths[distance_code]);
+    if (kDistanceExtra[distance_code] > 0) {
+      writer->Write(
+          static_cast<uint32_t>(symbol.value - kDistanceBase[distance_code]),
+          kDistanceExtra[distance_code]);
+    }
+  }
+  writer->Write(literal_codes[kEndOfBlock], literal_lengths[kEndOfBlock]);
+}
+
+// Writes one block covering |raw|, whose LZ77 parse is |symbols|, in the
+// cheapest of the three block types.
+void WriteBlock(const Symbol* symbols, size_t count, const uint8_t* raw,
+                size_t raw_size, bool final, BitWriter* writer) {
+  const Tables& tables = GetTables();
+  uint32_t literal_freqs[kFixedLiteralLengthCodes] = {};
+  uint32_t distance_freqs[kDistanceCodes] = {};
+  for (size_t i = 0; i < count; i++) {
+    const Symbol& symbol = symbols[i];
+    if (symbol.length == 0) {
+      literal_freqs[symbol.value]++;
+    } else {
+      literal_freqs[kEndOfBlock + 1 + tables.length_code[symbol.length]]++;
+      distance_freqs[DistanceCode(tables, symbol.value)]++;
+    }
+  }
+  literal_freqs[kEndOfBlock] = 1;
+
+  // Dynamic code.
+  uint32_t tree_literal_freqs[kLiteralLengthCodes];
+  uint32_t tree_distance_freqs[kDistanceCodes];
+  std::copy(literal_freqs, literal_freqs + kLiteralLengthCodes,
+            tree_literal_freqs);
+  std::copy(distance_freqs, distance_freqs + kDistanceCodes,
+            tree_distance_freqs);
+  EnsureTwoCodes(tree_literal_freqs, kLiteralLengthCodes);
+  EnsureTwoCodes(tree_distance_freqs, kDistanceCodes);
+  uint8_t literal_lengths[kLiteralLengthCodes];
+  uint8_t distance_lengths[kDistanceCodes];
+  BuildCodeLengths(tree_literal_freqs, kLiteralLengthCodes, kMaxCodeBits,
+                   literal_lengths);
+  BuildCodeLengths(tree_distance_freqs, kDistanceCodes, kMaxCodeBits,
+                   distance_lengths);
+  int literal_count = kLiteralLengthCodes;
+  while (literal_count > 257 && literal_lengths[literal_count - 1] == 0) {
+    literal_count--;
+  }
+  int distance_count = kDistanceCodes;
+  while (distance_count > 1 && distance_lengths[distance_count - 1] == 0) {
+    distance_count--;
+  }
+  // The header sends both code length sets as one run-length coded list
+  uint8_t lengths[kLiteralLengthCodes + kDistanceCodes];
+  std::copy(literal_lengths, literal_lengths + literal_count, lengths);
+  std::copy(distance_lengths, distance_lengths + distance_count,
+            lengths + literal_count);
+
+  std::vector<CodeLengthSymbol> code_length_symbols;
+  EncodeCodeLengths(lengths,
+                    static_cast<size_t>(literal_count + distance_count),
+                    &code_length_symbols);
+  uint32_t code_length_freqs[kCodeLengthCodes] = {};
+  for (const auto& symbol : code_length_symbols) {
+    code_length_freqs[symbol.symbol]++;
+  }
+  EnsureTwoCodes(code_length_freqs, kCodeLengthCodes);
+  uint8_t code_length_lengths[kCodeLengthCodes];
+  BuildCodeLengths(code_length_freqs, kCodeLengthCodes, kMaxCodeLengthBits,
+                   code_length_lengths);
+  int code_length_count = kCodeLengthCodes;
+  while (code_length_count > 4 &&
+         code_length_lengths[kCodeLengthOrder[code_length_count - 1]] == 0) {
+    code_length_count--;
+  }
+
+  // Block sizes in bits, headers included.
+  uint64_t dynamic_bits =
+      3 + 5 + 5 + 4 + 3 * static_cast<uint64_t>(code_length_count);
+  for (const auto& symbol : code_length_symbols) {
+    dynamic_bits += static_cast<uint64_t>(code_length_lengths[symbol.symbol]) +
+                    kCodeLengthExtra[symbol.symbol];
+  }
+  dynamic_bits += SymbolCost(literal_freqs, literal_lengths, distance_freqs,
+                             distance_lengths);
+  const uint64_t fixed_bits =
+      3 + SymbolCost(literal_freqs, tables.fixed_literal_lengths,
+                     distance_freqs, tables.fixed_distance_lengths);
+  const uint64_t stored_blocks = std::max<uint64_t>(
+      1, (raw_size + kMaxStoredBlock - 1) / kMaxStoredBlock);
+  const uint64_t stored_bits = (raw_size + 5 * stored_blocks) * 8;
+
+  if (stored_bits < dynamic_bits && stored_bits < fixed_bits) {
+    WriteStored(raw, raw_size, final, writer);
+    return;
+  }
+
+  if (fixed_bits <= dynamic_bits) {
+    uint16_t literal_codes[kFixedLiteralLengthCodes];
+    uint16_t distance_codes[kDistanceCodes];
+    BuildCodes(tables.fixed_literal_lengths, kFixedLiteralLengthCodes,
+               literal_codes);
+    BuildCodes(tables.fixed_distance_lengths, kDistanceCodes, distance_codes);
+    writer->Write(final ? 1 : 0, 1);
+    writer->Write(1, 2);
+    WriteSymbols(symbols, count, tables.fixed_literal_lengths, literal_codes,
+                 tables.fixed_distance_lengths, distance_codes, writer);
+    return;
+  }
+
+  uint16_t literal_codes[kLiteralLengthCodes];
+  uint16_t distance_codes[kDistanceCodes];
+  uint16_t code_length_codes[kCodeLengthCodes];
+  BuildCodes(literal_lengths, kLiteralLengthCodes, literal_codes);
+  BuildCodes(distance_lengths, kDistanceCodes, distance_codes);
+  BuildCodes(code_length_lengths, kCodeLengthCodes, code_length_codes);
+  writer->Write(final ? 1 : 0, 1);
+  writer->Write(2, 2);
+  writer->Write(static_cast<uint32_t>(literal_count - 257), 5);
+  writer->Write(static_cast<uint32_t>(distance_count - 1), 5);
+  writer->Write(static_cast<uint32_t>(code_length_count - 4), 4);
+  for (int i = 0; i < code_length_count; i++) {
+    writer->Write(code_length_lengths[kCodeLengthOrder[i]], 3);
+  }
+  for (const auto& symbol : code_length_symbols) {
+    writer->Write(code_length_codes[symbol.symbol],
+                  code_length_lengths[symbol.symbol]);
+    if (kCodeLengthExtra[symbol.symbol] > 0) {
+      writer->Write(symbol.extra, kCodeLengthExtra[symbol.symbol]);
+    }
+  }
+  WriteSymbols(symbols, count, literal_lengths, literal_codes, distance_lengths,
+               distance_codes, writer);
+}
+
+inline uint32_t Hash(const uint8_t* p) {
+  const uint32_t value = static_cast<uint32_t>(p[0]) |
+                         (static_cast<uint32_t>(p[1]) << 8) |
+                         (static_cast<uint32_t>(p[2]) << 16);
+  return (value * 0x9E3779B1u) >> (32 - kHashBits);
+}
+
+inline size_t MatchLength(const uint8_t* a, const uint8_t* b,
+                          size_t max_length) {
+  size_t length = 0;
+  while (length + 8 <= max_length) {
+    uint64_t x;
+    uint64_t y;
+    memcpy(&x, a + length, sizeof(x));
+    memcpy(&y, b + length, sizeof(y));
+    if (x != y) {
+      break;
+    }
+    length += 8;
+  }
+  while (length < max_length && a[length] == b[length]) {
+    length++;
+  }
+  return length;
+}
+
+}  // namespace
+
+uint32_t Crc32(uint32_t crc, const uint8_t* data, size_t size) {
+  const uint32_t* table = GetTables().crc;
+  crc = ~crc;
+  for (size_t i = 0; i < size; i++) {
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+uint32_t Adler32(uint32_t adler, const uint8_t* data, size_t size) {
+  constexpr uint32_t kModulus = 65521;
+  // Largest run before the sums can overflow 32 bits.
+  constexpr size_t kMaxRun = 5552;
+  uint32_t a = adler & 0xFFFF;
+  uint32_t b = adler >> 16;
+  while (size > 0) {
+    const size_t run = std::min(size, kMaxRun);
+    size -= run;
+    for (size_t i = 0; i < run; i++) {
+      a += *data++;
+      b += a;
+    }
+    a %= kModulus;
+    b %= kModulus;
+  }
+  return (b << 16) | a;
+}
+
+void DeflateAppend(const uint8_t* data, size_t size, size_t history,
+                   DeflateFlush flush, std::vector<uint8_t>* out) {
+  // Work on history + data, starting the parse after the history.
+  history = std::min(history, kMaxDistance);
+  data -= history;
+  size += history;
+  BitWriter writer(out);
+  const bool finish = flush == DeflateFlush::kFinish;
+  std::vector<ptrdiff_t> head(size_t{1} << kHashBits, -1);
+  std::vector<ptrdiff_t> prev(kWindowSize, -1);
+  std::vector<Symbol> symbols;
+  symbols.reserve(std::min(kBlockSymbols, size + 1));
+
+  auto insert = [&](size_t pos) {
+    const uint32_t hash = Hash(data + pos);
+    prev[pos & kWindowMask] = head[hash];
+    head[hash] = static_cast<ptrdiff_t>(pos);
+  };
+
+  for (size_t p = 0; p < history && p + kMinMatch <= size; p++) {
+    insert(p);
+  }
+
+  size_t block_start = history;
+  size_t pos = history;
+  while (pos < size) {
+    size_t best_length = 0;
+    size_t best_distance = 0;
+    if (size - pos >= kMinMatch) {
+      const uint32_t hash = Hash(data + pos);
+      ptrdiff_t candidate = head[hash];
+      prev[pos & kWindowMask] = candidate;
+      head[hash] = static_cast<ptrdiff_t>(pos);
+      const size_t max_length = std::min(kMaxMatch, size - pos);
+      for (int chain = kMaxChain;
+           chain > 0 && candidate >= 0 &&
+           pos - static_cast<size_t>(candidate) <= kMaxDistance;
+           chain--) {
+        const uint8_t* match = data + candidate;
+        if (match[best_length] == data[pos + best_length]) {
+          const size_t length = MatchLength(match, data + pos, max_length);
+          if (length > best_length) {
+            best_length = length;
+            best_distance = pos - static_cast<size_t>(candidate);
+            if (length >= kNiceMatch || length == max_length) {
+              break;
+            }
+          }
+        }
+        candidate = prev[static_cast<size_t>(candidate) & kWindowMask];
+      }
+    }
+
+    if (best_length >= kMinMatch) {
+      symbols.push_back({static_cast<uint16_t>(best_length),
+                         static_cast<uint16_t>(best_distance)});
+      const size_t end = pos + best_length;
+      const size_t insert_end = std::min(end, size - (kMinMatch - 1));
+      for (size_t p = pos + 1; p < insert_end; p++) {
+        insert(p);
+      }
+      pos = end;
+    } else {
+      symbols.push_back({0, data[pos]});
+      pos++;
+    }
+
+    if (symbols.size() == kBlockSymbols && pos < size) {
+      WriteBlock(symbols.data(), symbols.size(), data + block_start,
+                 pos - block_start, false, &writer);
+      symbols.clear();
+      block_start = pos;
+    }
+  }
+  WriteBlock(symbols.data(), symbols.size(), data + block_start,
+             size - block_start, finish, &writer);
+
+  if (!finish) {
+    WriteStored(nullptr, 0, false, &writer);
+  }
+  writer.AlignToByte();
+}
+
+uint32_t Adler32Combine(uint32_t adler1, uint32_t adler2, size_t size2) {
+  constexpr uint32_t kModulus = 65521;
+  const uint32_t remainder = static_cast<uint32_t>(size2 % kModulus);
+  uint32_t a = adler1 & 0xFFFF;
+  uint32_t b = (remainder * a) % kModulus;
+  a += (adler2 & 0xFFFF) + kModulus - 1;
+  b += (adler1 >> 16) + (adler2 >> 16) + kModulus - remainder;
+  if (a >= kModulus) {
+    a -= kModulus;
+  }
+  if (a >= kModulus) {
+    a -= kModulus;
+  }
+  if (b >= kModulus * 2) {
+    b -= kModulus * 2;
+  }
+  if (b >= kModulus) {
+    b -= kModulus;
+  }
+  return (b << 16) | a;
+}
+
+void ZlibCompress(const uint8_t* data, size_t size, std::vector<uint8_t>* out,
+                  const ZlibOptions& options) {
+  // 32K window, no preset dictionary, "fastest" level hint.
+  out->push_back(0x78);
+  out->push_back(0x01);
+
+  const size_t piece_count =
+      std::max<size_t>(1, std::min(options.piece_count, size / kMinPieceSize));
+  uint32_t adler;
+  if (piece_count == 1 || !options.thread_pool) {
+    DeflateAppend(data, size, 0, DeflateFlush::kFinish, out);
+    adler = Adler32(1, data, size);
+  } else {
+    const size_t piece_size = (size + piece_count - 1) / piece_count;
+    std::vector<std::vector<uint8_t>> pieces(piece_count);
+    std::vector<uint32_t> adlers(piece_count);
+    options.thread_pool->ParallelFor(piece_count, [&](size_t i) {
+      const size_t begin = std::min(size, i * piece_size);
+      const size_t end = std::min(size, begin + piece_size);
+      const bool last = i + 1 == piece_count;
+      DeflateAppend(data + begin, end - begin, begin,
+                    last ? DeflateFlush::kFinish : DeflateFlush::kSync,
+                    &pieces[i]);
+      adlers[i] = Adler32(1, data + begin, end - begin);
+    });
+    size_t total = 0;
+    for (const auto& piece : pieces) {
+      total += piece.size();
+    }
+    out->reserve(out->size() + total + 4);
+    adler = 1;
+    for (size_t i = 0; i < piece_count; i++) {
+      out->insert(out->end(), pieces[i].begin(), pieces[i].end());
+      const size_t begin = std::min(size, i * piece_size);
+      adler = Adler32Combine(adler, adlers[i],
+                             std::min(size, begin + piece_size) - begin);
+    }
+  }
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    out->push_back(static_cast<uint8_t>(adler >> shift));
+  }
+}
+
+}  // namespace clipboard
@@ -0,0 +1,56 @@
+#ifndef DEFLATE_H_
+#define DEFLATE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace clipboard {
+
+class ThreadPool;
+
+// Deflate (RFC 1951) and zlib (RFC 1950) compression for the PNG encoder.
+// Matching is greedy LZ77 over hash chains; each block is written with
+// whichever of a dynamic Huffman code, the fixed code or stored bytes is
+// smallest, so incompressible input grows by a few bytes at most. None of
+// these functions keep state between calls; concurrent calls are safe.
+
+// Running checksums. Start from Crc32's 0 and Adler32's 1.
+uint32_t Crc32(uint32_t crc, const uint8_t* data, size_t size);
+uint32_t Adler32(uint32_t adler, const uint8_t* data, size_t size);
+
+enum class DeflateFlush {
+  // Ends on a byte boundary with an empty stored block (zlib's
+  // Z_SYNC_FLUSH), so more blocks can be appended.
+  kSync,
+  // Marks the last block final and pads to a byte boundary.
+  kFinish,
+};
+
+// Appends |data| to |out| as raw deflate blocks. Matches may reach back into
+// the |history| bytes preceding |data| (up to the 32 KiB window), so pieces
+// of one stream compressed separately keep most of their ratio.
+void DeflateAppend(const uint8_t* data, size_t size, size_t history,
+                   DeflateFlush flush, std::vector<uint8_t>* out);
+
+// Adler-32 of two concatenated buffers from their checksums and the second
+// buffer's size.
+uint32_t Adler32Combine(uint32_t adler1, uint32_t adler2, size_t size2);
+
+struct ZlibOptions {
+  // Pool used to compress pieces of the input concurrently. nullptr
+  // compresses on the calling thread only.
+  ThreadPool* thread_pool = nullptr;
+  // Pieces the input is split into, as pigz does: each is deflated on its
+  // own thread, primed with the 32 KiB before it and ended with a sync
+  // flush, and the checksums are combined. Pieces are at least 256 KiB.
+  size_t piece_count = 1;
+};
+
+// Appends a complete zlib stream for |data| to |out|.
+void ZlibCompress(const uint8_t* data, size_t size, std::vector<uint8_t>* out,
+                  const ZlibOptions& options = ZlibOptions());
+
+}  // namespace clipboard
+
+#endif  // DEFLATE_H_
@@ -0,0 +1,190 @@
+#include "dib_image.h"
+
+#include <cstring>
+
+namespace clipboard {
+
+namespace {
+
+// BITMAPINFOHEADER and its BITMAPV4HEADER / BITMAPV5HEADER extensions.
+constexpr uint32_t kInfoHeaderSize = 40;
+constexpr size_t kWidthOffset = 4;
+constexpr size_t kHeightOffset = 8;
+constexpr size_t kPlanesOffset = 12;
+constexpr size_t kBitCountOffset = 14;
+constexpr size_t kCompressionOffset = 16;
+constexpr size_t kColorsUsedOffset = 32;
+constexpr size_t kRedMaskOffset = 40;
+constexpr size_t kGreenMaskOffset = 44;
+constexpr size_t kBlueMaskOffset = 48;
+constexpr size_t kAlphaMaskOffset = 52;
+
+constexpr uint32_t kCompressionRgb = 0;        // BI_RGB
+constexpr uint32_t kCompressionBitfields = 3;  // BI_BITFIELDS
+
+constexpr uint32_t kRedMask = 0x00FF0000u;
+constexpr uint32_t kGreenMask = 0x0000FF00u;
+constexpr uint32_t kBlueMask = 0x000000FFu;
+constexpr uint32_t kAlphaMask = 0xFF000000u;
+
+uint32_t ReadU32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+int32_t ReadI32(const uint8_t* p) {
+  const uint32_t value = ReadU32(p);
+  int32_t result;
+  memcpy(&result, &value, sizeof(result));
+  return result;
+}
+
+uint16_t ReadU16(const uint8_t* p) {
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+bool HasVisibleAlpha(const DibImage& image) {
+  const uint8_t* row = image.pixels;
+  for (int y = 0; y < image.height; y++, row += image.stride) {
+    for (int x = 0; x < image.width; x++) {
+      if (row[x * 4 + 3] != 0) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// |explicit_offset| is where the pixels start, or 0 to compute it from the
+// header as packed DIBs require.
+bool ParseDibAt(const uint8_t* data, size_t size, uint64_t explicit_offset,
+                DibImage* image) {
+  if (size < kInfoHeaderSize) {
+    return false;
+  }
+  const uint32_t header_size = ReadU32(data);
+  if (header_size < kInfoHeaderSize || header_size > size ||
+      (header_size > kInfoHeaderSize && header_size < kBlueMaskOffset + 4)) {
+    return false;
+  }
+  const int32_t width = ReadI32(data + kWidthOffset);
+  const int32_t signed_height = ReadI32(data + kHeightOffset);
+  const uint16_t bit_count = ReadU16(data + kBitCountOffset);
+  const uint32_t compression = ReadU32(data + kCompressionOffset);
+  const uint32_t colors_used = ReadU32(data + kColorsUsedOffset);
+  if (width <= 0 || signed_height == 0 || signed_height == INT32_MIN ||
+      ReadU16(data + kPlanesOffset) != 1) {
+    return false;
+  }
+  const bool top_down = signed_height < 0;
+  const int32_t height = top_down ? -signed_height : signed_height;
+
+  // Masks live in the header from V2 on, and directly after a plain
+  // BITMAPINFOHEADER for BI_BITFIELDS.
+  uint64_t pixel_offset = header_size;
+  const uint8_t* masks = nullptr;
+  if (header_size >= kBlueMaskOffset + 4) {
+    masks = data + kRedMaskOffset;
+  } else if (compression == kCompressionBitfields) {
+    if (size < pixel_offset + 12) {
+      return false;
+    }
+    masks = data + kRedMaskOffset;
+    pixel_offset += 12;
+  }
+  const uint32_t alpha_mask = header_size >= kAlphaMaskOffset + 4
+                                  ? ReadU32(data + kAlphaMaskOffset)
+                                  : 0;
+
+  DibPixelFormat format;
+  if (bit_count == 24 && compression == kCompressionRgb) {
+    format = DibPixelFormat::kBgr;
+  } else if (bit_count == 32 && (compression == kCompressionRgb ||
+                                 compression == kCompressionBitfields)) {
+    if (compression == kCompressionBitfields &&
+        (ReadU32(masks) != kRedMask || ReadU32(masks + 4) != kGreenMask ||
+         ReadU32(masks + 8) != kBlueMask)) {
+      return false;
+    }
+    format = alpha_mask == kAlphaMask ? DibPixelFormat::kBgra
+                                      : DibPixelFormat::kBgrx;
+  } else {
+    return false;
+  }
+  if (explicit_offset != 0) {
+    // The color table may be anywhere up to the pixels; only the header
+    // and masks must not overlap them.
+    if (explicit_offset < pixel_offset) {
+      return false;
+    }
+    pixel_offset = explicit_offset;
+  } else {
+    // Above 8 bits per pixel a color table is optional and only a hint,
+    // but still sits between the header and the pixels.
+    pixel_offset += static_cast<uint64_t>(colors_used) * 4;
+  }
+
+  const uint64_t stride =
+      (static_cast<uint64_t>(width) * bit_count + 31) / 32 * 4;
+  const uint64_t pixel_bytes = stride * static_cast<uint64_t>(height);
+  if (pixel_offset > size || pixel_bytes > size - pixel_offset) {
+    return false;
+  }
+
+  const uint8_t* first_row = data + pixel_offset;
+  image->width = width;
+  image->height = height;
+  image->format = format;
+  if (top_down) {
+    image->pixels = first_row;
+    image->stride = static_cast<ptrdiff_t>(stride);
+  } else {
+    image->pixels = first_row + (pixel_bytes - stride);
+    image->stride = -static_cast<ptrdiff_t>(stride);
+  }
+  if (format == DibPixelFormat::kBgra && !HasVisibleAlpha(*image)) {
+    image->format = DibPixelFormat::kBgrx;
+  }
+  return true;
+}
+
+}  // namespace
+
+size_t DibBytesPerPixel(DibPixelFormat format) {
+  return format == DibPixelFormat::kBgr ? 3 : 4;
+}
+
+bool ParseDib(const uint8_t* data, size_t size, DibImage* image) {
+  return ParseDibAt(data, size, 0, image);
+}
+
+bool ParseDib(const uint8_t* data, size_t size, size_t pixel_offset,
+              DibImage* image) {
+  return pixel_offset != 0 && ParseDibAt(data, size, pixel_offset, image);
+}
+
+void CopyDibPixels(const DibImage& image, const PixelConvertOptions& options,
+                   uint8_t* dst) {
+  const ptrdiff_t dst_stride = static_cast<ptrdiff_t>(image.width) * 4;
+  if (image.format != DibPixelFormat::kBgr) {
+    PixelConvertOptions convert = options;
+    convert.force_opaque = image.format == DibPixelFormat::kBgrx;
+    ConvertPixelRows(image.pixels, image.stride, dst, dst_stride, image.width,
+                     image.height, convert);
+    return;
+  }
+  const int red = options.swap_red_blue ? 0 : 2;
+  const uint8_t* src_row = image.pixels;
+  for (int y = 0; y < image.height; y++, src_row += image.stride) {
+    const uint8_t* src = src_row;
+    for (int x = 0; x < image.width; x++, src += 3, dst += 4) {
+      dst[red] = src[2];
+      dst[1] = src[1];
+      dst[2 - red] = src[0];
+      dst[3] = 255;
+    }
+  }
+}
+
+}  // namespace clipboard
@@ -0,0 +1,63 @@
+#ifndef DIB_IMAGE_H_
+#define DIB_IMAGE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pixel_convert.h"
+
+namespace clipboard {
+
+// Reads packed DIBs (the CF_DIB / CF_DIBV5 layout: header, optional masks
+// and color table, then pixels) in place, without copying pixel data. Only
+// uncompressed 24- and 32-bit images are understood; palettes, 16-bit,
+// RLE and embedded JPEG/PNG are left to GDI. A DibImage borrows the memory
+// it was parsed from, e.g. a locked clipboard handle, and must not outlive
+// it.
+
+enum class DibPixelFormat {
+  // 32-bit B, G, R, A with straight alpha.
+  kBgra,
+  // 32-bit B, G, R and an undefined fourth byte; the image is opaque.
+  kBgrx,
+  // 24-bit B, G, R.
+  kBgr,
+};
+
+struct DibImage {
+  // First byte of the top row.
+  const uint8_t* pixels = nullptr;
+  // Bytes from one row to the next, negative for bottom-up DIBs.
+  ptrdiff_t stride = 0;
+  int width = 0;
+  int height = 0;
+  DibPixelFormat format = DibPixelFormat::kBgrx;
+};
+
+size_t DibBytesPerPixel(DibPixelFormat format);
+
+// Validates the DIB in |data| against |size| (e.g. GlobalSize of the
+// clipboard handle) and fills |image| with a view into |data|. A 32-bit
+// image is kBgra only when its header declares an alpha mask and at least
+// one pixel is not fully transparent; producers that leave alpha zeroed
+// would otherwise paste as invisible. Returns false for malformed or
+// unsupported DIBs.
+bool ParseDib(const uint8_t* data, size_t size, DibImage* image);
+
+// Same, for a DIB whose pixels start |pixel_offset| bytes into |data|
+// rather than right after the header, masks and color table. This is the
+// layout of .bmp files, where BITMAPFILEHEADER::bfOffBits gives the offset
+// from the start of the file. Returns false if the offset falls inside the
+// header or masks.
+bool ParseDib(const uint8_t* data, size_t size, size_t pixel_offset,
+              DibImage* image);
+
+// Copies |image| to |dst| as tightly packed top-down 32-bit pixels, width * 4
+// bytes per row, in B, G, R, A order (R, G, B, A with swap_red_blue).
+// Images without alpha come out opaque; |options| applies to the rest.
+void CopyDibPixels(const DibImage& image, const PixelConvertOptions& options,
+                   uint8_t* dst);
+
+}  // namespace clipboard
+
+#endif  // DIB_IMAGE_H_
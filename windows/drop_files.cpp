@@ -0,0 +1,51 @@
+#include "drop_files.h"
+
+#include <cstring>
+
+namespace clipboard {
+
+namespace {
+
+// DROPFILES: DWORD pFiles, POINT pt, BOOL fNC, BOOL fWide.
+constexpr size_t kHeaderSize = 20;
+constexpr size_t kFilesOffset = 0;
+constexpr size_t kWideOffset = 16;
+
+uint32_t ReadU32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+}  // namespace
+
+bool ParseDropFiles(const uint8_t* data, size_t size,
+                    std::vector<std::u16string_view>* paths) {
+  if (size < kHeaderSize || ReadU32(data + kWideOffset) == 0) {
+    return false;
+  }
+  const uint32_t files_offset = ReadU32(data + kFilesOffset);
+  // The paths are read in place as char16_t, which needs them aligned.
+  if (files_offset < kHeaderSize || files_offset > size ||
+      (reinterpret_cast<uintptr_t>(data + files_offset) &
+       (alignof(char16_t) - 1)) != 0) {
+    return false;
+  }
+  const char16_t* units =
+      reinterpret_cast<const char16_t*>(data + files_offset);
+  const size_t count = (size - files_offset) / sizeof(char16_t);
+  size_t start = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (units[i] != 0) {
+      continue;
+    }
+    if (i == start) {
+      break;
+    }
+    paths->emplace_back(units + start, i - start);
+    start = i + 1;
+  }
+  return true;
+}
+
+}  // namespace clipboard
@@ -0,0 +1,26 @@
+#ifndef DROP_FILES_H_
+#define DROP_FILES_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace clipboard {
+
+// Reader for the CF_HDROP clipboard payload: a DROPFILES header followed by
+// a list of NUL-terminated paths ending in an empty one. The list is walked
+// once, where DragQueryFile rescans it from the start for every index.
+
+// Appends views of the UTF-16 paths in |data| to |paths|. Each view is
+// followed by its NUL terminator in |data|, so it can be passed to Win32 as
+// a C string. Reads at most |size| bytes (e.g. GlobalSize of the clipboard
+// handle); a list cut short keeps the paths that end in bounds. Returns
+// false for malformed headers and for ANSI (non-fWide) lists, which need a
+// code page to decode.
+bool ParseDropFiles(const uint8_t* data, size_t size,
+                    std::vector<std::u16string_view>* paths);
+
+}  // namespace clipboard
+
+#endif  // DROP_FILES_H_
@@ -0,0 +1,100 @@
+#ifndef EVENT_QUEUE_H_
+#define EVENT_QUEUE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace clipboard {
+
+struct EventQueueStats {
+  uint64_t pushed = 0;
+  uint64_t popped = 0;
+  // Events discarded unread because newer ones filled the queue.
+  uint64_t dropped = 0;
+  size_t pending = 0;
+};
+
+// Bounded FIFO between the thread that produces change events and the one
+// that delivers them. When the consumer falls behind and the queue is full,
+// the oldest event is dropped: each event describes the whole clipboard,
+// so only the latest matters. Thread-safe.
+template <typename Value>
+class EventQueue {
+ public:
+  static constexpr size_t kDefaultCapacity = 1;
+
+  explicit EventQueue(size_t capacity = kDefaultCapacity)
+      : capacity_(capacity < 1 ? 1 : capacity) {}
+
+  EventQueue(const EventQueue&) = delete;
+  EventQueue& operator=(const EventQueue&) = delete;
+
+  // Appends |value|. Returns false if an older event was dropped for it.
+  bool Push(Value value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.pushed++;
+    values_.push_back(std::move(value));
+    return !TrimLocked();
+  }
+
+  // Moves the oldest event into |value|. Returns false if there is none.
+  bool Pop(Value* value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (values_.empty()) {
+      return false;
+    }
+    *value = std::move(values_.front());
+    values_.pop_front();
+    stats_.popped++;
+    return true;
+  }
+
+  size_t capacity() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capacity_;
+  }
+
+  // At least 1. Shrinking drops the oldest events right away.
+  void SetCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity < 1 ? 1 : capacity;
+    TrimLocked();
+  }
+
+  // Discards pending events without counting them as dropped.
+  void Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    values_.clear();
+  }
+
+  EventQueueStats stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    EventQueueStats stats = stats_;
+    stats.pending = values_.size();
+    return stats;
+  }
+
+ private:
+  // Returns true if anything was dropped.
+  bool TrimLocked() {
+    bool dropped = false;
+    while (values_.size() > capacity_) {
+      values_.pop_front();
+      stats_.dropped++;
+      dropped = true;
+    }
+    return dropped;
+  }
+
+  std::mutex mutex_;
+  size_t capacity_;
+  std::deque<Value> values_;
+  EventQueueStats stats_;
+};
+
+}  // namespace clipboard
+
+#endif  // EVENT_QUEUE_H_
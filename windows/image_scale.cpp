@@ -0,0 +1,304 @@
+#include "image_scale.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "pixel_convert.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define CLIPBOARD_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace clipboard {
+
+namespace {
+
+constexpr int kWeightBits = 14;
+constexpr int32_t kWeightRound = 1 << (kWeightBits - 1);
+constexpr double kPi = 3.14159265358979323846;
+
+// Fixed-point weights for resampling one axis: destination pixel i reads
+// count[i] source pixels from first[i], weighted by the |taps| entries of
+// |weights| at i * taps.
+struct AxisWeights {
+  std::vector<int> first;
+  std::vector<int> count;
+  std::vector<int16_t> weights;
+  int taps = 0;
+};
+
+double Sinc(double x) {
+  if (x == 0.0) {
+    return 1.0;
+  }
+  x *= kPi;
+  return std::sin(x) / x;
+}
+
+double FilterSupport(ScaleFilter filter) {
+  return filter == ScaleFilter::kBox ? 0.5 : 3.0;
+}
+
+double FilterWeight(ScaleFilter filter, double x) {
+  if (filter == ScaleFilter::kBox) {
+    return x > -0.5 && x <= 0.5 ? 1.0 : 0.0;
+  }
+  if (x <= -3.0 || x >= 3.0) {
+    return 0.0;
+  }
+  return Sinc(x) * Sinc(x / 3.0);
+}
+
+// The filter is stretched by the scale factor when shrinking, so every
+// source pixel contributes to the result.
+AxisWeights ComputeAxisWeights(int src_size, int dst_size,
+                               ScaleFilter filter) {
+  const double scale = static_cast<double>(src_size) / dst_size;
+  const double filter_scale = std::max(scale, 1.0);
+  const double support = FilterSupport(filter) * filter_scale;
+
+  AxisWeights axis;
+  axis.taps = static_cast<int>(std::ceil(support)) * 2 + 1;
+  axis.first.resize(dst_size);
+  axis.count.resize(dst_size);
+  axis.weights.assign(static_cast<size_t>(dst_size) * axis.taps, 0);
+  std::vector<double> weights(axis.taps);
+  for (int i = 0; i < dst_size; i++) {
+    const double center = (i + 0.5) * scale;
+    const int first = std::max(static_cast<int>(center - support + 0.5), 0);
+    const int end =
+        std::min(static_cast<int>(center + support + 0.5), src_size);
+    const int count = std::min(end - first, axis.taps);
+    double total = 0.0;
+    for (int k = 0; k < count; k++) {
+      weights[k] =
+          FilterWeight(filter, (first + k - center + 0.5) / filter_scale);
+      total += weights[k];
+    }
+    int16_t* fixed = &axis.weights[static_cast<size_t>(i) * axis.taps];
+    for (int k = 0; k < count && total != 0.0; k++) {
+      fixed[k] = static_cast<int16_t>(
+          std::lround(weights[k] / total * (1 << kWeightBits)));
+    }
+    axis.first[i] = first;
+    axis.count[i] = count;
+  }
+  return axis;
+}
+
+// |sum| includes kWeightRound. Lanczos lobes can overshoot either way.
+uint8_t ClampWeighted(int32_t sum) {
+  sum >>= kWeightBits;
+  return static_cast<uint8_t>(sum < 0 ? 0 : (sum > 255 ? 255 : sum));
+}
+
+// Blends |count| rows of |row_bytes|, |row_bytes| apart, from byte |start|.
+void ScaleColumnsScalar(const uint8_t* src, size_t row_bytes,
+                        const int16_t* weights, int count, uint8_t* dst,
+                        size_t start) {
+  for (size_t i = start; i < row_bytes; i++) {
+    int32_t sum = kWeightRound;
+    const uint8_t* p = src + i;
+    for (int k = 0; k < count; k++, p += row_bytes) {
+      sum += *p * weights[k];
+    }
+    dst[i] = ClampWeighted(sum);
+  }
+}
+
+void ScaleRowScalar(const uint8_t* src, uint8_t* dst, int dst_width,
+                    const AxisWeights& columns) {
+  for (int x = 0; x < dst_width; x++, dst += 4) {
+    const uint8_t* pixel = src + static_cast<size_t>(columns.first[x]) * 4;
+    const int16_t* weights =
+        &columns.weights[static_cast<size_t>(x) * columns.taps];
+    int32_t sum[4] = {kWeightRound, kWeightRound, kWeightRound, kWeightRound};
+    for (int k = 0; k < columns.count[x]; k++, pixel += 4) {
+      for (int c = 0; c < 4; c++) {
+        sum[c] += pixel[c] * weights[k];
+      }
+    }
+    for (int c = 0; c < 4; c++) {
+      dst[c] = ClampWeighted(sum[c]);
+    }
+  }
+}
+
+#if defined(CLIPBOARD_HAS_SSE2)
+
+// Two 16-bit weights in each 32-bit lane, for _mm_madd_epi16 against
+// interleaved pairs of samples.
+__m128i WeightPair(int16_t first, int16_t second) {
+  return _mm_set1_epi32(static_cast<int32_t>(
+      static_cast<uint32_t>(static_cast<uint16_t>(first)) |
+      (static_cast<uint32_t>(static_cast<uint16_t>(second)) << 16)));
+}
+
+// Narrows four 32-bit sums per vector to bytes.
+__m128i PackWeighted(__m128i low, __m128i high) {
+  low = _mm_srai_epi32(low, kWeightBits);
+  high = _mm_srai_epi32(high, kWeightBits);
+  const __m128i words = _mm_packs_epi32(low, high);
+  return _mm_packus_epi16(words, words);
+}
+
+// Each destination pixel takes the source pixels two at a time, their
+// channels interleaved (B0 B1 G0 G1 ...) so one multiply-add applies both
+// weights.
+void ScaleRowSse2(const uint8_t* src, uint8_t* dst, int dst_width,
+                  const AxisWeights& columns) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i round = _mm_set1_epi32(kWeightRound);
+  for (int x = 0; x < dst_width; x++, dst += 4) {
+    const uint8_t* pixel = src + static_cast<size_t>(columns.first[x]) * 4;
+    const int16_t* weights =
+        &columns.weights[static_cast<size_t>(x) * columns.taps];
+    const int count = columns.count[x];
+    __m128i sum = round;
+    int k = 0;
+    for (; k + 2 <= count; k += 2, pixel += 8) {
+      __m128i pair =
+          _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixel));
+      pair = _mm_unpacklo_epi8(pair, _mm_srli_si128(pair, 4));
+      pair = _mm_unpacklo_epi8(pair, zero);
+      sum = _mm_add_epi32(
+          sum, _mm_madd_epi16(pair, WeightPair(weights[k], weights[k + 1])));
+    }
+    if (k < count) {
+      int32_t last;
+      memcpy(&last, pixel, sizeof(last));
+      __m128i single = _mm_unpacklo_epi8(_mm_cvtsi32_si128(last), zero);
+      single = _mm_unpacklo_epi16(single, zero);
+      sum = _mm_add_epi32(
+          sum, _mm_madd_epi16(single, WeightPair(weights[k], 0)));
+    }
+    const int32_t packed = _mm_cvtsi128_si32(PackWeighted(sum, sum));
+    memcpy(dst, &packed, sizeof(packed));
+  }
+}
+
+// Eight bytes of a row at a time, rows taken in pairs and interleaved so
+// one multiply-add applies both weights.
+void ScaleColumnsSse2(const uint8_t* src, size_t row_bytes,
+                      const int16_t* weights, int count, uint8_t* dst) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i round = _mm_set1_epi32(kWeightRound);
+  size_t i = 0;
+  for (; i + 8 <= row_bytes; i += 8) {
+    __m128i low = round;
+    __m128i high = round;
+    const uint8_t* p = src + i;
+    for (int k = 0; k < count; k += 2, p += 2 * row_bytes) {
+      const bool has_second = k + 1 < count;
+      const __m128i first =
+          _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+      const __m128i second =
+          has_second ? _mm_loadl_epi64(
+                           reinterpret_cast<const __m128i*>(p + row_bytes))
+                     : zero;
+      const __m128i pair = _mm_unpacklo_epi8(first, second);
+      const __m128i weight =
+          WeightPair(weights[k], has_second ? weights[k + 1] : 0);
+      low = _mm_add_epi32(
+          low, _mm_madd_epi16(_mm_unpacklo_epi8(pair, zero), weight));
+      high = _mm_add_epi32(
+          high, _mm_madd_epi16(_mm_unpackhi_epi8(pair, zero), weight));
+    }
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i),
+                     PackWeighted(low, high));
+  }
+  ScaleColumnsScalar(src, row_bytes, weights, count, dst, i);
+}
+
+#endif  // CLIPBOARD_HAS_SSE2
+
+void UnpremultiplyPixels(uint8_t* pixels, size_t count) {
+  for (size_t i = 0; i < count; i++, pixels += 4) {
+    const uint32_t alpha = pixels[3];
+    if (alpha == 255) {
+      continue;
+    }
+    for (int c = 0; c < 3; c++) {
+      pixels[c] = alpha == 0 ? 0
+                             : static_cast<uint8_t>(std::min<uint32_t>(
+                                   (pixels[c] * 255u + alpha / 2) / alpha,
+                                   255));
+    }
+  }
+}
+
+// Resamples with the given row and column kernels.
+template <typename RowKernel, typename ColumnKernel>
+void ScaleDibImageWith(RowKernel scale_row, ColumnKernel scale_columns,
+                       const DibImage& image, int dst_width, int dst_height,
+                       ScaleFilter filter, uint8_t* dst) {
+  const AxisWeights columns =
+      ComputeAxisWeights(image.width, dst_width, filter);
+  const AxisWeights rows = ComputeAxisWeights(image.height, dst_height, filter);
+  const bool has_alpha = image.format == DibPixelFormat::kBgra;
+  const size_t row_bytes = static_cast<size_t>(dst_width) * 4;
+
+  // Each source row is widened to 32 bits (premultiplied when it has
+  // alpha), then narrowed to |dst_width| pixels.
+  PixelConvertOptions widen;
+  widen.premultiply_alpha = has_alpha;
+  DibImage source_row = image;
+  source_row.height = 1;
+  std::vector<uint8_t> wide(static_cast<size_t>(image.width) * 4);
+  std::vector<uint8_t> narrow(row_bytes * image.height);
+  for (int y = 0; y < image.height; y++) {
+    source_row.pixels = image.pixels + y * image.stride;
+    CopyDibPixels(source_row, widen, wide.data());
+    scale_row(wide.data(), &narrow[y * row_bytes], dst_width, columns);
+  }
+
+  for (int y = 0; y < dst_height; y++) {
+    scale_columns(&narrow[rows.first[y] * row_bytes], row_bytes,
+                  &rows.weights[static_cast<size_t>(y) * rows.taps],
+                  rows.count[y], dst + y * row_bytes);
+  }
+  if (has_alpha) {
+    UnpremultiplyPixels(dst, static_cast<size_t>(dst_width) * dst_height);
+  }
+}
+
+}  // namespace
+
+void FitWithin(int width, int height, int max_dimension, int* fit_width,
+               int* fit_height) {
+  const int longest = std::max(width, height);
+  if (longest <= max_dimension) {
+    *fit_width = width;
+    *fit_height = height;
+    return;
+  }
+  const double scale = static_cast<double>(max_dimension) / longest;
+  *fit_width = std::max(1, static_cast<int>(std::lround(width * scale)));
+  *fit_height = std::max(1, static_cast<int>(std::lround(height * scale)));
+}
+
+void ScaleDibImage(const DibImage& image, int dst_width, int dst_height,
+                   ScaleFilter filter, uint8_t* dst) {
+#if defined(CLIPBOARD_HAS_SSE2)
+  ScaleDibImageWith(ScaleRowSse2, ScaleColumnsSse2, image, dst_width,
+                    dst_height, filter, dst);
+#else
+  ScaleDibImageScalar(image, dst_width, dst_height, filter, dst);
+#endif
+}
+
+void ScaleDibImageScalar(const DibImage& image, int dst_width, int dst_height,
+                         ScaleFilter filter, uint8_t* dst) {
+  auto scale_columns = [](const uint8_t* src, size_t row_bytes,
+                          const int16_t* weights, int count, uint8_t* out) {
+    ScaleColumnsScalar(src, row_bytes, weights, count, out, 0);
+  };
+  ScaleDibImageWith(ScaleRowScalar, scale_columns, image, dst_width,
+                    dst_height, filter, dst);
+}
+
+}  // namespace clipboard
@@ -0,0 +1,44 @@
+#ifndef IMAGE_SCALE_H_
+#define IMAGE_SCALE_H_
+
+#include <cstdint>
+
+#include "dib_image.h"
+
+namespace clipboard {
+
+// Downscales DIB pixels (see dib_image.h) for previews. Resampling is
+// separable, horizontal then vertical, with 14-bit fixed-point weights and
+// SSE2 multiply-add kernels (scalar code elsewhere). Images with alpha are
+// filtered premultiplied so transparent pixels do not bleed their color
+// into the edges. Scaling runs on the calling thread.
+
+enum class ScaleFilter {
+  // Averages the source pixels each destination pixel covers. Fast, and
+  // alias-free for the large ratios thumbnails use.
+  kBox,
+  // Three-lobed Lanczos windowed sinc. Sharper, at roughly six times the
+  // cost of kBox.
+  kLanczos3,
+};
+
+// Returns the largest size with the aspect ratio of |width| x |height| that
+// fits in |max_dimension| on both sides, never larger than the image itself
+// and at least 1 x 1.
+void FitWithin(int width, int height, int max_dimension, int* fit_width,
+               int* fit_height);
+
+// Resamples |image| to |dst_width| x |dst_height| 32-bit pixels in |dst|,
+// packed top-down at dst_width * 4 bytes per row. kBgra images stay B, G,
+// R, straight A; the other formats come out with A = 255.
+void ScaleDibImage(const DibImage& image, int dst_width, int dst_height,
+                   ScaleFilter filter, uint8_t* dst);
+
+// Scalar reference implementation of ScaleDibImage. The SIMD kernels use
+// the same fixed-point weights, so the two agree byte for byte.
+void ScaleDibImageScalar(const DibImage& image, int dst_width, int dst_height,
+                         ScaleFilter filter, uint8_t* dst);
+
+}  // namespace clipboard
+
+#endif  // IMAGE_SCALE_H_
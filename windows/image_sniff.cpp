@@ -0,0 +1,85 @@
+#include "image_sniff.h"
+
+#include <cstring>
+
+namespace clipboard {
+
+namespace {
+
+constexpr uint8_t kPngSignature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A,
+                                     '\n'};
+constexpr uint8_t kJpegSignature[] = {0xFF, 0xD8, 0xFF};
+constexpr uint8_t kTiffLittleEndian[] = {'I', 'I', 42, 0};
+constexpr uint8_t kTiffBigEndian[] = {'M', 'M', 0, 42};
+
+bool StartsWith(const uint8_t* data, size_t size, const void* prefix,
+                size_t prefix_size, size_t offset = 0) {
+  return size >= offset + prefix_size &&
+         memcmp(data + offset, prefix, prefix_size) == 0;
+}
+
+// "BM" alone is too common a prefix, so the DIB header size that follows
+// the file header must also be one Windows writes.
+bool IsBmp(const uint8_t* data, size_t size) {
+  if (!StartsWith(data, size, "BM", 2) || size < kBmpFileHeaderSize + 4) {
+    return false;
+  }
+  const uint8_t* p = data + kBmpFileHeaderSize;
+  const uint32_t header_size =
+      static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+      (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+  return header_size == 12 || header_size == 40 || header_size == 52 ||
+         header_size == 56 || header_size == 108 || header_size == 124;
+}
+
+}  // namespace
+
+ImageFileFormat SniffImageFormat(const uint8_t* data, size_t size) {
+  if (StartsWith(data, size, kPngSignature, sizeof(kPngSignature))) {
+    return ImageFileFormat::kPng;
+  }
+  if (StartsWith(data, size, kJpegSignature, sizeof(kJpegSignature))) {
+    return ImageFileFormat::kJpeg;
+  }
+  if (StartsWith(data, size, "GIF87a", 6) ||
+      StartsWith(data, size, "GIF89a", 6)) {
+    return ImageFileFormat::kGif;
+  }
+  if (StartsWith(data, size, "RIFF", 4) &&
+      StartsWith(data, size, "WEBP", 4, 8)) {
+    return ImageFileFormat::kWebp;
+  }
+  if (IsBmp(data, size)) {
+    return ImageFileFormat::kBmp;
+  }
+  if (StartsWith(data, size, kTiffLittleEndian, sizeof(kTiffLittleEndian)) ||
+      StartsWith(data, size, kTiffBigEndian, sizeof(kTiffBigEndian))) {
+    return ImageFileFormat::kTiff;
+  }
+  return ImageFileFormat::kUnknown;
+}
+
+size_t PngFileSize(const uint8_t* data, size_t size) {
+  if (!StartsWith(data, size, kPngSignature, sizeof(kPngSignature))) {
+    return 0;
+  }
+  // Length, type and CRC around each chunk's data
+  constexpr size_t kChunkOverhead = 12;
+  size_t pos = sizeof(kPngSignature);
+  while (size - pos >= kChunkOverhead) {
+    const uint8_t* p = data + pos;
+    const uint32_t length = (static_cast<uint32_t>(p[0]) << 24) |
+                            (static_cast<uint32_t>(p[1]) << 16) |
+                            (static_cast<uint32_t>(p[2]) << 8) | p[3];
+    if (length > size - pos - kChunkOverhead) {
+      return 0;
+    }
+    pos += kChunkOverhead + length;
+    if (memcmp(p + 4, "IEND", 4) == 0) {
+      return pos;
+    }
+  }
+  return 0;
+}
+
+}  // namespace clipboard
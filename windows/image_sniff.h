@@ -0,0 +1,39 @@
+#ifndef IMAGE_SNIFF_H_
+#define IMAGE_SNIFF_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace clipboard {
+
+// Identifies image files from their leading bytes, so files copied to the
+// clipboard can be rejected or passed through before anything decodes them.
+// Only the signature is checked: a match says what the file claims to be,
+// not that it decodes.
+
+enum class ImageFileFormat {
+  kUnknown,
+  kPng,
+  kJpeg,
+  kGif,
+  kWebp,
+  kBmp,
+  kTiff,
+};
+
+// Returns the format whose signature |data| starts with, looking at no more
+// than the first |size| bytes.
+ImageFileFormat SniffImageFormat(const uint8_t* data, size_t size);
+
+// Size of the BITMAPFILEHEADER in front of the packed DIB in a .bmp file.
+constexpr size_t kBmpFileHeaderSize = 14;
+
+// Length of the PNG file at the start of |data|, through the end of its
+// IEND chunk, or 0 if the signature or a chunk length is not valid. Chunk
+// CRCs are not checked. Clipboard globals are often larger than what was
+// stored in them, and this trims the padding.
+size_t PngFileSize(const uint8_t* data, size_t size);
+
+}  // namespace clipboard
+
+#endif  // IMAGE_SNIFF_H_
@@ -0,0 +1,130 @@
+#ifndef PASTE_CACHE_H_
+#define PASTE_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace clipboard {
+
+struct PasteCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  size_t entries = 0;
+  size_t bytes = 0;
+};
+
+// Remembers paste results for a single clipboard state, identified by the
+// system clipboard sequence number. Entries are keyed by the requested
+// format; any change of sequence number drops all of them, so a lookup never
+// needs the clipboard lock. Sequence number 0 (no clipboard access) is never
+// cached. Thread-safe.
+template <typename Value>
+class PasteCache {
+ public:
+  static constexpr size_t kDefaultMaxBytes = 64 * 1024 * 1024;
+
+  explicit PasteCache(size_t max_bytes = kDefaultMaxBytes)
+      : max_bytes_(max_bytes) {}
+
+  PasteCache(const PasteCache&) = delete;
+  PasteCache& operator=(const PasteCache&) = delete;
+
+  // Returns the result stored for |key| under |sequence|, or nullptr.
+  std::shared_ptr<const Value> Find(uint32_t sequence, const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sequence != 0 && sequence == sequence_) {
+      auto it = entries_.find(key);
+      if (it != entries_.end()) {
+        stats_.hits++;
+        return it->second.value;
+      }
+    }
+    stats_.misses++;
+    return nullptr;
+  }
+
+  // Like Find, but a miss is not counted, for callers that fall back to a
+  // path which looks the result up again.
+  std::shared_ptr<const Value> FindIfCached(uint32_t sequence,
+                                            const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sequence != 0 && sequence == sequence_) {
+      auto it = entries_.find(key);
+      if (it != entries_.end()) {
+        stats_.hits++;
+        return it->second.value;
+      }
+    }
+    return nullptr;
+  }
+
+  // Stores |value| for |key|. |size_bytes| approximates the payload size and
+  // counts against the byte budget; results larger than the budget are not
+  // kept, and entries for other formats are dropped (in key order) to make
+  // room.
+  std::shared_ptr<const Value> Store(uint32_t sequence, const std::string& key,
+                                     Value value, size_t size_bytes) {
+    auto shared = std::make_shared<const Value>(std::move(value));
+    if (sequence == 0 || size_bytes > max_bytes_) {
+      return shared;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sequence != sequence_) {
+      ClearLocked();
+      sequence_ = sequence;
+    }
+    auto existing = entries_.find(key);
+    if (existing != entries_.end()) {
+      bytes_ -= existing->second.size_bytes;
+      entries_.erase(existing);
+    }
+    while (!entries_.empty() && bytes_ + size_bytes > max_bytes_) {
+      bytes_ -= entries_.begin()->second.size_bytes;
+      entries_.erase(entries_.begin());
+    }
+    entries_[key] = Entry{shared, size_bytes};
+    bytes_ += size_bytes;
+    return shared;
+  }
+
+  void Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ClearLocked();
+  }
+
+  PasteCacheStats stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    PasteCacheStats stats = stats_;
+    stats.entries = entries_.size();
+    stats.bytes = bytes_;
+    return stats;
+  }
+
+ private:
+  struct Entry {
+    std::shared_ptr<const Value> value;
+    size_t size_bytes = 0;
+  };
+
+  void ClearLocked() {
+    entries_.clear();
+    bytes_ = 0;
+    sequence_ = 0;
+  }
+
+  const size_t max_bytes_;
+  std::mutex mutex_;
+  uint32_t sequence_ = 0;
+  std::map<std::string, Entry> entries_;
+  size_t bytes_ = 0;
+  PasteCacheStats stats_;
+};
+
+}  // namespace clipboard
+
+#endif  // PASTE_CACHE_H_
@@ -0,0 +1,285 @@
+#include "pixel_convert.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "thread_pool.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define CLIPBOARD_HAS_SSE2 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(CLIPBOARD_HAS_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define CLIPBOARD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define CLIPBOARD_TARGET_AVX2
+#endif
+
+namespace clipboard {
+
+namespace {
+
+constexpr uint32_t kGreenAlphaMask = 0xFF00FF00u;
+constexpr uint32_t kAlphaMask = 0xFF000000u;
+
+bool IsPlainCopy(const PixelConvertOptions& options) {
+  return !options.swap_red_blue && !options.force_opaque &&
+         !options.premultiply_alpha;
+}
+
+// Exact rounded division of a product of two 8-bit values by 255.
+inline uint32_t MulDiv255(uint32_t value, uint32_t alpha) {
+  uint32_t product = value * alpha + 128;
+  return (product + (product >> 8)) >> 8;
+}
+
+#if defined(CLIPBOARD_HAS_SSE2)
+
+bool CpuHasAvx2() {
+  static const bool has_avx2 = [] {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4] = {0};
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+      return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+      return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+  }();
+  return has_avx2;
+}
+
+inline __m128i SwapRedBlue128(__m128i pixels) {
+  const __m128i green_alpha = _mm_set1_epi32(static_cast<int>(kGreenAlphaMask));
+  __m128i red_blue = _mm_andnot_si128(green_alpha, pixels);
+  red_blue = _mm_or_si128(_mm_slli_epi32(red_blue, 16),
+                          _mm_srli_epi32(red_blue, 16));
+  return _mm_or_si128(_mm_and_si128(pixels, green_alpha), red_blue);
+}
+
+// Premultiplies two pixels widened to 16-bit lanes.
+inline __m128i PremultiplyWide128(__m128i wide) {
+  const __m128i alpha_lanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+  const __m128i alpha_lanes_255 = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+  __m128i alpha = _mm_shufflelo_epi16(wide, _MM_SHUFFLE(3, 3, 3, 3));
+  alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+  // Alpha itself is multiplied by 255 so the division leaves it unchanged.
+  alpha = _mm_or_si128(_mm_andnot_si128(alpha_lanes, alpha), alpha_lanes_255);
+  __m128i product = _mm_add_epi16(_mm_mullo_epi16(wide, alpha),
+                                  _mm_set1_epi16(128));
+  product = _mm_add_epi16(product, _mm_srli_epi16(product, 8));
+  return _mm_srli_epi16(product, 8);
+}
+
+// Returns the number of pixels converted; the caller finishes the tail.
+size_t ConvertRowSse2(const uint8_t* src, uint8_t* dst, size_t width,
+                      const PixelConvertOptions& options) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i opaque = _mm_set1_epi32(static_cast<int>(kAlphaMask));
+  const bool premultiply = options.premultiply_alpha && !options.force_opaque;
+  size_t x = 0;
+  for (; x + 4 <= width; x += 4) {
+    __m128i pixels =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+    if (options.swap_red_blue) {
+      pixels = SwapRedBlue128(pixels);
+    }
+    if (options.force_opaque) {
+      pixels = _mm_or_si128(pixels, opaque);
+    } else if (premultiply) {
+      __m128i low = PremultiplyWide128(_mm_unpacklo_epi8(pixels, zero));
+      __m128i high = PremultiplyWide128(_mm_unpackhi_epi8(pixels, zero));
+      pixels = _mm_packus_epi16(low, high);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), pixels);
+  }
+  return x;
+}
+
+CLIPBOARD_TARGET_AVX2 inline __m256i SwapRedBlue256(__m256i pixels) {
+  const __m256i green_alpha =
+      _mm256_set1_epi32(static_cast<int>(kGreenAlphaMask));
+  __m256i red_blue = _mm256_andnot_si256(green_alpha, pixels);
+  red_blue = _mm256_or_si256(_mm256_slli_epi32(red_blue, 16),
+                             _mm256_srli_epi32(red_blue, 16));
+  return _mm256_or_si256(_mm256_and_si256(pixels, green_alpha), red_blue);
+}
+
+CLIPBOARD_TARGET_AVX2 inline __m256i PremultiplyWide256(__m256i wide) {
+  const __m256i alpha_lanes = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0,
+                                               -1, 0, 0, 0, -1, 0, 0, 0);
+  const __m256i alpha_lanes_255 = _mm256_set_epi16(
+      255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+  __m256i alpha = _mm256_shufflelo_epi16(wide, _MM_SHUFFLE(3, 3, 3, 3));
+  alpha = _mm256_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+  alpha = _mm256_or_si256(_mm256_andnot_si256(alpha_lanes, alpha),
+                          alpha_lanes_255);
+  __m256i product = _mm256_add_epi16(_mm256_mullo_epi16(wide, alpha),
+                                     _mm256_set1_epi16(128));
+  product = _mm256_add_epi16(product, _mm256_srli_epi16(product, 8));
+  return _mm256_srli_epi16(product, 8);
+}
+
+CLIPBOARD_TARGET_AVX2 size_t ConvertRowAvx2(const uint8_t* src, uint8_t* dst,
+                                            size_t width,
+                                            const PixelConvertOptions& options) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i opaque = _mm256_set1_epi32(static_cast<int>(kAlphaMask));
+  const bool premultiply = options.premultiply_alpha && !options.force_opaque;
+  size_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256i pixels =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 4));
+    if (options.swap_red_blue) {
+      pixels = SwapRedBlue256(pixels);
+    }
+    if (options.force_opaque) {
+      pixels = _mm256_or_si256(pixels, opaque);
+    } else if (premultiply) {
+      // Unpack and pack both work per 128-bit lane, so pixel order survives.
+      __m256i low = PremultiplyWide256(_mm256_unpacklo_epi8(pixels, zero));
+      __m256i high = PremultiplyWide256(_mm256_unpackhi_epi8(pixels, zero));
+      pixels = _mm256_packus_epi16(low, high);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), pixels);
+  }
+  return x;
+}
+
+#endif  // CLIPBOARD_HAS_SSE2
+
+}  // namespace
+
+void ConvertPixelRowScalar(const uint8_t* src, uint8_t* dst, size_t width,
+                           const PixelConvertOptions& options) {
+  const bool premultiply = options.premultiply_alpha && !options.force_opaque;
+  for (size_t x = 0; x < width; x++) {
+    uint32_t pixel;
+    memcpy(&pixel, src + x * 4, sizeof(pixel));
+    if (options.swap_red_blue) {
+      pixel = (pixel & kGreenAlphaMask) | ((pixel >> 16) & 0xFFu) |
+              ((pixel & 0xFFu) << 16);
+    }
+    if (options.force_opaque) {
+      pixel |= kAlphaMask;
+    } else if (premultiply) {
+      uint32_t alpha = pixel >> 24;
+      pixel = (alpha << 24) | (MulDiv255((pixel >> 16) & 0xFFu, alpha) << 16) |
+              (MulDiv255((pixel >> 8) & 0xFFu, alpha) << 8) |
+              MulDiv255(pixel & 0xFFu, alpha);
+    }
+    memcpy(dst + x * 4, &pixel, sizeof(pixel));
+  }
+}
+
+void ConvertPixelRow(const uint8_t* src, uint8_t* dst, size_t width,
+                     const PixelConvertOptions& options) {
+  if (IsPlainCopy(options)) {
+    if (src != dst) {
+      memmove(dst, src, width * 4);
+    }
+    return;
+  }
+  size_t done = 0;
+#if defined(CLIPBOARD_HAS_SSE2)
+  done = CpuHasAvx2() ? ConvertRowAvx2(src, dst, width, options)
+                      : ConvertRowSse2(src, dst, width, options);
+#endif
+  ConvertPixelRowScalar(src + done * 4, dst + done * 4, width - done, options);
+}
+
+bool IsPixelKernelSupported(PixelKernel kernel) {
+  switch (kernel) {
+    case PixelKernel::kScalar:
+      return true;
+#if defined(CLIPBOARD_HAS_SSE2)
+    case PixelKernel::kSse2:
+      return true;
+    case PixelKernel::kAvx2:
+      return CpuHasAvx2();
+#endif
+    default:
+      return false;
+  }
+}
+
+void ConvertPixelRowWith(PixelKernel kernel, const uint8_t* src, uint8_t* dst,
+                         size_t width, const PixelConvertOptions& options) {
+  size_t done = 0;
+#if defined(CLIPBOARD_HAS_SSE2)
+  if (kernel == PixelKernel::kAvx2) {
+    done = ConvertRowAvx2(src, dst, width, options);
+  } else if (kernel == PixelKernel::kSse2) {
+    done = ConvertRowSse2(src, dst, width, options);
+  }
+#else
+  (void)kernel;
+#endif
+  ConvertPixelRowScalar(src + done * 4, dst + done * 4, width - done, options);
+}
+
+void ConvertPixelRows(const uint8_t* src, ptrdiff_t src_stride, uint8_t* dst,
+                      ptrdiff_t dst_stride, int width, int height,
+                      const PixelConvertOptions& options) {
+  if (width <= 0 || height <= 0) {
+    return;
+  }
+  const size_t row_bytes = static_cast<size_t>(width) * 4;
+
+  // Tightly packed top-down buffers on both sides: one bulk copy.
+  if (IsPlainCopy(options) && src_stride == dst_stride &&
+      src_stride == static_cast<ptrdiff_t>(row_bytes)) {
+    memcpy(dst, src, row_bytes * static_cast<size_t>(height));
+    return;
+  }
+
+  auto convert_band = [&](int first_row, int end_row) {
+    const uint8_t* src_row = src + src_stride * first_row;
+    uint8_t* dst_row = dst + dst_stride * first_row;
+    for (int y = first_row; y < end_row; y++) {
+      ConvertPixelRow(src_row, dst_row, static_cast<size_t>(width), options);
+      src_row += src_stride;
+      dst_row += dst_stride;
+    }
+  };
+
+  const size_t pixel_count =
+      static_cast<size_t>(width) * static_cast<size_t>(height);
+  ThreadPool* pool = options.thread_pool;
+  if (!pool || pool->worker_count() == 0 ||
+      pixel_count < options.parallel_pixel_threshold) {
+    convert_band(0, height);
+    return;
+  }
+
+  // A few bands per thread keeps the load balanced when cores are shared.
+  const size_t band_count = std::min<size_t>(
+      static_cast<size_t>(height), (pool->worker_count() + 1) * 4);
+  const size_t rows_per_band =
+      (static_cast<size_t>(height) + band_count - 1) / band_count;
+  pool->ParallelFor(band_count, [&](size_t band) {
+    const size_t first_row = band * rows_per_band;
+    const size_t end_row =
+        std::min(first_row + rows_per_band, static_cast<size_t>(height));
+    if (first_row < end_row) {
+      convert_band(static_cast<int>(first_row), static_cast<int>(end_row));
+    }
+  });
+}
+
+}  // namespace clipboard
@@ -0,0 +1,62 @@
+#ifndef PIXEL_CONVERT_H_
+#define PIXEL_CONVERT_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace clipboard {
+
+class ThreadPool;
+
+// Transformations applied while copying rows of 32-bit pixels. With all flags
+// off the conversion is a plain row copy.
+struct PixelConvertOptions {
+  // Exchanges the first and third channel (BGRA <-> RGBA).
+  bool swap_red_blue = false;
+  // Forces alpha to 255, for sources whose alpha channel is undefined (e.g.
+  // 32bpp BI_RGB DIBs). Takes precedence over premultiply_alpha.
+  bool force_opaque = false;
+  // Converts straight alpha to premultiplied alpha.
+  bool premultiply_alpha = false;
+  // Pool used to split large images into row bands. nullptr converts on the
+  // calling thread only.
+  ThreadPool* thread_pool = nullptr;
+  // Minimum width * height before rows are split across |thread_pool|.
+  size_t parallel_pixel_threshold = 2 * 1024 * 1024;
+};
+
+// Converts |height| rows of |width| 32-bit pixels from |src| to |dst|.
+// Strides are in bytes and may be negative, which flips the image
+// vertically (bottom-up DIB <-> top-down buffer).
+void ConvertPixelRows(const uint8_t* src, ptrdiff_t src_stride, uint8_t* dst,
+                      ptrdiff_t dst_stride, int width, int height,
+                      const PixelConvertOptions& options = PixelConvertOptions());
+
+// Converts a single row of |width| pixels. Uses AVX2 or SSE2 when available
+// and falls back to scalar code elsewhere.
+void ConvertPixelRow(const uint8_t* src, uint8_t* dst, size_t width,
+                     const PixelConvertOptions& options);
+
+// Scalar reference implementation of ConvertPixelRow.
+void ConvertPixelRowScalar(const uint8_t* src, uint8_t* dst, size_t width,
+                           const PixelConvertOptions& options);
+
+// Row kernels ConvertPixelRow chooses from, so tests and benchmarks can
+// compare them.
+enum class PixelKernel {
+  kScalar,
+  kSse2,
+  kAvx2,
+};
+
+// Whether |kernel| was compiled in and this CPU supports it.
+bool IsPixelKernelSupported(PixelKernel kernel);
+
+// ConvertPixelRow using only |kernel|, which must be supported. Pixels past
+// the last full vector are converted by the scalar code, as they are there.
+void ConvertPixelRowWith(PixelKernel kernel, const uint8_t* src, uint8_t* dst,
+                         size_t width, const PixelConvertOptions& options);
+
+}  // namespace clipboard
+
+#endif  // PIXEL_CONVERT_H_
@@ -0,0 +1,395 @@
+#include "png_encoder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "deflate.h"
+#include "pixel_convert.h"
+#include "thread_pool.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define CLIPBOARD_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace clipboard {
+
+namespace {
+
+constexpr uint8_t kSignature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+constexpr uint64_t kMaxScanlineBytes = uint64_t{1} << 30;
+constexpr uint64_t kMaxRowBytes = uint64_t{1} << 24;
+constexpr uint8_t kColorTypeRgb = 2;
+constexpr uint8_t kColorTypeRgba = 6;
+
+enum FilterType : uint8_t {
+  kFilterNone,
+  kFilterSub,
+  kFilterUp,
+  kFilterAverage,
+  kFilterPaeth,
+  kFilterCount,
+};
+
+// Converts one DIB row to PNG channel order (RGB or RGBA).
+void ConvertRow(const uint8_t* src, DibPixelFormat format, int width,
+                uint8_t* dst) {
+  switch (format) {
+    case DibPixelFormat::kBgra: {
+      PixelConvertOptions options;
+      options.swap_red_blue = true;
+      ConvertPixelRow(src, dst, static_cast<size_t>(width), options);
+      break;
+    }
+    case DibPixelFormat::kBgrx:
+    case DibPixelFormat::kBgr: {
+      const size_t src_step = DibBytesPerPixel(format);
+      for (int x = 0; x < width; x++, src += src_step, dst += 3) {
+        dst[0] = src[2];
+        dst[1] = src[1];
+        dst[2] = src[0];
+      }
+      break;
+    }
+  }
+}
+
+inline uint8_t PaethPredictor(int left, int up, int up_left) {
+  const int estimate = left + up - up_left;
+  const int to_left = estimate > left ? estimate - left : left - estimate;
+  const int to_up = estimate > up ? estimate - up : up - estimate;
+  const int to_up_left =
+      estimate > up_left ? estimate - up_left : up_left - estimate;
+  if (to_left <= to_up && to_left <= to_up_left) {
+    return static_cast<uint8_t>(left);
+  }
+  return static_cast<uint8_t>(to_up <= to_up_left ? up : up_left);
+}
+
+#if defined(CLIPBOARD_HAS_SSE2)
+
+inline __m128i Abs16(__m128i value) {
+  return _mm_max_epi16(value, _mm_sub_epi16(_mm_setzero_si128(), value));
+}
+
+// The SSE2 helpers filter from |start| (at least |bpp|, so every byte has
+// a left neighbour) and return the first index left for the scalar loop.
+
+// Sub, Up or Average, 16 bytes at a time.
+size_t FilterSse2(uint8_t type, const uint8_t* row, const uint8_t* prior,
+                  size_t start, size_t size, size_t bpp, uint8_t* out) {
+  const __m128i one = _mm_set1_epi8(1);
+  size_t i = start;
+  for (; i + 16 <= size; i += 16) {
+    const __m128i left =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i - bpp));
+    const __m128i up =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(prior + i));
+    __m128i predictor;
+    if (type == kFilterSub) {
+      predictor = left;
+    } else if (type == kFilterUp) {
+      predictor = up;
+    } else {
+      // pavgb rounds up; PNG's average rounds down
+      predictor = _mm_sub_epi8(_mm_avg_epu8(left, up),
+                               _mm_and_si128(_mm_xor_si128(left, up), one));
+    }
+    const __m128i current =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_sub_epi8(current, predictor));
+  }
+  return i;
+}
+
+// Paeth, 8 bytes at a time in 16-bit lanes, in 16-bit lanes. Returns the
+// first index left for the scalar loop.
+size_t PaethFilterSse2(const uint8_t* row, const uint8_t* prior, size_t start,
+                       size_t size, size_t bpp, uint8_t* out) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = start;
+  for (; i + 8 <= size; i += 8) {
+    auto load = [zero](const uint8_t* p) {
+      return _mm_unpacklo_epi8(
+          _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), zero);
+    };
+    const __m128i left = load(row + i - bpp);
+    const __m128i up = load(prior + i);
+    const __m128i up_left = load(prior + i - bpp);
+    const __m128i up_delta = _mm_sub_epi16(up, up_left);
+    const __m128i left_delta = _mm_sub_epi16(left, up_left);
+    const __m128i to_left = Abs16(up_delta);
+    const __m128i to_up = Abs16(left_delta);
+    const __m128i to_up_left = Abs16(_mm_add_epi16(up_delta, left_delta));
+    const __m128i not_left = _mm_or_si128(_mm_cmpgt_epi16(to_left, to_up),
+                                          _mm_cmpgt_epi16(to_left, to_up_left));
+    const __m128i use_up_left = _mm_cmpgt_epi16(to_up, to_up_left);
+    const __m128i up_or_up_left =
+        _mm_or_si128(_mm_and_si128(use_up_left, up_left),
+                     _mm_andnot_si128(use_up_left, up));
+    const __m128i predictor =
+        _mm_or_si128(_mm_and_si128(not_left, up_or_up_left),
+                     _mm_andnot_si128(not_left, left));
+    const __m128i current =
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + i));
+    _mm_storel_epi64(
+        reinterpret_cast<__m128i*>(out + i),
+        _mm_sub_epi8(current, _mm_packus_epi16(predictor, zero)));
+  }
+  return i;
+}
+
+uint32_t FilterCostSse2(const uint8_t* filtered, size_t size, size_t* done) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sums = zero;
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const __m128i value =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(filtered + i));
+    const __m128i magnitude =
+        _mm_min_epu8(value, _mm_sub_epi8(zero, value));
+    sums = _mm_add_epi64(sums, _mm_sad_epu8(magnitude, zero));
+  }
+  *done = i;
+  return static_cast<uint32_t>(_mm_cvtsi128_si32(sums) +
+                               _mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+}
+
+#else
+
+size_t FilterSse2(uint8_t, const uint8_t*, const uint8_t*, size_t start,
+                  size_t, size_t, uint8_t*) {
+  return start;
+}
+
+size_t PaethFilterSse2(const uint8_t*, const uint8_t*, size_t start, size_t,
+                       size_t, uint8_t*) {
+  return start;
+}
+
+uint32_t FilterCostSse2(const uint8_t*, size_t, size_t* done) {
+  *done = 0;
+  return 0;
+}
+
+#endif  // CLIPBOARD_HAS_SSE2
+
+// Filters |row| against |prior| (the previous unfiltered row, zeros for the
+// first) with |type|, writing |size| bytes to |out|. The first pixel, which
+// has no left neighbour, is handled apart so the main loops are branch-free.
+void FilterRow(uint8_t type, const uint8_t* row, const uint8_t* prior,
+               size_t size, size_t bpp, uint8_t* out) {
+  switch (type) {
+    case kFilterNone:
+      memcpy(out, row, size);
+      break;
+    case kFilterSub:
+      memcpy(out, row, bpp);
+      for (size_t i = FilterSse2(type, row, prior, bpp, size, bpp, out);
+           i < size; i++) {
+        out[i] = static_cast<uint8_t>(row[i] - row[i - bpp]);
+      }
+      break;
+    case kFilterUp:
+      for (size_t i = 0; i < bpp; i++) {
+        out[i] = static_cast<uint8_t>(row[i] - prior[i]);
+      }
+      for (size_t i = FilterSse2(type, row, prior, bpp, size, bpp, out);
+           i < size; i++) {
+        out[i] = static_cast<uint8_t>(row[i] - prior[i]);
+      }
+      break;
+    case kFilterAverage:
+      for (size_t i = 0; i < bpp; i++) {
+        out[i] = static_cast<uint8_t>(row[i] - (prior[i] >> 1));
+      }
+      for (size_t i = FilterSse2(type, row, prior, bpp, size, bpp, out);
+           i < size; i++) {
+        out[i] = static_cast<uint8_t>(
+            row[i] - ((row[i - bpp] + prior[i]) >> 1));
+      }
+      break;
+    case kFilterPaeth:
+      // With no left neighbour the predictor is always the byte above
+      for (size_t i = 0; i < bpp; i++) {
+        out[i] = static_cast<uint8_t>(row[i] - prior[i]);
+      }
+      for (size_t i = PaethFilterSse2(row, prior, bpp, size, bpp, out);
+           i < size; i++) {
+        out[i] = static_cast<uint8_t>(
+            row[i] - PaethPredictor(row[i - bpp], prior[i], prior[i - bpp]));
+      }
+      break;
+  }
+}
+
+// Sum of the filtered bytes' magnitudes read as signed values; the usual
+// predictor of which filter compresses best. Fits in 32 bits for rows up to
+// kMaxRowBytes.
+uint32_t FilterCost(const uint8_t* filtered, size_t size) {
+  size_t i;
+  uint32_t cost = FilterCostSse2(filtered, size, &i);
+  for (; i < size; i++) {
+    const uint32_t value = filtered[i];
+    cost += value < 128 ? value : 256 - value;
+  }
+  return cost;
+}
+
+void AppendU32(std::vector<uint8_t>* out, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    out->push_back(static_cast<uint8_t>(value >> shift));
+  }
+}
+
+// Starts a chunk; FinishChunk patches in the length and appends the CRC
+// once the data has been appended.
+size_t BeginChunk(std::vector<uint8_t>* png, const char type[4]) {
+  const size_t start = png->size();
+  AppendU32(png, 0);
+  png->insert(png->end(), type, type + 4);
+  return start;
+}
+
+void FinishChunk(std::vector<uint8_t>* png, size_t start) {
+  const size_t length = png->size() - start - 8;
+  uint8_t* header = png->data() + start;
+  for (int i = 0; i < 4; i++) {
+    header[i] = static_cast<uint8_t>(length >> (24 - 8 * i));
+  }
+  AppendU32(png, Crc32(0, header + 4, length + 4));
+}
+
+// Filters rows [first_row, end_row) into |out|. A band starting mid-image
+// converts the row above it first, as the Up, Average and Paeth filters
+// need it.
+void FilterBand(const DibImage& image, int first_row, int end_row,
+                size_t row_size, size_t bpp, uint8_t* out) {
+  std::vector<uint8_t> row(row_size);
+  std::vector<uint8_t> prior(row_size, 0);
+  std::vector<uint8_t> candidates[kFilterCount];
+  for (auto& candidate : candidates) {
+    candidate.resize(row_size);
+  }
+
+  const uint8_t* src = image.pixels + image.stride * first_row;
+  if (first_row > 0) {
+    ConvertRow(src - image.stride, image.format, image.width, prior.data());
+  }
+  for (int y = first_row; y < end_row; y++, src += image.stride) {
+    ConvertRow(src, image.format, image.width, row.data());
+    uint8_t best = kFilterNone;
+    uint32_t best_cost = UINT32_MAX;
+    for (uint8_t type = kFilterNone; type < kFilterCount; type++) {
+      FilterRow(type, row.data(), prior.data(), row_size, bpp,
+                candidates[type].data());
+      const uint32_t cost = FilterCost(candidates[type].data(), row_size);
+      if (cost < best_cost) {
+        best = type;
+        best_cost = cost;
+      }
+    }
+    *out++ = best;
+    memcpy(out, candidates[best].data(), row_size);
+    out += row_size;
+    std::swap(row, prior);
+  }
+}
+
+// Threads an encode of |image| may use, the caller included.
+size_t ThreadCount(const DibImage& image, const PngEncodeOptions& options) {
+  const uint64_t pixels = static_cast<uint64_t>(image.width) *
+                          static_cast<uint64_t>(image.height);
+  if (!options.thread_pool || pixels < options.parallel_pixel_threshold) {
+    return 1;
+  }
+  size_t threads = options.thread_pool->worker_count() + 1;
+  if (options.max_threads > 0) {
+    threads = std::min(threads, options.max_threads);
+  }
+  return threads;
+}
+
+}  // namespace
+
+bool FilterPngRows(const DibImage& image, PngScanlines* scanlines,
+                   const PngEncodeOptions& options) {
+  if (image.width <= 0 || image.height <= 0) {
+    return false;
+  }
+  const bool has_alpha = image.format == DibPixelFormat::kBgra;
+  const size_t bpp = has_alpha ? 4 : 3;
+  const uint64_t row_bytes = static_cast<uint64_t>(image.width) * bpp;
+  if (row_bytes > kMaxRowBytes ||
+      (row_bytes + 1) * static_cast<uint64_t>(image.height) >
+          kMaxScanlineBytes) {
+    return false;
+  }
+  const size_t row_size = static_cast<size_t>(row_bytes);
+
+  scanlines->width = image.width;
+  scanlines->height = image.height;
+  scanlines->has_alpha = has_alpha;
+  scanlines->data.resize((row_size + 1) * static_cast<size_t>(image.height));
+
+  const size_t height = static_cast<size_t>(image.height);
+  const size_t band_count = std::min(height, ThreadCount(image, options));
+  if (band_count == 1) {
+    FilterBand(image, 0, image.height, row_size, bpp, scanlines->data.data());
+    return true;
+  }
+  const size_t rows_per_band = (height + band_count - 1) / band_count;
+  options.thread_pool->ParallelFor(band_count, [&](size_t band) {
+    const size_t first_row = std::min(height, band * rows_per_band);
+    const size_t end_row = std::min(height, first_row + rows_per_band);
+    FilterBand(image, static_cast<int>(first_row), static_cast<int>(end_row),
+               row_size, bpp,
+               scanlines->data.data() + first_row * (row_size + 1));
+  });
+  return true;
+}
+
+void WritePng(const PngScanlines& scanlines, std::vector<uint8_t>* png,
+              const PngEncodeOptions& options) {
+  // Filtered screenshots typically compress several-fold
+  png->reserve(png->size() + scanlines.data.size() / 4 + 64);
+  png->insert(png->end(), kSignature, kSignature + sizeof(kSignature));
+
+  size_t chunk = BeginChunk(png, "IHDR");
+  AppendU32(png, static_cast<uint32_t>(scanlines.width));
+  AppendU32(png, static_cast<uint32_t>(scanlines.height));
+  png->push_back(8);  // Bit depth
+  png->push_back(scanlines.has_alpha ? kColorTypeRgba : kColorTypeRgb);
+  png->push_back(0);  // Deflate compression
+  png->push_back(0);  // Adaptive filtering
+  png->push_back(0);  // No interlace
+  FinishChunk(png, chunk);
+
+  DibImage shape;
+  shape.width = scanlines.width;
+  shape.height = scanlines.height;
+  ZlibOptions zlib_options;
+  zlib_options.thread_pool = options.thread_pool;
+  zlib_options.piece_count = ThreadCount(shape, options);
+  chunk = BeginChunk(png, "IDAT");
+  ZlibCompress(scanlines.data.data(), scanlines.data.size(), png,
+               zlib_options);
+  FinishChunk(png, chunk);
+
+  FinishChunk(png, BeginChunk(png, "IEND"));
+}
+
+bool EncodePng(const DibImage& image, std::vector<uint8_t>* png,
+               const PngEncodeOptions& options) {
+  PngScanlines scanlines;
+  if (!FilterPngRows(image, &scanlines, options)) {
+    return false;
+  }
+  WritePng(scanlines, png, options);
+  return true;
+}
+
+}  // namespace clipboard
@@ -0,0 +1,58 @@
+#ifndef PNG_ENCODER_H_
+#define PNG_ENCODER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "dib_image.h"
+
+namespace clipboard {
+
+class ThreadPool;
+
+// Encodes DIB pixels (see dib_image.h) as PNG directly into a byte vector.
+// The work is split so callers reading clipboard memory can release it
+// early: FilterPngRows is the only pass over the source pixels, and WritePng
+// compresses its output. 32-bit images with alpha become RGBA, everything
+// else RGB, each row using whichever PNG filter has the smallest sum of
+// absolute differences. Large images are filtered in row bands and
+// compressed in pieces on a thread pool, stitched into one zlib stream the
+// way pigz does. Output depends on the thread count only in how the
+// stream is split; it always decodes to the same pixels.
+
+// Rows converted to PNG channel order and filtered, each prefixed by its
+// filter type: the uncompressed contents of the IDAT stream.
+struct PngScanlines {
+  int width = 0;
+  int height = 0;
+  bool has_alpha = false;
+  std::vector<uint8_t> data;
+};
+
+struct PngEncodeOptions {
+  // Pool used to filter row bands and deflate pieces of the stream in
+  // parallel. nullptr encodes on the calling thread only.
+  ThreadPool* thread_pool = nullptr;
+  // Most threads (the caller included) one encode uses; 0 for the whole
+  // pool.
+  size_t max_threads = 0;
+  // Minimum width * height before work is split across |thread_pool|.
+  size_t parallel_pixel_threshold = 512 * 1024;
+};
+
+// Returns false for empty images and for images above 1 GiB of scanlines
+// or 16 MiB per row.
+bool FilterPngRows(const DibImage& image, PngScanlines* scanlines,
+                   const PngEncodeOptions& options = PngEncodeOptions());
+
+// Appends a complete PNG file for |scanlines| to |png|.
+void WritePng(const PngScanlines& scanlines, std::vector<uint8_t>* png,
+              const PngEncodeOptions& options = PngEncodeOptions());
+
+// FilterPngRows followed by WritePng.
+bool EncodePng(const DibImage& image, std::vector<uint8_t>* png,
+               const PngEncodeOptions& options = PngEncodeOptions());
+
+}  // namespace clipboard
+
+#endif  // PNG_ENCODER_H_
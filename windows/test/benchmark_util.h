@@ -0,0 +1,36 @@
+#ifndef CLIPBOARD_BENCHMARK_UTIL_H_
+#define CLIPBOARD_BENCHMARK_UTIL_H_
+
+#include <chrono>
+#include <cstdio>
+
+namespace clipboard_test {
+
+// Best wall time of |iterations| calls to |fn|, in milliseconds. The best
+// run is the least disturbed by other load on the machine.
+template <typename Fn>
+double BestMillis(int iterations, Fn&& fn) {
+  double best = -1;
+  for (int i = 0; i < iterations; i++) {
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (best < 0 || elapsed.count() < best) {
+      best = elapsed.count();
+    }
+  }
+  return best;
+}
+
+// Prints one result line: time, throughput over |bytes| and the speedup
+// against |baseline_ms| (pass the result's own time for the baseline).
+inline void PrintResult(const char* name, double ms, double bytes,
+                        double baseline_ms) {
+  std::printf("%-28s %9.2f ms %9.1f MB/s %7.2fx\n", name, ms,
+              bytes / (ms * 1000.0), baseline_ms / ms);
+}
+
+}  // namespace clipboard_test
+
+#endif  // CLIPBOARD_BENCHMARK_UTIL_H_
@@ -0,0 +1,95 @@
+// Times copyHtml's CF_HTML encode and pasteHtml's fragment extraction on
+// browser-sized selections, from a paragraph to a 16 MB page of table rows
+// with inline styles. A memcpy of the payload is timed first as the floor
+// both are measured against. Decoding is timed with valid header offsets
+// and with offsets of -1, which some producers write and which send the
+// decoder scanning for the comment markers instead.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "benchmark_util.h"
+#include "cf_html.h"
+
+namespace {
+
+// About |size| bytes of markup shaped like a copied web page table.
+std::string BrowserFragment(size_t size) {
+  std::string html;
+  html.reserve(size + 512);
+  for (int row = 0; html.size() < size; row++) {
+    char line[512];
+    std::snprintf(
+        line, sizeof(line),
+        "<tr style=\"color: rgb(32, 33, 36); font-family: Arial, sans-serif; "
+        "font-size: 14px;\"><td class=\"cell\"><a href=\"https://example.com/"
+        "item/%d\">Item %d</a></td><td style=\"text-align: right;\">%d.%02d "
+        "\xE2\x82\xAC</td><td>caf\xC3\xA9 &amp; cr\xC3\xA8me</td></tr>\r\n",
+        row, row, row * 7, row % 100);
+    html += line;
+  }
+  return html;
+}
+
+// Rewrites the value of header field |key| as -1, padded to the same width.
+void ClearOffset(std::string* payload, const char* key) {
+  const size_t at = payload->find(key);
+  if (at != std::string::npos) {
+    payload->replace(at + std::strlen(key), 10, "-000000001");
+  }
+}
+
+}  // namespace
+
+int main() {
+  const size_t sizes[] = {4 << 10, 256 << 10, 4 << 20, 16 << 20};
+  for (size_t size : sizes) {
+    const std::string fragment = BrowserFragment(size);
+    const size_t encoded_size = clipboard::CfHtmlEncodedSize(fragment.size());
+    std::vector<char> out(encoded_size + 1);
+    std::vector<char> copy(encoded_size + 1);
+    const double bytes = static_cast<double>(fragment.size());
+    const int iterations = size >= (4 << 20) ? 5 : 20;
+
+    std::printf("\n%zu byte fragment, best of %d\n", fragment.size(),
+                iterations);
+    const double memcpy_ms = clipboard_test::BestMillis(iterations, [&] {
+      std::memcpy(copy.data(), out.data(), out.size());
+    });
+    clipboard_test::PrintResult("memcpy", memcpy_ms, bytes, memcpy_ms);
+
+    const double write_ms = clipboard_test::BestMillis(iterations, [&] {
+      clipboard::WriteCfHtml(fragment.data(), fragment.size(), out.data());
+    });
+    clipboard_test::PrintResult("WriteCfHtml", write_ms, bytes, memcpy_ms);
+
+    const double encode_ms = clipboard_test::BestMillis(iterations, [&] {
+      clipboard::EncodeCfHtml(fragment);
+    });
+    clipboard_test::PrintResult("EncodeCfHtml", encode_ms, bytes, memcpy_ms);
+
+    const std::string payload = clipboard::EncodeCfHtml(fragment);
+    clipboard::CfHtmlFragment decoded;
+    const double decode_ms = clipboard_test::BestMillis(iterations, [&] {
+      clipboard::DecodeCfHtml(payload.data(), payload.size(), &decoded);
+    });
+    clipboard_test::PrintResult("DecodeCfHtml, offsets", decode_ms, bytes,
+                                memcpy_ms);
+
+    std::string unset = payload;
+    ClearOffset(&unset, "StartFragment:");
+    ClearOffset(&unset, "EndFragment:");
+    clipboard::CfHtmlFragment scanned;
+    const double scan_ms = clipboard_test::BestMillis(iterations, [&] {
+      clipboard::DecodeCfHtml(unset.data(), unset.size(), &scanned);
+    });
+    clipboard_test::PrintResult("DecodeCfHtml, markers", scan_ms, bytes,
+                                memcpy_ms);
+    if (decoded.html != fragment || scanned.html != fragment) {
+      std::printf("fragment mismatch\n");
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,196 @@
+#include "cf_html.h"
+
+#include <cstdlib>
+#include <string>
+
+#include "test_util.h"
+
+using clipboard::CfHtmlEncodedSize;
+using clipboard::CfHtmlFragment;
+using clipboard::DecodeCfHtml;
+using clipboard::EncodeCfHtml;
+using clipboard::WriteCfHtml;
+
+namespace {
+
+bool Decode(const std::string& payload, CfHtmlFragment* fragment) {
+  return DecodeCfHtml(payload.data(), payload.size(), fragment);
+}
+
+// Value of header |key| in |payload|, or -1.
+long long HeaderValue(const std::string& payload, const std::string& key) {
+  const size_t pos = payload.find(key + ":");
+  if (pos == std::string::npos) {
+    return -1;
+  }
+  return std::atoll(payload.c_str() + pos + key.size() + 1);
+}
+
+// Overwrites the 10-digit value of header |key| in |payload|.
+void SetOffset(std::string* payload, const std::string& key, size_t value) {
+  const std::string digits = std::to_string(value);
+  payload->replace(payload->find(key + ":") + key.size() + 1, 10,
+                   std::string(10 - digits.size(), '0') + digits);
+}
+
+// A payload with the header fields exactly as given, so tests can supply
+// offsets that are wrong.
+std::string Payload(const std::string& header, const std::string& document) {
+  return "Version:0.9\r\n" + header + document;
+}
+
+}  // namespace
+
+TEST(RoundTripsAsciiFragment) {
+  const std::string fragment = "<b>Hello</b> world";
+  CfHtmlFragment decoded;
+  EXPECT_TRUE(Decode(EncodeCfHtml(fragment), &decoded));
+  EXPECT_EQ(decoded.html, fragment);
+  EXPECT_TRUE(decoded.source_url.empty());
+}
+
+// Offsets count UTF-8 bytes, not characters.
+TEST(RoundTripsNonAsciiFragment) {
+  const std::string fragment =
+      "<p>Gr\xC3\xBC\xC3\x9F" "e \xE6\x97\xA5\xE6\x9C\xAC "
+      "\xF0\x9F\x98\x80</p>";
+  const std::string encoded = EncodeCfHtml(fragment);
+  CfHtmlFragment decoded;
+  EXPECT_TRUE(Decode(encoded, &decoded));
+  EXPECT_EQ(decoded.html, fragment);
+
+  const long long start = HeaderValue(encoded, "StartFragment");
+  const long long end = HeaderValue(encoded, "EndFragment");
+  EXPECT_EQ(static_cast<size_t>(end - start), fragment.size());
+  EXPECT_EQ(encoded.substr(static_cast<size_t>(start), fragment.size()),
+            fragment);
+}
+
+TEST(RoundTripsEmptyFragment) {
+  CfHtmlFragment decoded;
+  decoded.html = "stale";
+  EXPECT_TRUE(Decode(EncodeCfHtml(""), &decoded));
+  EXPECT_TRUE(decoded.html.empty());
+}
+
+TEST(HeaderOffsetsDescribeTheDocument) {
+  const std::string encoded = EncodeCfHtml("<i>x</i>");
+  EXPECT_EQ(encoded.size(), CfHtmlEncodedSize(8));
+  const long long start_html = HeaderValue(encoded, "StartHTML");
+  EXPECT_EQ(encoded.compare(static_cast<size_t>(start_html), 6, "<html>"), 0);
+  EXPECT_EQ(HeaderValue(encoded, "EndHTML"),
+            static_cast<long long>(encoded.size()));
+}
+
+TEST(WriteCfHtmlTerminatesWithNul) {
+  const std::string fragment = "abc";
+  std::string out(CfHtmlEncodedSize(fragment.size()) + 1, 'x');
+  WriteCfHtml(fragment.data(), fragment.size(), &out[0]);
+  EXPECT_EQ(out.back(), '\0');
+  EXPECT_EQ(out.substr(0, out.size() - 1), EncodeCfHtml(fragment));
+}
+
+TEST(ReadsSourceUrl) {
+  const std::string document =
+      "<html><body><!--StartFragment-->a<!--EndFragment--></body></html>";
+  CfHtmlFragment decoded;
+  EXPECT_TRUE(Decode(Payload("StartHTML:-1\r\nEndHTML:-1\r\n"
+                             "StartFragment:-1\r\nEndFragment:-1\r\n"
+                             "SourceURL:https://example.com/a?b=c\r\n",
+                             document),
+                     &decoded));
+  EXPECT_EQ(decoded.source_url, "https://example.com/a?b=c");
+  EXPECT_EQ(decoded.html, "a");
+}
+
+TEST(MissingSourceUrlIsEmpty) {
+  CfHtmlFragment decoded;
+  decoded.source_url = "stale";
+  EXPECT_TRUE(Decode(EncodeCfHtml("a"), &decoded));
+  EXPECT_TRUE(decoded.source_url.empty());
+}
+
+TEST(UnparsableOffsetsFallBackToMarkers) {
+  const std::string document =
+      "<html><body><!--StartFragment--><u>u</u><!--EndFragment-->"
+      "</body></html>";
+  CfHtmlFragment decoded;
+  EXPECT_TRUE(Decode(Payload("StartHTML:abc\r\nEndHTML:\r\n"
+                             "StartFragment:x1\r\nEndFragment:-5\r\n",
+                             document),
+                     &decoded));
+  EXPECT_EQ(decoded.html, "<u>u</u>");
+}
+
+TEST(OutOfRangeOffsetsFallBackToMarkers) {
+  const std::string document =
+      "<html><body><!--StartFragment-->frag<!--EndFragment--></body></html>";
+  const char* const headers[] = {
+      // Past the end of the payload
+      "StartFragment:0000000100\r\nEndFragment:0000099999\r\n",
+      // Start after end
+      "StartFragment:0000000090\r\nEndFragment:0000000080\r\n",
+      // Inside the header
+      "StartFragment:0000000002\r\nEndFragment:0000000008\r\n",
+      // Too large to parse
+      "StartFragment:99999999999999999999\r\nEndFragment:1\r\n",
+  };
+  for (const char* header : headers) {
+    CfHtmlFragment decoded;
+    EXPECT_TRUE(Decode(Payload(header, document), &decoded));
+    EXPECT_EQ(decoded.html, "frag");
+  }
+}
+
+TEST(ValidOffsetsWinOverMarkers) {
+  std::string payload = Payload(
+      "StartFragment:0000000000\r\nEndFragment:0000000000\r\n",
+      "<html><!--StartFragment-->marked<!--EndFragment-->"
+      "<b>offset</b></html>");
+  SetOffset(&payload, "StartFragment", payload.find("<b>"));
+  SetOffset(&payload, "EndFragment", payload.find("</html>"));
+  CfHtmlFragment decoded;
+  EXPECT_TRUE(Decode(payload, &decoded));
+  EXPECT_EQ(decoded.html, "<b>offset</b>");
+}
+
+TEST(FragmentWithoutMarkersUsesOffsets) {
+  // Some producers omit the comments and rely on the offsets alone.
+  std::string payload =
+      Payload("StartFragment:0000000000\r\nEndFragment:0000000000\r\n",
+              "<html><body><p>plain</p></body></html>");
+  SetOffset(&payload, "StartFragment", payload.find("<p>"));
+  SetOffset(&payload, "EndFragment", payload.find("</body>"));
+  CfHtmlFragment decoded;
+  EXPECT_TRUE(Decode(payload, &decoded));
+  EXPECT_EQ(decoded.html, "<p>plain</p>");
+}
+
+TEST(NoMarkersAndBadOffsetsReturnsDocument) {
+  const std::string document = "<html><body><p>all</p></body></html>";
+  CfHtmlFragment decoded;
+  EXPECT_TRUE(Decode(Payload("StartFragment:-1\r\nEndFragment:-1\r\n",
+                             document),
+                     &decoded));
+  EXPECT_EQ(decoded.html, document);
+}
+
+TEST(StopsAtNulAndSize) {
+  const std::string encoded = EncodeCfHtml("<b>x</b>");
+  std::string padded = encoded + std::string("\0garbage", 8);
+  CfHtmlFragment decoded;
+  EXPECT_TRUE(Decode(padded, &decoded));
+  EXPECT_EQ(decoded.html, "<b>x</b>");
+
+  // Cut before the end marker: the offsets no longer fit, and the marker
+  // search must not read past |size|.
+  const size_t cut = encoded.find("<!--EndFragment-->");
+  EXPECT_TRUE(DecodeCfHtml(encoded.data(), cut, &decoded));
+  EXPECT_TRUE(decoded.html.size() <= cut);
+}
+
+TEST(RejectsPayloadWithoutHeader) {
+  CfHtmlFragment decoded;
+  EXPECT_FALSE(Decode("<html><body>hi</body></html>", &decoded));
+  EXPECT_FALSE(Decode("", &decoded));
+}
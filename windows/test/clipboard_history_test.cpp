@@ -0,0 +1,152 @@
+#include "clipboard_history.h"
+
+#include <string>
+#include <vector>
+
+#include "test_util.h"
+
+using clipboard::ClipboardContent;
+using clipboard::ClipboardHistory;
+using clipboard::HistoryRecord;
+
+namespace {
+
+// Matches the bookkeeping ClipboardHistory charges per entry.
+constexpr size_t kEntryOverhead = 128;
+
+ClipboardContent Text(const std::string& text) {
+  ClipboardContent content;
+  content.text = text;
+  return content;
+}
+
+// Ids of the whole history, newest capture first.
+std::vector<uint64_t> Ids(ClipboardHistory* history) {
+  std::vector<uint64_t> ids;
+  for (const HistoryRecord& record : history->Page(0, 1000)) {
+    ids.push_back(record.id);
+  }
+  return ids;
+}
+
+}  // namespace
+
+TEST(CapturingTheSameContentAgainMovesItToTheFront) {
+  ClipboardHistory history;
+  const uint64_t first = history.Add(Text("one"), 100);
+  const uint64_t second = history.Add(Text("two"), 200);
+  EXPECT_EQ(history.Add(Text("one"), 300), first);
+  EXPECT_TRUE(Ids(&history) == std::vector<uint64_t>({first, second}));
+  HistoryRecord record;
+  EXPECT_TRUE(history.Find(first, &record));
+  EXPECT_EQ(record.timestamp_ms, 300);
+  const clipboard::ClipboardHistoryStats stats = history.stats();
+  EXPECT_EQ(stats.entries, 2u);
+  EXPECT_EQ(stats.added, 2u);
+  EXPECT_EQ(stats.deduplicated, 1u);
+}
+
+// The same bytes in a different field, or spread differently over the file
+// list, are different content.
+TEST(DeduplicatesOnlyIdenticalContent) {
+  ClipboardHistory history;
+  ClipboardContent html;
+  html.html = "ab";
+  ClipboardContent joined;
+  joined.file_paths = {"ab"};
+  ClipboardContent split;
+  split.file_paths = {"a", "b"};
+  ClipboardContent image;
+  image.image_png = {'a', 'b'};
+  const uint64_t ids[] = {history.Add(Text("ab"), 1), history.Add(html, 2),
+                          history.Add(joined, 3), history.Add(split, 4),
+                          history.Add(image, 5)};
+  for (size_t i = 0; i < 5; i++) {
+    for (size_t j = i + 1; j < 5; j++) {
+      EXPECT_TRUE(ids[i] != ids[j]);
+    }
+  }
+  EXPECT_EQ(history.stats().deduplicated, 0u);
+  EXPECT_EQ(history.Add(split, 6), ids[3]);
+}
+
+TEST(RejectsEmptyAndOversizedContent) {
+  ClipboardHistory history(kEntryOverhead + 10, 10);
+  EXPECT_EQ(history.Add(ClipboardContent(), 1), 0u);
+  EXPECT_EQ(history.Add(Text(std::string(11, 'x')), 1), 0u);
+  EXPECT_TRUE(history.Add(Text(std::string(10, 'x')), 1) != 0u);
+  EXPECT_EQ(history.stats().entries, 1u);
+}
+
+// Fetching an entry counts as use, so the oldest untouched one goes first.
+TEST(EvictsLeastRecentlyUsedPastTheEntryLimit) {
+  ClipboardHistory history(ClipboardHistory::kDefaultMaxBytes, 3);
+  const uint64_t a = history.Add(Text("a"), 1);
+  const uint64_t b = history.Add(Text("b"), 2);
+  const uint64_t c = history.Add(Text("c"), 3);
+  HistoryRecord record;
+  EXPECT_TRUE(history.Find(a, &record));
+  const uint64_t d = history.Add(Text("d"), 4);
+  EXPECT_FALSE(history.Find(b, &record));
+  EXPECT_TRUE(Ids(&history) == std::vector<uint64_t>({d, c, a}));
+  // Capturing again is use too
+  EXPECT_EQ(history.Add(Text("c"), 5), c);
+  history.Add(Text("e"), 6);
+  EXPECT_FALSE(history.Find(a, &record));
+  EXPECT_EQ(history.stats().evicted, 2u);
+}
+
+TEST(EvictsPastTheByteBudget) {
+  const size_t entry = kEntryOverhead + 100;
+  ClipboardHistory history(3 * entry, 100);
+  std::vector<uint64_t> ids;
+  for (char c = 'a'; c <= 'e'; c++) {
+    ids.push_back(history.Add(Text(std::string(100, c)), c));
+  }
+  EXPECT_TRUE(Ids(&history) ==
+              std::vector<uint64_t>({ids[4], ids[3], ids[2]}));
+  EXPECT_EQ(history.stats().bytes, 3 * entry);
+  // One large entry displaces as many small ones as it needs
+  const uint64_t large = history.Add(Text(std::string(150, 'z')), 9);
+  EXPECT_TRUE(Ids(&history) == std::vector<uint64_t>({large, ids[4]}));
+  EXPECT_EQ(history.stats().bytes, entry + kEntryOverhead + 150);
+}
+
+TEST(SetLimitsEvictsRightAway) {
+  ClipboardHistory history;
+  const uint64_t a = history.Add(Text("a"), 1);
+  const uint64_t b = history.Add(Text("b"), 2);
+  history.Add(Text("c"), 3);
+  history.SetLimits(ClipboardHistory::kDefaultMaxBytes, 1);
+  EXPECT_EQ(history.stats().entries, 1u);
+  history.SetLimits(kEntryOverhead, 10);
+  EXPECT_EQ(history.stats().entries, 0u);
+  HistoryRecord record;
+  EXPECT_FALSE(history.Find(a, &record));
+  EXPECT_FALSE(history.Find(b, &record));
+}
+
+TEST(IdsAreNeverReused) {
+  ClipboardHistory history(ClipboardHistory::kDefaultMaxBytes, 1);
+  const uint64_t a = history.Add(Text("a"), 1);
+  const uint64_t b = history.Add(Text("b"), 2);
+  history.Clear();
+  const uint64_t again = history.Add(Text("a"), 3);
+  EXPECT_TRUE(a != b && again != a && again != b);
+  EXPECT_EQ(history.stats().entries, 1u);
+}
+
+TEST(PagesFromTheNewest) {
+  ClipboardHistory history;
+  std::vector<uint64_t> ids;
+  for (int i = 0; i < 10; i++) {
+    ids.push_back(history.Add(Text(std::to_string(i)), i));
+  }
+  const std::vector<HistoryRecord> page = history.Page(3, 4);
+  EXPECT_EQ(page.size(), 4u);
+  for (size_t i = 0; i < page.size(); i++) {
+    EXPECT_EQ(page[i].id, ids[6 - i]);
+  }
+  EXPECT_EQ(history.Page(8, 5).size(), 2u);
+  EXPECT_TRUE(history.Page(10, 5).empty());
+}
@@ -0,0 +1,146 @@
+#include "content_hash.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "test_util.h"
+
+using clipboard::Xxh64;
+
+namespace {
+
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ull;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+// The seed xxhsum's sanity checks use alongside 0.
+constexpr uint64_t kSanitySeed = 2654435761u;
+
+// xxhsum's sanity buffer: the top byte of a 64-bit multiplicative sequence.
+std::vector<uint8_t> SanityBuffer(size_t size) {
+  std::vector<uint8_t> buffer(size);
+  uint64_t generator = 2654435761u;
+  for (auto& byte : buffer) {
+    byte = static_cast<uint8_t>(generator >> 56);
+    generator *= kPrime1;
+  }
+  return buffer;
+}
+
+uint64_t Rotl(uint64_t value, int bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+// Assembles lanes a byte at a time, so it shares neither the loads nor the
+// loop structure with the implementation under test.
+uint64_t Lane(const uint8_t* p, size_t bytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < bytes; i++) {
+    value |= static_cast<uint64_t>(p[i]) << (8 * i);
+  }
+  return value;
+}
+
+uint64_t Accumulate(uint64_t accumulator, uint64_t lane) {
+  return Rotl(accumulator + lane * kPrime2, 31) * kPrime1;
+}
+
+// XXH64 as the specification states it, one stage after another.
+uint64_t ReferenceXxh64(const uint8_t* data, size_t size, uint64_t seed) {
+  size_t offset = 0;
+  uint64_t hash;
+  if (size >= 32) {
+    uint64_t lanes[4] = {seed + kPrime1 + kPrime2, seed + kPrime2, seed,
+                         seed - kPrime1};
+    for (; offset + 32 <= size; offset += 32) {
+      for (int i = 0; i < 4; i++) {
+        lanes[i] = Accumulate(lanes[i], Lane(data + offset + 8 * i, 8));
+      }
+    }
+    hash = Rotl(lanes[0], 1) + Rotl(lanes[1], 7) + Rotl(lanes[2], 12) +
+           Rotl(lanes[3], 18);
+    for (uint64_t lane : lanes) {
+      hash = (hash ^ Accumulate(0, lane)) * kPrime1 + kPrime4;
+    }
+  } else {
+    hash = seed + kPrime5;
+  }
+  hash += size;
+  for (; offset + 8 <= size; offset += 8) {
+    hash ^= Accumulate(0, Lane(data + offset, 8));
+    hash = Rotl(hash, 27) * kPrime1 + kPrime4;
+  }
+  if (offset + 4 <= size) {
+    hash ^= Lane(data + offset, 4) * kPrime1;
+    hash = Rotl(hash, 23) * kPrime2 + kPrime3;
+    offset += 4;
+  }
+  for (; offset < size; offset++) {
+    hash ^= data[offset] * kPrime5;
+    hash = Rotl(hash, 11) * kPrime1;
+  }
+  hash ^= hash >> 33;
+  hash *= kPrime2;
+  hash ^= hash >> 29;
+  hash *= kPrime3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+}  // namespace
+
+// Published values: xxhsum's sanity checks and the common test strings.
+TEST(MatchesPublishedVectors) {
+  EXPECT_EQ(Xxh64(nullptr, 0), 0xEF46DB3751D8E999ull);
+  EXPECT_EQ(Xxh64(nullptr, 0, kSanitySeed), 0xAC75FDA2929B17EFull);
+  const std::vector<uint8_t> sanity = SanityBuffer(1);
+  EXPECT_EQ(Xxh64(sanity.data(), 1), 0xE934A84ADB052768ull);
+  EXPECT_EQ(Xxh64(sanity.data(), 1, kSanitySeed), 0x5014607643A9B4C3ull);
+  EXPECT_EQ(Xxh64("abc", 3), 0x44BC2CF5AD770999ull);
+  // 43 bytes: one stripe, an 8-byte lane and a 3-byte tail
+  const std::string fox = "The quick brown fox jumps over the lazy dog";
+  EXPECT_EQ(Xxh64(fox.data(), fox.size()), 0x0B242D361FDA71BCull);
+}
+
+// Every length up to a few stripes reaches each combination of the 32-byte
+// stripe loop and the 8-, 4- and 1-byte tails.
+TEST(MatchesReferenceAroundStripesAndTails) {
+  const std::vector<uint8_t> data = SanityBuffer(200);
+  const uint64_t seeds[] = {0, 1, kSanitySeed, 0xFFFFFFFFFFFFFFFFull,
+                            0x0123456789ABCDEFull};
+  for (uint64_t seed : seeds) {
+    for (size_t size = 0; size <= data.size(); size++) {
+      if (!EXPECT_EQ(Xxh64(data.data(), size, seed),
+                     ReferenceXxh64(data.data(), size, seed))) {
+        std::fprintf(stderr, "  %zu bytes, seed %llx\n", size,
+                     static_cast<unsigned long long>(seed));
+        return;
+      }
+    }
+  }
+}
+
+TEST(SeedChangesTheHash) {
+  const std::vector<uint8_t> data = clipboard_test::RandomBytes(100, 3);
+  EXPECT_TRUE(Xxh64(data.data(), data.size(), 0) !=
+              Xxh64(data.data(), data.size(), 1));
+  EXPECT_TRUE(Xxh64(nullptr, 0, 0) != Xxh64(nullptr, 0, 1));
+}
+
+// Clipboard handles are only as aligned as GlobalLock makes them, and
+// callers hash from arbitrary offsets.
+TEST(UnalignedInputMatchesAligned) {
+  const std::vector<uint8_t> data = clipboard_test::RandomBytes(1000, 4);
+  std::vector<uint8_t> shifted(data.size() + 8);
+  for (size_t offset = 1; offset < 8; offset++) {
+    std::memcpy(shifted.data() + offset, data.data(), data.size());
+    for (size_t size : {size_t{7}, size_t{31}, size_t{32}, size_t{45},
+                        data.size()}) {
+      EXPECT_EQ(Xxh64(shifted.data() + offset, size, 9),
+                Xxh64(data.data(), size, 9));
+    }
+  }
+}
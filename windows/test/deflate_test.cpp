@@ -0,0 +1,152 @@
+#include "deflate.h"
+
+#include <zlib.h>
+
+#include <vector>
+
+#include "test_util.h"
+#include "thread_pool.h"
+
+using clipboard::Adler32;
+using clipboard::Adler32Combine;
+using clipboard::ZlibCompress;
+using clipboard::ZlibOptions;
+
+namespace {
+
+// zlib's own checksum, as the reference.
+uint32_t ReferenceAdler32(const std::vector<uint8_t>& data, size_t begin,
+                          size_t end) {
+  return static_cast<uint32_t>(adler32(
+      adler32(0, nullptr, 0), data.data() + begin,
+      static_cast<uInt>(end - begin)));
+}
+
+bool Inflate(const std::vector<uint8_t>& stream, size_t size,
+             std::vector<uint8_t>* data) {
+  data->assign(size + 1, 0);
+  uLongf inflated = static_cast<uLongf>(data->size());
+  if (uncompress(data->data(), &inflated, stream.data(),
+                 static_cast<uLong>(stream.size())) != Z_OK) {
+    return false;
+  }
+  data->resize(inflated);
+  return true;
+}
+
+// Repetitive with noise, so matches cross every piece boundary.
+std::vector<uint8_t> Scanlike(size_t size) {
+  std::vector<uint8_t> data = clipboard_test::RandomBytes(size, 5);
+  for (size_t i = 0; i < size; i++) {
+    if ((i / 700) % 3 != 0) {
+      data[i] = static_cast<uint8_t>(i % 251);
+    }
+  }
+  return data;
+}
+
+}  // namespace
+
+TEST(Adler32MatchesZlib) {
+  // Around zlib's 5552-byte deferred-modulo block, and past it many times
+  const size_t sizes[] = {0, 1, 15, 16, 5551, 5552, 5553, 65521, 1 << 20};
+  const std::vector<uint8_t> random =
+      clipboard_test::RandomBytes(1 << 20, 11);
+  const std::vector<uint8_t> ones(1 << 20, 0xFF);
+  for (size_t size : sizes) {
+    EXPECT_EQ(Adler32(1, random.data(), size),
+              ReferenceAdler32(random, 0, size));
+    EXPECT_EQ(Adler32(1, ones.data(), size), ReferenceAdler32(ones, 0, size));
+  }
+}
+
+TEST(Crc32MatchesZlib) {
+  const std::vector<uint8_t> random = clipboard_test::RandomBytes(70000, 12);
+  for (size_t size : {size_t{0}, size_t{1}, size_t{17}, random.size()}) {
+    EXPECT_EQ(clipboard::Crc32(0, random.data(), size),
+              static_cast<uint32_t>(crc32(crc32(0, nullptr, 0), random.data(),
+                                          static_cast<uInt>(size))));
+  }
+}
+
+// Combining the checksums of any split equals one pass over the whole.
+// All-0xFF input keeps both sums near the modulus.
+TEST(Adler32CombineMatchesOnePass) {
+  const size_t size = 300 * 1024;
+  const std::vector<uint8_t> inputs[] = {
+      clipboard_test::RandomBytes(size, 13), std::vector<uint8_t>(size, 0xFF),
+      std::vector<uint8_t>(size, 0)};
+  const size_t splits[] = {0,     1,     2,         5552,     65520,
+                           65521, 65522, 65536 * 2, size - 1, size};
+  for (const auto& data : inputs) {
+    const uint32_t whole = ReferenceAdler32(data, 0, size);
+    for (size_t split : splits) {
+      const uint32_t first = Adler32(1, data.data(), split);
+      const uint32_t second = Adler32(1, data.data() + split, size - split);
+      if (!EXPECT_EQ(Adler32Combine(first, second, size - split), whole)) {
+        std::fprintf(stderr, "  split at %zu\n", split);
+      }
+    }
+  }
+}
+
+// Three-way combine, as ZlibCompress folds its pieces left to right.
+TEST(Adler32CombineFoldsManyPieces) {
+  const std::vector<uint8_t> data = clipboard_test::RandomBytes(1 << 20, 14);
+  uint32_t folded = 1;
+  size_t begin = 0;
+  for (size_t piece : {size_t{0}, size_t{70000}, size_t{262144}, size_t{3},
+                       size_t{1 << 19}}) {
+    const size_t end = begin + piece;
+    folded = Adler32Combine(folded, Adler32(1, data.data() + begin, piece),
+                            piece);
+    begin = end;
+  }
+  folded = Adler32Combine(
+      folded, Adler32(1, data.data() + begin, data.size() - begin),
+      data.size() - begin);
+  EXPECT_EQ(folded, ReferenceAdler32(data, 0, data.size()));
+}
+
+// Splitting into pieces changes where blocks end (each piece ends with a
+// sync flush), so the compressed bytes differ; what must not differ is the
+// data they inflate to, or the trailer zlib verifies it against.
+TEST(ZlibCompressInflatesTheSameForEveryPieceCount) {
+  clipboard::ThreadPool pool(3);
+  const size_t sizes[] = {0, 1000, 256 * 1024 * 2 + 7, 3 * 1024 * 1024 + 1};
+  for (size_t size : sizes) {
+    const std::vector<uint8_t> data = Scanlike(size);
+    std::vector<uint8_t> single;
+    ZlibCompress(data.data(), data.size(), &single);
+    for (size_t pieces = 1; pieces <= 8; pieces++) {
+      ZlibOptions options;
+      options.thread_pool = &pool;
+      options.piece_count = pieces;
+      std::vector<uint8_t> stream;
+      ZlibCompress(data.data(), data.size(), &stream, options);
+      std::vector<uint8_t> inflated;
+      if (!EXPECT_TRUE(Inflate(stream, size, &inflated)) ||
+          !EXPECT_TRUE(inflated == data)) {
+        std::fprintf(stderr, "  %zu bytes in %zu pieces\n", size, pieces);
+        continue;
+      }
+      // One piece takes the serial path, byte for byte
+      if (pieces == 1) {
+        EXPECT_TRUE(stream == single);
+      }
+      // The sync flushes cost a few bytes each, not a lost window
+      EXPECT_TRUE(stream.size() <= single.size() + single.size() / 50 + 64);
+    }
+  }
+}
+
+TEST(ZlibCompressAppendsToExistingOutput) {
+  const std::vector<uint8_t> data = Scanlike(4096);
+  std::vector<uint8_t> out = {1, 2, 3};
+  ZlibCompress(data.data(), data.size(), &out);
+  EXPECT_EQ(out[0], 1);
+  const std::vector<uint8_t> stream(out.begin() + 3, out.end());
+  std::vector<uint8_t> inflated;
+  EXPECT_TRUE(Inflate(stream, data.size(), &inflated));
+  EXPECT_TRUE(inflated == data);
+}
@@ -0,0 +1,107 @@
+#include "dib_image.h"
+
+#include <vector>
+
+#include "test_util.h"
+
+using clipboard::DibImage;
+using clipboard::DibPixelFormat;
+using clipboard::ParseDib;
+
+namespace {
+
+constexpr int kWidth = 3;
+constexpr int kHeight = 2;
+// 24-bit rows of 3 pixels, padded to 12 bytes
+constexpr size_t kStride = 12;
+
+void PutU32(std::vector<uint8_t>* data, size_t offset, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    (*data)[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+// A bottom-up 24-bit BITMAPINFOHEADER, |gap| bytes of something other than
+// pixels, then the pixels. |colors_used| is declared but not written.
+std::vector<uint8_t> DibWithGap(size_t gap, uint32_t colors_used) {
+  std::vector<uint8_t> dib(40 + gap, 0xEE);
+  PutU32(&dib, 0, 40);
+  PutU32(&dib, 4, kWidth);
+  PutU32(&dib, 8, kHeight);
+  PutU32(&dib, 12, 1 | 24 << 16);
+  PutU32(&dib, 16, 0);
+  PutU32(&dib, 32, colors_used);
+  const std::vector<uint8_t> pixels =
+      clipboard_test::RandomBytes(kStride * kHeight, 21);
+  dib.insert(dib.end(), pixels.begin(), pixels.end());
+  return dib;
+}
+
+// The view's top row is the last row stored.
+bool ViewsPixelsAt(const std::vector<uint8_t>& dib, const DibImage& image,
+                   size_t pixel_offset) {
+  return EXPECT_EQ(image.width, kWidth) && EXPECT_EQ(image.height, kHeight) &&
+         EXPECT_TRUE(image.format == DibPixelFormat::kBgr) &&
+         EXPECT_EQ(image.stride, -static_cast<ptrdiff_t>(kStride)) &&
+         EXPECT_TRUE(image.pixels ==
+                     dib.data() + pixel_offset + kStride * (kHeight - 1));
+}
+
+}  // namespace
+
+TEST(PackedDibPixelsFollowTheColorTable) {
+  const std::vector<uint8_t> dib = DibWithGap(8, 2);
+  DibImage image;
+  EXPECT_TRUE(ParseDib(dib.data(), dib.size(), &image));
+  ViewsPixelsAt(dib, image, 48);
+}
+
+// .bmp files may leave a gap before the pixels that only bfOffBits
+// accounts for.
+TEST(ExplicitOffsetOverridesTheLayout) {
+  const std::vector<uint8_t> dib = DibWithGap(20, 0);
+  DibImage image;
+  EXPECT_TRUE(ParseDib(dib.data(), dib.size(), 60, &image));
+  ViewsPixelsAt(dib, image, 60);
+}
+
+// A declared color table larger than the gap is only a hint.
+TEST(ExplicitOffsetIgnoresColorTableSize) {
+  const std::vector<uint8_t> dib = DibWithGap(4, 100);
+  DibImage image;
+  EXPECT_FALSE(ParseDib(dib.data(), dib.size(), &image));
+  EXPECT_TRUE(ParseDib(dib.data(), dib.size(), 44, &image));
+  ViewsPixelsAt(dib, image, 44);
+}
+
+TEST(RejectsOffsetInsideTheHeader) {
+  const std::vector<uint8_t> dib = DibWithGap(0, 0);
+  DibImage image;
+  EXPECT_FALSE(ParseDib(dib.data(), dib.size(), 0, &image));
+  EXPECT_FALSE(ParseDib(dib.data(), dib.size(), 39, &image));
+  EXPECT_TRUE(ParseDib(dib.data(), dib.size(), 40, &image));
+}
+
+// BI_BITFIELDS masks after a plain BITMAPINFOHEADER are part of the header.
+TEST(RejectsOffsetInsideTheMasks) {
+  std::vector<uint8_t> dib(40 + 12 + 4 * 4 * 2, 0);
+  PutU32(&dib, 0, 40);
+  PutU32(&dib, 4, 4);
+  PutU32(&dib, 8, 2);
+  PutU32(&dib, 12, 1 | 32 << 16);
+  PutU32(&dib, 16, 3);
+  PutU32(&dib, 40, 0x00FF0000u);
+  PutU32(&dib, 44, 0x0000FF00u);
+  PutU32(&dib, 48, 0x000000FFu);
+  DibImage image;
+  EXPECT_FALSE(ParseDib(dib.data(), dib.size(), 48, &image));
+  EXPECT_TRUE(ParseDib(dib.data(), dib.size(), 52, &image));
+}
+
+TEST(RejectsPixelsPastTheEnd) {
+  const std::vector<uint8_t> dib = DibWithGap(0, 0);
+  DibImage image;
+  EXPECT_FALSE(ParseDib(dib.data(), dib.size(), 41, &image));
+  EXPECT_FALSE(ParseDib(dib.data(), dib.size(), dib.size(), &image));
+  EXPECT_FALSE(ParseDib(dib.data(), dib.size() - 1, 40, &image));
+}
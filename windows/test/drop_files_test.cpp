@@ -0,0 +1,145 @@
+#include "drop_files.h"
+
+#include <string>
+#include <vector>
+
+#include "test_util.h"
+
+using clipboard::ParseDropFiles;
+
+namespace {
+
+void PutU32(std::vector<uint8_t>* data, size_t offset, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    (*data)[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+// A DROPFILES header with pFiles = |files_offset| and fWide = |wide|,
+// padded to |files_offset| bytes.
+std::vector<uint8_t> Header(uint32_t files_offset, bool wide) {
+  std::vector<uint8_t> data(files_offset < 20 ? 20 : files_offset, 0);
+  PutU32(&data, 0, files_offset);
+  PutU32(&data, 16, wide ? 1 : 0);
+  return data;
+}
+
+// A CF_HDROP payload of |paths|, each NUL-terminated, then the empty path.
+std::vector<uint8_t> WideDrop(const std::vector<std::u16string>& paths) {
+  std::vector<uint8_t> data = Header(20, true);
+  auto append = [&data](char16_t unit) {
+    data.push_back(static_cast<uint8_t>(unit));
+    data.push_back(static_cast<uint8_t>(unit >> 8));
+  };
+  for (const auto& path : paths) {
+    for (char16_t unit : path) {
+      append(unit);
+    }
+    append(0);
+  }
+  append(0);
+  return data;
+}
+
+std::vector<std::u16string> Parse(const std::vector<uint8_t>& data,
+                                  size_t size, bool* ok) {
+  std::vector<std::u16string_view> views;
+  *ok = ParseDropFiles(data.data(), size, &views);
+  return std::vector<std::u16string>(views.begin(), views.end());
+}
+
+}  // namespace
+
+TEST(ReadsWidePaths) {
+  const std::vector<std::u16string> paths = {
+      u"C:\\Users\\a\\report.pdf", u"D:\\\u65E5\u672C\\\u00E9t\u00E9.png",
+      u"\\\\server\\share\\x"};
+  const std::vector<uint8_t> data = WideDrop(paths);
+  bool ok = false;
+  EXPECT_TRUE(Parse(data, data.size(), &ok) == paths);
+  EXPECT_TRUE(ok);
+}
+
+// Each view ends at a NUL in the payload, so it doubles as a C string.
+TEST(ViewsAreNulTerminatedInPlace) {
+  const std::vector<uint8_t> data = WideDrop({u"a", u"bc"});
+  std::vector<std::u16string_view> views;
+  EXPECT_TRUE(ParseDropFiles(data.data(), data.size(), &views));
+  for (const auto& view : views) {
+    EXPECT_EQ(view.data()[view.size()], u'\0');
+  }
+}
+
+TEST(ReadsEmptyList) {
+  const std::vector<uint8_t> data = WideDrop({});
+  bool ok = false;
+  EXPECT_TRUE(Parse(data, data.size(), &ok).empty());
+  EXPECT_TRUE(ok);
+}
+
+// Producers may leave a gap between the header and the paths.
+TEST(HonorsFilesOffset) {
+  std::vector<uint8_t> data = Header(28, true);
+  const std::vector<uint8_t> list = WideDrop({u"x.txt"});
+  data.insert(data.end(), list.begin() + 20, list.end());
+  bool ok = false;
+  EXPECT_TRUE(Parse(data, data.size(), &ok) ==
+              std::vector<std::u16string>({u"x.txt"}));
+  EXPECT_TRUE(ok);
+}
+
+TEST(RejectsAnsiLists) {
+  std::vector<uint8_t> data = Header(20, false);
+  for (char c : std::string("C:\\a.txt\0C:\\b.txt\0\0", 20)) {
+    data.push_back(static_cast<uint8_t>(c));
+  }
+  bool ok = true;
+  EXPECT_TRUE(Parse(data, data.size(), &ok).empty());
+  EXPECT_FALSE(ok);
+}
+
+// A list cut short, as GlobalSize of a damaged handle or a sloppy producer
+// leaves it, keeps exactly the paths whose terminator is in bounds.
+TEST(KeepsPathsThatEndInBounds) {
+  const std::vector<uint8_t> data = WideDrop({u"first", u"second"});
+  const size_t first_end = 20 + 6 * 2;
+  const size_t second_end = first_end + 7 * 2;
+  for (size_t size = 20; size <= data.size(); size++) {
+    bool ok = false;
+    const std::vector<std::u16string> paths = Parse(data, size, &ok);
+    const size_t expected =
+        size >= second_end ? 2 : (size >= first_end ? 1 : 0);
+    if (!EXPECT_TRUE(ok) || !EXPECT_EQ(paths.size(), expected)) {
+      std::fprintf(stderr, "  %zu bytes\n", size);
+      return;
+    }
+  }
+}
+
+// Without the closing empty path the list still ends at the buffer.
+TEST(ReadsListWithoutFinalTerminator) {
+  std::vector<uint8_t> data = WideDrop({u"a", u"b"});
+  data.resize(data.size() - 2);
+  bool ok = false;
+  EXPECT_EQ(Parse(data, data.size(), &ok).size(), 2u);
+  EXPECT_TRUE(ok);
+}
+
+TEST(RejectsMalformedHeaders) {
+  const std::vector<uint8_t> valid = WideDrop({u"a"});
+  bool ok = true;
+  // Shorter than DROPFILES
+  Parse(valid, 19, &ok);
+  EXPECT_FALSE(ok);
+  // pFiles inside the header, past the end, and misaligned
+  for (uint32_t offset : {0u, 19u, 100u, 21u}) {
+    std::vector<uint8_t> data = valid;
+    data.resize(40, 0);
+    PutU32(&data, 0, offset);
+    ok = true;
+    Parse(data, data.size(), &ok);
+    if (!EXPECT_FALSE(ok)) {
+      std::fprintf(stderr, "  pFiles %u\n", offset);
+    }
+  }
+}
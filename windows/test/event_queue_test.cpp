@@ -0,0 +1,118 @@
+#include "event_queue.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "test_util.h"
+
+using clipboard::EventQueue;
+
+namespace {
+
+std::vector<int> Drain(EventQueue<int>* queue) {
+  std::vector<int> values;
+  int value = 0;
+  while (queue->Pop(&value)) {
+    values.push_back(value);
+  }
+  return values;
+}
+
+}  // namespace
+
+// By default only the latest change is kept: a burst of copies delivers
+// one event, describing the clipboard as it ended up.
+TEST(LatestWinsByDefault) {
+  EventQueue<int> queue;
+  EXPECT_TRUE(queue.Push(1));
+  EXPECT_FALSE(queue.Push(2));
+  EXPECT_FALSE(queue.Push(3));
+  EXPECT_TRUE(Drain(&queue) == std::vector<int>({3}));
+  const clipboard::EventQueueStats stats = queue.stats();
+  EXPECT_EQ(stats.pushed, 3u);
+  EXPECT_EQ(stats.popped, 1u);
+  EXPECT_EQ(stats.dropped, 2u);
+  EXPECT_EQ(stats.pending, 0u);
+}
+
+TEST(KeepsTheNewestInOrderUpToCapacity) {
+  EventQueue<int> queue(3);
+  for (int i = 1; i <= 5; i++) {
+    EXPECT_EQ(queue.Push(i), i <= 3);
+  }
+  EXPECT_TRUE(Drain(&queue) == std::vector<int>({3, 4, 5}));
+  int value = 0;
+  EXPECT_FALSE(queue.Pop(&value));
+}
+
+TEST(ShrinkingDropsTheOldest) {
+  EventQueue<int> queue(4);
+  for (int i = 1; i <= 4; i++) {
+    queue.Push(i);
+  }
+  queue.SetCapacity(2);
+  EXPECT_EQ(queue.stats().dropped, 2u);
+  EXPECT_TRUE(Drain(&queue) == std::vector<int>({3, 4}));
+}
+
+TEST(CapacityIsAtLeastOne) {
+  EventQueue<int> queue(0);
+  EXPECT_EQ(queue.capacity(), 1u);
+  queue.SetCapacity(0);
+  EXPECT_EQ(queue.capacity(), 1u);
+  queue.Push(1);
+  queue.Push(2);
+  EXPECT_TRUE(Drain(&queue) == std::vector<int>({2}));
+}
+
+TEST(ClearIsNotCountedAsDropped) {
+  EventQueue<int> queue(2);
+  queue.Push(1);
+  queue.Push(2);
+  queue.Clear();
+  const clipboard::EventQueueStats stats = queue.stats();
+  EXPECT_EQ(stats.dropped, 0u);
+  EXPECT_EQ(stats.pending, 0u);
+  int value = 0;
+  EXPECT_FALSE(queue.Pop(&value));
+}
+
+TEST(HoldsMoveOnlyEvents) {
+  EventQueue<std::unique_ptr<int>> queue;
+  queue.Push(std::make_unique<int>(1));
+  queue.Push(std::make_unique<int>(2));
+  std::unique_ptr<int> value;
+  EXPECT_TRUE(queue.Pop(&value));
+  EXPECT_EQ(*value, 2);
+}
+
+// A consumer slower than the producer sees events in order, never the
+// same one twice, and always ends on the latest; every event is either
+// delivered or counted as dropped.
+TEST(ConsumerAlwaysEndsOnTheLatest) {
+  constexpr int kEvents = 100000;
+  EventQueue<int> queue(2);
+  std::thread producer([&queue] {
+    for (int i = 1; i <= kEvents; i++) {
+      queue.Push(i);
+    }
+  });
+  int last = 0;
+  bool ordered = true;
+  while (last != kEvents) {
+    int value = 0;
+    if (queue.Pop(&value)) {
+      ordered = ordered && value > last;
+      last = value;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  EXPECT_TRUE(ordered);
+  const clipboard::EventQueueStats stats = queue.stats();
+  EXPECT_EQ(stats.pushed, static_cast<uint64_t>(kEvents));
+  EXPECT_EQ(stats.popped + stats.dropped, static_cast<uint64_t>(kEvents));
+  EXPECT_EQ(stats.pending, 0u);
+}
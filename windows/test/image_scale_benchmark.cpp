@@ -0,0 +1,73 @@
+// Times the thumbnail downscale of a 4K capture to fit 256 pixels, the
+// size pasteImageThumbnail is typically asked for, with each filter on the
+// scalar and SIMD kernels. Each source pixel format is timed, since rows
+// are widened to 32 bits before they are filtered.
+
+#include <cstdio>
+#include <vector>
+
+#include "benchmark_util.h"
+#include "image_scale.h"
+#include "test_util.h"
+
+using clipboard::DibImage;
+using clipboard::DibPixelFormat;
+using clipboard::ScaleFilter;
+
+int main() {
+  const int width = 3840;
+  const int height = 2160;
+  int thumb_width = 0;
+  int thumb_height = 0;
+  clipboard::FitWithin(width, height, 256, &thumb_width, &thumb_height);
+  std::vector<uint8_t> thumbnail(static_cast<size_t>(thumb_width) *
+                                 thumb_height * 4);
+
+  const struct {
+    const char* name;
+    DibPixelFormat format;
+  } formats[] = {
+      {"bgra", DibPixelFormat::kBgra},
+      {"bgrx", DibPixelFormat::kBgrx},
+      {"bgr", DibPixelFormat::kBgr},
+  };
+  const struct {
+    const char* name;
+    ScaleFilter filter;
+  } filters[] = {
+      {"box", ScaleFilter::kBox},
+      {"lanczos3", ScaleFilter::kLanczos3},
+  };
+
+  std::printf("%dx%d -> %dx%d, best of 5\n", width, height, thumb_width,
+              thumb_height);
+  for (const auto& format : formats) {
+    const size_t bpp = clipboard::DibBytesPerPixel(format.format);
+    const size_t stride = (static_cast<size_t>(width) * bpp + 3) / 4 * 4;
+    const double bytes = static_cast<double>(stride) * height;
+    const std::vector<uint8_t> pixels =
+        clipboard_test::ScreenshotPixels(width, height, bpp, stride, 1);
+    // Bottom-up, as CF_DIB captures are
+    DibImage image;
+    image.width = width;
+    image.height = height;
+    image.format = format.format;
+    image.stride = -static_cast<ptrdiff_t>(stride);
+    image.pixels = pixels.data() + stride * (height - 1);
+
+    for (const auto& filter : filters) {
+      std::printf("\n%s, %s\n", format.name, filter.name);
+      const double scalar_ms = clipboard_test::BestMillis(5, [&] {
+        clipboard::ScaleDibImageScalar(image, thumb_width, thumb_height,
+                                       filter.filter, thumbnail.data());
+      });
+      clipboard_test::PrintResult("scalar", scalar_ms, bytes, scalar_ms);
+      const double ms = clipboard_test::BestMillis(5, [&] {
+        clipboard::ScaleDibImage(image, thumb_width, thumb_height,
+                                 filter.filter, thumbnail.data());
+      });
+      clipboard_test::PrintResult("simd", ms, bytes, scalar_ms);
+    }
+  }
+  return 0;
+}
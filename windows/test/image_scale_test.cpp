@@ -0,0 +1,143 @@
+#include "image_scale.h"
+
+#include <cstdio>
+#include <vector>
+
+#include "test_util.h"
+
+using clipboard::DibImage;
+using clipboard::DibPixelFormat;
+using clipboard::FitWithin;
+using clipboard::ScaleDibImage;
+using clipboard::ScaleFilter;
+
+namespace {
+
+const ScaleFilter kFilters[] = {ScaleFilter::kBox, ScaleFilter::kLanczos3};
+
+const DibPixelFormat kFormats[] = {DibPixelFormat::kBgra,
+                                   DibPixelFormat::kBgrx,
+                                   DibPixelFormat::kBgr};
+
+// Rows padded to 4 bytes, as in a DIB.
+size_t DibStride(int width, DibPixelFormat format) {
+  return (static_cast<size_t>(width) * DibBytesPerPixel(format) + 3) / 4 * 4;
+}
+
+DibImage BottomUpView(const std::vector<uint8_t>& pixels, int width,
+                      int height, DibPixelFormat format) {
+  const ptrdiff_t stride = static_cast<ptrdiff_t>(DibStride(width, format));
+  DibImage image;
+  image.width = width;
+  image.height = height;
+  image.format = format;
+  image.pixels = pixels.data() + stride * (height - 1);
+  image.stride = -stride;
+  return image;
+}
+
+bool Fits(int width, int height, int max_dimension, int expected_width,
+          int expected_height) {
+  int fit_width = 0;
+  int fit_height = 0;
+  FitWithin(width, height, max_dimension, &fit_width, &fit_height);
+  return EXPECT_EQ(fit_width, expected_width) &&
+         EXPECT_EQ(fit_height, expected_height);
+}
+
+}  // namespace
+
+// The SIMD kernels take two source pixels and eight destination bytes at a
+// time. Odd sizes leave every remainder: a single trailing tap in the row
+// kernel, a four-byte tail and a single trailing row in the column kernel.
+TEST(SimdMatchesScalarAtOddSizes) {
+  const int sources[][2] = {{1, 1}, {3, 5}, {17, 13}, {33, 7}, {101, 57}};
+  for (ScaleFilter filter : kFilters) {
+    for (DibPixelFormat format : kFormats) {
+      for (const auto& source : sources) {
+        const int width = source[0];
+        const int height = source[1];
+        const std::vector<uint8_t> pixels = clipboard_test::RandomBytes(
+            DibStride(width, format) * height,
+            static_cast<uint32_t>(width * 7 + height));
+        const DibImage image = BottomUpView(pixels, width, height, format);
+        for (int dst_width = 1; dst_width <= width && dst_width <= 9;
+             dst_width++) {
+          for (int dst_height = 1; dst_height <= height && dst_height <= 5;
+               dst_height++) {
+            const size_t size = static_cast<size_t>(dst_width) * dst_height * 4;
+            std::vector<uint8_t> simd(size, 0xEE);
+            std::vector<uint8_t> scalar(size, 0x11);
+            ScaleDibImage(image, dst_width, dst_height, filter, simd.data());
+            clipboard::ScaleDibImageScalar(image, dst_width, dst_height, filter,
+                                           scalar.data());
+            if (!EXPECT_TRUE(simd == scalar)) {
+              std::fprintf(stderr, "  filter %d, format %d, %dx%d -> %dx%d\n",
+                           static_cast<int>(filter), static_cast<int>(format),
+                           width, height, dst_width, dst_height);
+              return;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+// Weights sum to one, so a flat image stays flat under either filter, and
+// formats without alpha come out opaque.
+TEST(FlatImageStaysFlat) {
+  const int width = 45;
+  const int height = 31;
+  for (ScaleFilter filter : kFilters) {
+    for (DibPixelFormat format : kFormats) {
+      const size_t bpp = DibBytesPerPixel(format);
+      const size_t stride = DibStride(width, format);
+      std::vector<uint8_t> pixels(stride * height);
+      for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+          uint8_t* pixel = &pixels[y * stride + x * bpp];
+          pixel[0] = 10;
+          pixel[1] = 120;
+          pixel[2] = 250;
+          if (bpp == 4) {
+            pixel[3] = 200;
+          }
+        }
+      }
+      std::vector<uint8_t> dst(7 * 5 * 4);
+      ScaleDibImage(BottomUpView(pixels, width, height, format), 7, 5, filter,
+                    dst.data());
+      const uint8_t alpha = format == DibPixelFormat::kBgra ? 200 : 255;
+      for (size_t i = 0; i < dst.size(); i += 4) {
+        if (!EXPECT_EQ(dst[i], 10) || !EXPECT_EQ(dst[i + 1], 120) ||
+            !EXPECT_EQ(dst[i + 2], 250) || !EXPECT_EQ(dst[i + 3], alpha)) {
+          std::fprintf(stderr, "  filter %d, format %d\n",
+                       static_cast<int>(filter), static_cast<int>(format));
+          break;
+        }
+      }
+    }
+  }
+}
+
+TEST(FitWithinKeepsAspectRatio) {
+  Fits(3840, 2160, 256, 256, 144);
+  Fits(2160, 3840, 256, 144, 256);
+  Fits(1000, 1000, 100, 100, 100);
+  Fits(1001, 333, 100, 100, 33);
+}
+
+TEST(FitWithinNeverEnlarges) {
+  Fits(200, 100, 256, 200, 100);
+  Fits(256, 256, 256, 256, 256);
+  Fits(1, 1, 256, 1, 1);
+}
+
+// The longest side is clamped to the maximum; a sliver keeps one pixel.
+TEST(FitWithinClampsToMaxDimension) {
+  Fits(257, 10, 256, 256, 10);
+  Fits(100000, 1, 256, 256, 1);
+  Fits(1, 100000, 64, 1, 64);
+  Fits(5000, 3, 1, 1, 1);
+}
@@ -0,0 +1,162 @@
+#include "image_sniff.h"
+
+#include <vector>
+
+#include "test_util.h"
+
+using clipboard::ImageFileFormat;
+using clipboard::PngFileSize;
+using clipboard::SniffImageFormat;
+
+namespace {
+
+const uint8_t kPngSignature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+void AppendChunk(std::vector<uint8_t>* png, const char* type,
+                 uint32_t length) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    png->push_back(static_cast<uint8_t>(length >> shift));
+  }
+  png->insert(png->end(), type, type + 4);
+  png->insert(png->end(), length + 4, 0xAB);  // data and CRC
+}
+
+// Signature, IHDR, one IDAT and IEND: the shape the "PNG" format holds.
+std::vector<uint8_t> MinimalPng() {
+  std::vector<uint8_t> png(kPngSignature,
+                           kPngSignature + sizeof(kPngSignature));
+  AppendChunk(&png, "IHDR", 13);
+  AppendChunk(&png, "IDAT", 100);
+  AppendChunk(&png, "IEND", 0);
+  return png;
+}
+
+// "BM", the rest of the 14-byte file header, then a BITMAPINFOHEADER's
+// size field.
+std::vector<uint8_t> BmpHeader() {
+  std::vector<uint8_t> bmp(clipboard::kBmpFileHeaderSize + 4, 0);
+  bmp[0] = 'B';
+  bmp[1] = 'M';
+  bmp[clipboard::kBmpFileHeaderSize] = 40;
+  return bmp;
+}
+
+// The shortest prefix of each format that is recognized.
+struct Signature {
+  ImageFileFormat format;
+  std::vector<uint8_t> bytes;
+};
+
+std::vector<Signature> Signatures() {
+  auto bytes = [](const char* data, size_t size) {
+    return std::vector<uint8_t>(data, data + size);
+  };
+  return {
+      {ImageFileFormat::kPng,
+       std::vector<uint8_t>(kPngSignature,
+                            kPngSignature + sizeof(kPngSignature))},
+      {ImageFileFormat::kJpeg, {0xFF, 0xD8, 0xFF}},
+      {ImageFileFormat::kGif, bytes("GIF87a", 6)},
+      {ImageFileFormat::kGif, bytes("GIF89a", 6)},
+      {ImageFileFormat::kWebp, bytes("RIFF\x10\0\0\0WEBP", 12)},
+      {ImageFileFormat::kBmp, BmpHeader()},
+      {ImageFileFormat::kTiff, {'I', 'I', 42, 0}},
+      {ImageFileFormat::kTiff, {'M', 'M', 0, 42}},
+  };
+}
+
+// Copies |size| bytes into a buffer of exactly that size, so a read past
+// the end is a heap overflow the sanitizers see.
+ImageFileFormat SniffPrefix(const std::vector<uint8_t>& data, size_t size) {
+  std::vector<uint8_t> prefix(data.begin(), data.begin() + size);
+  return SniffImageFormat(prefix.data(), prefix.size());
+}
+
+}  // namespace
+
+TEST(SniffsEverySignature) {
+  for (const Signature& signature : Signatures()) {
+    std::vector<uint8_t> file = signature.bytes;
+    file.resize(file.size() + 64, 0x5A);
+    EXPECT_TRUE(SniffPrefix(file, file.size()) == signature.format);
+    EXPECT_TRUE(SniffPrefix(signature.bytes, signature.bytes.size()) ==
+                signature.format);
+  }
+}
+
+// Clipboard files and streams can be cut off anywhere; a header that ends
+// early is unknown, never a guess and never a read past |size|.
+TEST(TruncatedSignaturesAreUnknown) {
+  EXPECT_TRUE(SniffImageFormat(nullptr, 0) == ImageFileFormat::kUnknown);
+  for (const Signature& signature : Signatures()) {
+    for (size_t size = 0; size < signature.bytes.size(); size++) {
+      if (!EXPECT_TRUE(SniffPrefix(signature.bytes, size) ==
+                       ImageFileFormat::kUnknown)) {
+        std::fprintf(stderr, "  format %d truncated to %zu bytes\n",
+                     static_cast<int>(signature.format), size);
+      }
+    }
+  }
+}
+
+TEST(NearMissesAreUnknown) {
+  const std::vector<uint8_t> near_misses[] = {
+      {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, 0},
+      {0xFF, 0xD8, 0x00},
+      {'G', 'I', 'F', '8', '8', 'a'},
+      // RIFF, but a WAVE file
+      {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E'},
+      {'I', 'I', 0, 42},
+  };
+  for (const auto& data : near_misses) {
+    EXPECT_TRUE(SniffPrefix(data, data.size()) == ImageFileFormat::kUnknown);
+  }
+}
+
+// "BM" starts plenty of text; only DIB header sizes Windows writes count.
+TEST(BmpNeedsAKnownDibHeaderSize) {
+  std::vector<uint8_t> bmp = BmpHeader();
+  for (uint8_t header_size : {12, 40, 52, 56, 108, 124}) {
+    bmp[clipboard::kBmpFileHeaderSize] = header_size;
+    EXPECT_TRUE(SniffPrefix(bmp, bmp.size()) == ImageFileFormat::kBmp);
+  }
+  for (uint8_t header_size : {0, 16, 41, 64, 125}) {
+    bmp[clipboard::kBmpFileHeaderSize] = header_size;
+    EXPECT_TRUE(SniffPrefix(bmp, bmp.size()) == ImageFileFormat::kUnknown);
+  }
+  const std::vector<uint8_t> text = {'B', 'M', 'W', ' ', 'i', '3'};
+  EXPECT_TRUE(SniffPrefix(text, text.size()) == ImageFileFormat::kUnknown);
+}
+
+TEST(PngFileSizeEndsAfterIend) {
+  const std::vector<uint8_t> png = MinimalPng();
+  EXPECT_EQ(PngFileSize(png.data(), png.size()), png.size());
+}
+
+// GlobalSize rounds up; the padding must not reach Dart.
+TEST(PngFileSizeTrimsPadding) {
+  std::vector<uint8_t> padded = MinimalPng();
+  const size_t size = padded.size();
+  padded.resize(size + 13, 0);
+  EXPECT_EQ(PngFileSize(padded.data(), padded.size()), size);
+}
+
+TEST(PngFileSizeRejectsTruncatedFiles) {
+  const std::vector<uint8_t> png = MinimalPng();
+  for (size_t size = 0; size < png.size(); size++) {
+    if (!EXPECT_EQ(PngFileSize(png.data(), size), 0u)) {
+      std::fprintf(stderr, "  truncated to %zu bytes\n", size);
+      return;
+    }
+  }
+}
+
+TEST(PngFileSizeRejectsBadChunkLength) {
+  std::vector<uint8_t> png = MinimalPng();
+  // IDAT claims more than the file holds
+  png[8 + 25] = 0x7F;
+  EXPECT_EQ(PngFileSize(png.data(), png.size()), 0u);
+  std::vector<uint8_t> no_signature = MinimalPng();
+  no_signature[1] = 'p';
+  EXPECT_EQ(PngFileSize(no_signature.data(), no_signature.size()), 0u);
+}
@@ -0,0 +1,106 @@
+#include "paste_cache.h"
+
+#include <string>
+
+#include "test_util.h"
+
+using clipboard::PasteCache;
+
+namespace {
+
+bool Holds(PasteCache<std::string>* cache, uint32_t sequence,
+           const std::string& key, const std::string& expected) {
+  auto value = cache->Find(sequence, key);
+  return EXPECT_TRUE(value != nullptr) && EXPECT_EQ(*value, expected);
+}
+
+}  // namespace
+
+TEST(HitsOnlyUnderTheSameSequence) {
+  PasteCache<std::string> cache;
+  cache.Store(7, "text", "hello", 5);
+  Holds(&cache, 7, "text", "hello");
+  EXPECT_TRUE(cache.Find(7, "html") == nullptr);
+  EXPECT_TRUE(cache.Find(8, "text") == nullptr);
+  const clipboard::PasteCacheStats stats = cache.stats();
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.misses, 2u);
+}
+
+// A new clipboard state replaces every result from the previous one.
+TEST(NewSequenceDropsEveryEntry) {
+  PasteCache<std::string> cache;
+  cache.Store(7, "text", "old", 3);
+  cache.Store(7, "html", "<b>old</b>", 10);
+  cache.Store(8, "text", "new", 3);
+  EXPECT_EQ(cache.stats().entries, 1u);
+  EXPECT_EQ(cache.stats().bytes, 3u);
+  EXPECT_TRUE(cache.Find(8, "html") == nullptr);
+  EXPECT_TRUE(cache.Find(7, "text") == nullptr);
+  Holds(&cache, 8, "text", "new");
+}
+
+// 0 means the sequence could not be read; nothing is stored or found.
+TEST(SequenceZeroIsNeverCached) {
+  PasteCache<std::string> cache;
+  auto value = cache.Store(0, "text", "x", 1);
+  EXPECT_TRUE(value != nullptr && *value == "x");
+  EXPECT_EQ(cache.stats().entries, 0u);
+  EXPECT_TRUE(cache.Find(0, "text") == nullptr);
+}
+
+TEST(OversizedResultsAreReturnedButNotKept) {
+  PasteCache<std::string> cache(10);
+  cache.Store(1, "small", "s", 4);
+  auto value = cache.Store(1, "large", "l", 11);
+  EXPECT_TRUE(value != nullptr && *value == "l");
+  EXPECT_TRUE(cache.Find(1, "large") == nullptr);
+  Holds(&cache, 1, "small", "s");
+}
+
+TEST(StaysWithinTheByteBudget) {
+  PasteCache<std::string> cache(10);
+  cache.Store(1, "a", "a", 4);
+  cache.Store(1, "b", "b", 4);
+  EXPECT_EQ(cache.stats().bytes, 8u);
+  // Something has to go for the new entry, which is always kept
+  cache.Store(1, "c", "c", 4);
+  EXPECT_TRUE(cache.stats().bytes <= 10u);
+  EXPECT_EQ(cache.stats().entries, 2u);
+  Holds(&cache, 1, "c", "c");
+  // An entry the size of the whole budget displaces all the others
+  cache.Store(1, "d", "d", 10);
+  EXPECT_EQ(cache.stats().entries, 1u);
+  EXPECT_EQ(cache.stats().bytes, 10u);
+  Holds(&cache, 1, "d", "d");
+}
+
+TEST(StoringAKeyAgainReplacesItsSize) {
+  PasteCache<std::string> cache(10);
+  cache.Store(1, "a", "first", 6);
+  cache.Store(1, "a", "second", 9);
+  EXPECT_EQ(cache.stats().entries, 1u);
+  EXPECT_EQ(cache.stats().bytes, 9u);
+  Holds(&cache, 1, "a", "second");
+}
+
+TEST(FindIfCachedDoesNotCountMisses) {
+  PasteCache<std::string> cache;
+  cache.Store(1, "a", "a", 1);
+  EXPECT_TRUE(cache.FindIfCached(1, "b") == nullptr);
+  EXPECT_TRUE(cache.FindIfCached(1, "a") != nullptr);
+  const clipboard::PasteCacheStats stats = cache.stats();
+  EXPECT_EQ(stats.misses, 0u);
+  EXPECT_EQ(stats.hits, 1u);
+}
+
+// Results already handed out outlive the entry they came from.
+TEST(ClearKeepsReturnedResultsAlive) {
+  PasteCache<std::string> cache;
+  cache.Store(1, "a", "kept", 4);
+  auto value = cache.Find(1, "a");
+  cache.Clear();
+  EXPECT_TRUE(cache.Find(1, "a") == nullptr);
+  EXPECT_EQ(cache.stats().bytes, 0u);
+  EXPECT_TRUE(value != nullptr && *value == "kept");
+}
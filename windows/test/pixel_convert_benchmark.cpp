@@ -0,0 +1,82 @@
+// Times the pixel row kernels on a 4K frame, the size SetClipboardImage
+// sees for a full-screen capture, for each conversion copyImage performs.
+
+#include <cstdio>
+#include <vector>
+
+#include "benchmark_util.h"
+#include "pixel_convert.h"
+#include "test_util.h"
+#include "thread_pool.h"
+
+using clipboard::PixelConvertOptions;
+using clipboard::PixelKernel;
+
+int main() {
+  const int width = 3840;
+  const int height = 2160;
+  const size_t row_bytes = static_cast<size_t>(width) * 4;
+  const double bytes = static_cast<double>(row_bytes) * height;
+  const std::vector<uint8_t> src =
+      clipboard_test::RandomBytes(row_bytes * height, 1);
+  std::vector<uint8_t> dst(src.size());
+
+  struct Case {
+    const char* name;
+    bool swap;
+    bool opaque;
+    bool premultiply;
+  };
+  const Case cases[] = {
+      {"swap", true, false, false},
+      {"force opaque", false, true, false},
+      {"swap + premultiply", true, false, true},
+  };
+  const struct {
+    const char* name;
+    PixelKernel kernel;
+  } kernels[] = {
+      {"scalar", PixelKernel::kScalar},
+      {"sse2", PixelKernel::kSse2},
+      {"avx2", PixelKernel::kAvx2},
+  };
+
+  std::printf("%dx%d BGRA, best of 10\n", width, height);
+  for (const auto& test_case : cases) {
+    PixelConvertOptions options;
+    options.swap_red_blue = test_case.swap;
+    options.force_opaque = test_case.opaque;
+    options.premultiply_alpha = test_case.premultiply;
+    std::printf("\n%s\n", test_case.name);
+    double scalar_ms = 0;
+    for (const auto& kernel : kernels) {
+      if (!clipboard::IsPixelKernelSupported(kernel.kernel)) {
+        std::printf("%-28s not supported\n", kernel.name);
+        continue;
+      }
+      const double ms = clipboard_test::BestMillis(10, [&] {
+        for (int y = 0; y < height; y++) {
+          const size_t offset = y * row_bytes;
+          clipboard::ConvertPixelRowWith(kernel.kernel, src.data() + offset,
+                                         dst.data() + offset, width, options);
+        }
+      });
+      if (kernel.kernel == PixelKernel::kScalar) {
+        scalar_ms = ms;
+      }
+      clipboard_test::PrintResult(kernel.name, ms, bytes, scalar_ms);
+    }
+
+    clipboard::ThreadPool pool(clipboard::ThreadPool::DefaultWorkerCount());
+    options.thread_pool = &pool;
+    const double ms = clipboard_test::BestMillis(10, [&] {
+      clipboard::ConvertPixelRows(src.data(), row_bytes, dst.data(), row_bytes,
+                                  width, height, options);
+    });
+    char name[64];
+    std::snprintf(name, sizeof(name), "rows, %zu threads",
+                  pool.worker_count() + 1);
+    clipboard_test::PrintResult(name, ms, bytes, scalar_ms);
+  }
+  return 0;
+}
@@ -0,0 +1,178 @@
+#include "pixel_convert.h"
+
+#include <cstring>
+#include <vector>
+
+#include "test_util.h"
+#include "thread_pool.h"
+
+using clipboard::ConvertPixelRow;
+using clipboard::ConvertPixelRows;
+using clipboard::ConvertPixelRowScalar;
+using clipboard::ConvertPixelRowWith;
+using clipboard::IsPixelKernelSupported;
+using clipboard::PixelConvertOptions;
+using clipboard::PixelKernel;
+
+namespace {
+
+const PixelKernel kVectorKernels[] = {PixelKernel::kSse2, PixelKernel::kAvx2};
+
+// All eight combinations of the conversion flags.
+std::vector<PixelConvertOptions> AllOptions() {
+  std::vector<PixelConvertOptions> all;
+  for (int flags = 0; flags < 8; flags++) {
+    PixelConvertOptions options;
+    options.swap_red_blue = (flags & 1) != 0;
+    options.force_opaque = (flags & 2) != 0;
+    options.premultiply_alpha = (flags & 4) != 0;
+    all.push_back(options);
+  }
+  return all;
+}
+
+// Random pixels with alpha 0 and 255 mixed in, which the premultiply path
+// treats specially.
+std::vector<uint8_t> TestPixels(size_t width, uint32_t seed) {
+  std::vector<uint8_t> pixels = clipboard_test::RandomBytes(width * 4, seed);
+  for (size_t x = 0; x < width; x += 3) {
+    pixels[x * 4 + 3] = (x % 2) ? 0 : 255;
+  }
+  return pixels;
+}
+
+}  // namespace
+
+TEST(ScalarPremultiplyRoundsExactly) {
+  PixelConvertOptions options;
+  options.premultiply_alpha = true;
+  for (uint32_t alpha = 0; alpha < 256; alpha++) {
+    for (uint32_t value = 0; value < 256; value++) {
+      const uint8_t src[4] = {static_cast<uint8_t>(value), 0, 0,
+                              static_cast<uint8_t>(alpha)};
+      uint8_t dst[4];
+      ConvertPixelRowScalar(src, dst, 1, options);
+      const uint32_t expected = (value * alpha * 2 + 255) / 510;
+      if (!EXPECT_EQ(dst[0], expected) || !EXPECT_EQ(dst[3], alpha)) {
+        return;
+      }
+    }
+  }
+}
+
+TEST(ScalarSwapsAndForcesOpaque) {
+  PixelConvertOptions options;
+  options.swap_red_blue = true;
+  options.force_opaque = true;
+  const uint8_t src[4] = {1, 2, 3, 4};
+  uint8_t dst[4];
+  ConvertPixelRowScalar(src, dst, 1, options);
+  EXPECT_EQ(dst[0], 3);
+  EXPECT_EQ(dst[1], 2);
+  EXPECT_EQ(dst[2], 1);
+  EXPECT_EQ(dst[3], 255);
+}
+
+// Every width up to a few vectors covers every tail length of both
+// kernels; the larger odd widths cover long rows ending mid-vector.
+TEST(VectorKernelsMatchScalar) {
+  std::vector<size_t> widths;
+  for (size_t width = 0; width <= 40; width++) {
+    widths.push_back(width);
+  }
+  for (size_t width : {255, 1023, 1025, 4097}) {
+    widths.push_back(width);
+  }
+  for (PixelKernel kernel : kVectorKernels) {
+    if (!IsPixelKernelSupported(kernel)) {
+      std::printf("  kernel %d not supported here, skipped\n",
+                  static_cast<int>(kernel));
+      continue;
+    }
+    for (const auto& options : AllOptions()) {
+      for (size_t width : widths) {
+        const std::vector<uint8_t> src =
+            TestPixels(width, static_cast<uint32_t>(width) + 1);
+        std::vector<uint8_t> expected(width * 4);
+        std::vector<uint8_t> actual(width * 4);
+        ConvertPixelRowScalar(src.data(), expected.data(), width, options);
+        ConvertPixelRowWith(kernel, src.data(), actual.data(), width, options);
+        if (!EXPECT_TRUE(actual == expected)) {
+          std::fprintf(stderr, "  kernel %d, width %zu, flags %d%d%d\n",
+                       static_cast<int>(kernel), width, options.swap_red_blue,
+                       options.force_opaque, options.premultiply_alpha);
+          return;
+        }
+      }
+    }
+  }
+}
+
+TEST(VectorKernelsHandleUnalignedBuffers) {
+  const size_t width = 37;
+  PixelConvertOptions options;
+  options.swap_red_blue = true;
+  options.premultiply_alpha = true;
+  const std::vector<uint8_t> pixels = TestPixels(width, 7);
+  std::vector<uint8_t> expected(width * 4);
+  ConvertPixelRowScalar(pixels.data(), expected.data(), width, options);
+  for (PixelKernel kernel : kVectorKernels) {
+    if (!IsPixelKernelSupported(kernel)) {
+      continue;
+    }
+    for (size_t offset = 1; offset < 4; offset++) {
+      std::vector<uint8_t> src(width * 4 + offset);
+      std::vector<uint8_t> dst(width * 4 + offset);
+      memcpy(src.data() + offset, pixels.data(), pixels.size());
+      ConvertPixelRowWith(kernel, src.data() + offset, dst.data() + offset,
+                          width, options);
+      EXPECT_TRUE(memcmp(dst.data() + offset, expected.data(),
+                         expected.size()) == 0);
+    }
+  }
+}
+
+TEST(ConvertsInPlace) {
+  const size_t width = 29;
+  for (const auto& options : AllOptions()) {
+    std::vector<uint8_t> pixels = TestPixels(width, 11);
+    std::vector<uint8_t> expected(width * 4);
+    ConvertPixelRowScalar(pixels.data(), expected.data(), width, options);
+    ConvertPixelRow(pixels.data(), pixels.data(), width, options);
+    EXPECT_TRUE(pixels == expected);
+  }
+}
+
+TEST(NegativeStrideFlipsRows) {
+  const int width = 5;
+  const int height = 4;
+  const ptrdiff_t stride = width * 4;
+  const std::vector<uint8_t> src =
+      TestPixels(static_cast<size_t>(width) * height, 3);
+  std::vector<uint8_t> dst(src.size());
+  ConvertPixelRows(src.data() + stride * (height - 1), -stride, dst.data(),
+                   stride, width, height);
+  for (int y = 0; y < height; y++) {
+    EXPECT_TRUE(memcmp(dst.data() + stride * y,
+                       src.data() + stride * (height - 1 - y), stride) == 0);
+  }
+}
+
+TEST(ThreadPoolBandsMatchSingleThread) {
+  clipboard::ThreadPool pool(3);
+  const int width = 333;
+  const int height = 257;
+  const std::vector<uint8_t> src =
+      TestPixels(static_cast<size_t>(width) * height, 5);
+  PixelConvertOptions options;
+  options.premultiply_alpha = true;
+  std::vector<uint8_t> expected(src.size());
+  ConvertPixelRows(src.data(), width * 4, expected.data(), width * 4, width,
+                   height, options);
+  options.thread_pool = &pool;
+  options.parallel_pixel_threshold = 1;
+  std::vector<uint8_t> actual(src.size());
+  ConvertPixelRows(src.data(), width * 4, actual.data(), width * 4, width,
+                   height, options);
+  EXPECT_TRUE(actual == expected);
+}
@@ -0,0 +1,152 @@
+#ifndef CLIPBOARD_PNG_DECODE_H_
+#define CLIPBOARD_PNG_DECODE_H_
+
+#include <zlib.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "dib_image.h"
+
+namespace clipboard_test {
+
+// Reference PNG reader for checking the encoder: chunk CRCs are verified
+// and IDAT is inflated by zlib, not by anything in the plugin. Handles the
+// output the encoder produces (8-bit RGB or RGBA, not interlaced).
+struct DecodedPng {
+  int width = 0;
+  int height = 0;
+  int channels = 0;
+  // Inflated IDAT: each row's filter type followed by its filtered bytes.
+  std::vector<uint8_t> scanlines;
+  // Unfiltered, tightly packed R, G, B[, A] rows, top row first.
+  std::vector<uint8_t> pixels;
+};
+
+inline uint32_t ReadBigEndian32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 |
+         static_cast<uint32_t>(p[2]) << 8 | p[3];
+}
+
+inline uint8_t Paeth(int a, int b, int c) {
+  const int p = a + b - c;
+  const int pa = std::abs(p - a);
+  const int pb = std::abs(p - b);
+  const int pc = std::abs(p - c);
+  if (pa <= pb && pa <= pc) {
+    return static_cast<uint8_t>(a);
+  }
+  return static_cast<uint8_t>(pb <= pc ? b : c);
+}
+
+inline bool Unfilter(DecodedPng* png) {
+  const size_t bpp = static_cast<size_t>(png->channels);
+  const size_t row_size = static_cast<size_t>(png->width) * bpp;
+  png->pixels.assign(row_size * static_cast<size_t>(png->height), 0);
+  const std::vector<uint8_t> zero_row(row_size, 0);
+  for (size_t y = 0; y < static_cast<size_t>(png->height); y++) {
+    const uint8_t* in = png->scanlines.data() + y * (row_size + 1);
+    uint8_t* out = png->pixels.data() + y * row_size;
+    const uint8_t* prior = y ? out - row_size : zero_row.data();
+    const uint8_t filter = *in++;
+    for (size_t x = 0; x < row_size; x++) {
+      const int left = x >= bpp ? out[x - bpp] : 0;
+      const int up = prior[x];
+      const int up_left = x >= bpp ? prior[x - bpp] : 0;
+      int predictor;
+      switch (filter) {
+        case 0: predictor = 0; break;
+        case 1: predictor = left; break;
+        case 2: predictor = up; break;
+        case 3: predictor = (left + up) / 2; break;
+        case 4: predictor = Paeth(left, up, up_left); break;
+        default: return false;
+      }
+      out[x] = static_cast<uint8_t>(in[x] + predictor);
+    }
+  }
+  return true;
+}
+
+inline bool DecodePng(const std::vector<uint8_t>& data, DecodedPng* png) {
+  static const uint8_t kSignature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+  if (data.size() < 8 || memcmp(data.data(), kSignature, 8) != 0) {
+    return false;
+  }
+  std::vector<uint8_t> idat;
+  bool has_header = false;
+  bool has_end = false;
+  size_t pos = 8;
+  while (!has_end) {
+    if (data.size() - pos < 12) {
+      return false;
+    }
+    const uint32_t length = ReadBigEndian32(&data[pos]);
+    if (length > data.size() - pos - 12) {
+      return false;
+    }
+    const uint8_t* type = &data[pos + 4];
+    const uint8_t* body = &data[pos + 8];
+    const uLong crc = crc32(crc32(0, nullptr, 0), type, length + 4);
+    if (ReadBigEndian32(body + length) != crc) {
+      return false;
+    }
+    if (memcmp(type, "IHDR", 4) == 0) {
+      if (length != 13 || body[8] != 8 || body[10] != 0 || body[11] != 0 ||
+          body[12] != 0 || (body[9] != 2 && body[9] != 6)) {
+        return false;
+      }
+      png->width = static_cast<int>(ReadBigEndian32(body));
+      png->height = static_cast<int>(ReadBigEndian32(body + 4));
+      png->channels = body[9] == 6 ? 4 : 3;
+      has_header = true;
+    } else if (memcmp(type, "IDAT", 4) == 0) {
+      idat.insert(idat.end(), body, body + length);
+    } else if (memcmp(type, "IEND", 4) == 0) {
+      has_end = true;
+    }
+    pos += 12 + length;
+  }
+  if (!has_header || pos != data.size()) {
+    return false;
+  }
+  const size_t expected =
+      (static_cast<size_t>(png->width) * png->channels + 1) *
+      static_cast<size_t>(png->height);
+  png->scanlines.resize(expected);
+  uLongf size = static_cast<uLongf>(expected);
+  if (uncompress(png->scanlines.data(), &size, idat.data(),
+                 static_cast<uLong>(idat.size())) != Z_OK ||
+      size != expected) {
+    return false;
+  }
+  return Unfilter(png);
+}
+
+// What a PNG of |image| must decode to: R, G, B and, for kBgra, straight
+// alpha, top row first whatever the stride's sign.
+inline std::vector<uint8_t> ExpectedPngPixels(
+    const clipboard::DibImage& image) {
+  const bool alpha = image.format == clipboard::DibPixelFormat::kBgra;
+  const size_t src_bpp = clipboard::DibBytesPerPixel(image.format);
+  std::vector<uint8_t> pixels;
+  const uint8_t* row = image.pixels;
+  for (int y = 0; y < image.height; y++, row += image.stride) {
+    for (int x = 0; x < image.width; x++) {
+      const uint8_t* pixel = row + x * src_bpp;
+      pixels.push_back(pixel[2]);
+      pixels.push_back(pixel[1]);
+      pixels.push_back(pixel[0]);
+      if (alpha) {
+        pixels.push_back(pixel[3]);
+      }
+    }
+  }
+  return pixels;
+}
+
+}  // namespace clipboard_test
+
+#endif  // CLIPBOARD_PNG_DECODE_H_
@@ -0,0 +1,211 @@
+// Times pasteImage's PNG encode of screen captures: the built-in encoder on
+// one thread and on the pool, and on Windows the GDI+ Bitmap::Save path it
+// replaced, then the built-in encoder's scaling from 1 to N threads. N is
+// the hardware thread count unless given as the first argument. Sizes are
+// printed too, since a faster encoder that produced much larger files would
+// only move the cost to the Dart side.
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "benchmark_util.h"
+#include "dib_image.h"
+#include "png_encoder.h"
+#include "test_util.h"
+#include "thread_pool.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <objidl.h>
+
+#include <algorithm>
+// GDI+ requires min/max, which NOMINMAX disables
+using std::max;
+using std::min;
+#pragma warning(push)
+#pragma warning(disable : 4458)
+#include <gdiplus.h>
+#pragma warning(pop)
+#endif
+
+using clipboard::DibImage;
+using clipboard::DibPixelFormat;
+using clipboard::PngEncodeOptions;
+
+namespace {
+
+#ifdef _WIN32
+class GdiplusPngEncoder {
+ public:
+  GdiplusPngEncoder() {
+    Gdiplus::GdiplusStartupInput input;
+    if (Gdiplus::GdiplusStartup(&token_, &input, nullptr) != Gdiplus::Ok) {
+      token_ = 0;
+      return;
+    }
+    UINT count = 0;
+    UINT size = 0;
+    Gdiplus::GetImageEncodersSize(&count, &size);
+    std::vector<BYTE> buffer(size);
+    auto* codecs = reinterpret_cast<Gdiplus::ImageCodecInfo*>(buffer.data());
+    if (size && Gdiplus::GetImageEncoders(count, size, codecs) == Gdiplus::Ok) {
+      for (UINT i = 0; i < count; i++) {
+        if (wcscmp(codecs[i].MimeType, L"image/png") == 0) {
+          png_clsid_ = codecs[i].Clsid;
+          has_png_ = true;
+        }
+      }
+    }
+  }
+
+  ~GdiplusPngEncoder() {
+    if (token_ != 0) {
+      Gdiplus::GdiplusShutdown(token_);
+    }
+  }
+
+  GdiplusPngEncoder(const GdiplusPngEncoder&) = delete;
+  GdiplusPngEncoder& operator=(const GdiplusPngEncoder&) = delete;
+
+  bool ok() const { return token_ != 0 && has_png_; }
+
+  // What pasteImage used to do: wrap the pixels in a Bitmap, save it to an
+  // HGLOBAL stream and read the stream back into a vector.
+  bool Encode(const DibImage& image, std::vector<uint8_t>* png) {
+    Gdiplus::Bitmap bitmap(image.width, image.height,
+                           static_cast<INT>(image.stride),
+                           image.format == DibPixelFormat::kBgra
+                               ? PixelFormat32bppARGB
+                               : PixelFormat32bppRGB,
+                           const_cast<BYTE*>(image.pixels));
+    IStream* stream = nullptr;
+    if (CreateStreamOnHGlobal(nullptr, TRUE, &stream) != S_OK) {
+      return false;
+    }
+    bool saved = bitmap.Save(stream, &png_clsid_, nullptr) == Gdiplus::Ok;
+    STATSTG stat;
+    if (saved && stream->Stat(&stat, STATFLAG_NONAME) == S_OK) {
+      LARGE_INTEGER zero = {};
+      stream->Seek(zero, STREAM_SEEK_SET, nullptr);
+      ULONG read = 0;
+      png->resize(stat.cbSize.LowPart);
+      saved = SUCCEEDED(stream->Read(png->data(), stat.cbSize.LowPart, &read));
+      png->resize(read);
+    }
+    stream->Release();
+    return saved;
+  }
+
+ private:
+  ULONG_PTR token_ = 0;
+  CLSID png_clsid_ = {};
+  bool has_png_ = false;
+};
+#endif
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int sizes[][2] = {{1920, 1080}, {3840, 2160}};
+  const size_t max_threads =
+      argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 0;
+  clipboard::ThreadPool pool(max_threads > 0
+                                 ? max_threads - 1
+                                 : clipboard::ThreadPool::DefaultWorkerCount());
+
+#ifdef _WIN32
+  GdiplusPngEncoder gdiplus;
+#endif
+
+  for (const auto& size : sizes) {
+    const int width = size[0];
+    const int height = size[1];
+    const size_t stride = static_cast<size_t>(width) * 4;
+    const double bytes = static_cast<double>(stride) * height;
+    const std::vector<uint8_t> pixels =
+        clipboard_test::ScreenshotPixels(width, height, 4, stride, 1);
+    // Bottom-up, as CF_DIB captures are
+    DibImage image;
+    image.width = width;
+    image.height = height;
+    image.format = DibPixelFormat::kBgrx;
+    image.stride = -static_cast<ptrdiff_t>(stride);
+    image.pixels = pixels.data() + stride * (height - 1);
+
+    std::printf("\n%dx%d opaque capture, best of 5\n", width, height);
+    std::vector<uint8_t> png;
+    double baseline_ms = 0;
+
+#ifdef _WIN32
+    if (gdiplus.ok()) {
+      baseline_ms = clipboard_test::BestMillis(5, [&] {
+        png.clear();
+        gdiplus.Encode(image, &png);
+      });
+      clipboard_test::PrintResult("gdi+", baseline_ms, bytes, baseline_ms);
+      std::printf("%-28s %9zu bytes\n", "", png.size());
+    }
+#endif
+
+    PngEncodeOptions single;
+    const double single_ms = clipboard_test::BestMillis(5, [&] {
+      png.clear();
+      clipboard::EncodePng(image, &png, single);
+    });
+    if (baseline_ms == 0) {
+      baseline_ms = single_ms;
+    }
+    clipboard_test::PrintResult("built-in, 1 thread", single_ms, bytes,
+                                baseline_ms);
+    std::printf("%-28s %9zu bytes\n", "", png.size());
+
+    PngEncodeOptions pooled;
+    pooled.thread_pool = &pool;
+    const double pooled_ms = clipboard_test::BestMillis(5, [&] {
+      png.clear();
+      clipboard::EncodePng(image, &png, pooled);
+    });
+    clipboard_test::PrintResult("built-in, thread pool", pooled_ms, bytes,
+                                baseline_ms);
+    std::printf("%-28s %9zu bytes\n", "", png.size());
+  }
+
+  // Scaling of the 4K encode with the thread count, the caller included.
+  // Each extra deflate piece ends with a sync flush and restarts its
+  // Huffman codes, which the size column shows.
+  const int width = 3840;
+  const int height = 2160;
+  const size_t stride = static_cast<size_t>(width) * 4;
+  const double bytes = static_cast<double>(stride) * height;
+  const std::vector<uint8_t> pixels =
+      clipboard_test::ScreenshotPixels(width, height, 4, stride, 1);
+  DibImage image;
+  image.width = width;
+  image.height = height;
+  image.format = DibPixelFormat::kBgrx;
+  image.stride = static_cast<ptrdiff_t>(stride);
+  image.pixels = pixels.data();
+
+  std::printf("\n%dx%d by thread count, best of 5\n", width, height);
+  std::vector<uint8_t> png;
+  double one_thread_ms = 0;
+  for (size_t threads = 1; threads <= pool.worker_count() + 1; threads++) {
+    PngEncodeOptions options;
+    options.thread_pool = &pool;
+    options.max_threads = threads;
+    const double ms = clipboard_test::BestMillis(5, [&] {
+      png.clear();
+      clipboard::EncodePng(image, &png, options);
+    });
+    if (threads == 1) {
+      one_thread_ms = ms;
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "%zu thread%s", threads,
+                  threads == 1 ? "" : "s");
+    clipboard_test::PrintResult(name, ms, bytes, one_thread_ms);
+    std::printf("%-28s %9zu bytes\n", "", png.size());
+  }
+  return 0;
+}
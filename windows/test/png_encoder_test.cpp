@@ -0,0 +1,240 @@
+#include "png_encoder.h"
+
+#include <cstdio>
+#include <vector>
+
+#include "dib_image.h"
+#include "png_decode.h"
+#include "test_util.h"
+#include "thread_pool.h"
+
+using clipboard::DibImage;
+using clipboard::DibPixelFormat;
+using clipboard::EncodePng;
+using clipboard::PngEncodeOptions;
+using clipboard_test::DecodedPng;
+using clipboard_test::DecodePng;
+using clipboard_test::ExpectedPngPixels;
+
+namespace {
+
+const DibPixelFormat kFormats[] = {DibPixelFormat::kBgra,
+                                   DibPixelFormat::kBgrx,
+                                   DibPixelFormat::kBgr};
+
+// Rows padded to 4 bytes, as in a DIB.
+size_t DibStride(int width, DibPixelFormat format) {
+  return (static_cast<size_t>(width) * DibBytesPerPixel(format) + 3) / 4 * 4;
+}
+
+DibImage View(const std::vector<uint8_t>& pixels, int width, int height,
+              DibPixelFormat format, bool bottom_up) {
+  const ptrdiff_t stride = static_cast<ptrdiff_t>(DibStride(width, format));
+  DibImage image;
+  image.width = width;
+  image.height = height;
+  image.format = format;
+  image.pixels = bottom_up ? pixels.data() + stride * (height - 1)
+                           : pixels.data();
+  image.stride = bottom_up ? -stride : stride;
+  return image;
+}
+
+// Encodes |image| and checks the reference decoder gets its pixels back.
+bool RoundTrips(const DibImage& image) {
+  std::vector<uint8_t> png;
+  if (!EXPECT_TRUE(EncodePng(image, &png))) {
+    return false;
+  }
+  DecodedPng decoded;
+  if (!EXPECT_TRUE(DecodePng(png, &decoded))) {
+    return false;
+  }
+  const int channels = image.format == DibPixelFormat::kBgra ? 4 : 3;
+  return EXPECT_EQ(decoded.width, image.width) &&
+         EXPECT_EQ(decoded.height, image.height) &&
+         EXPECT_EQ(decoded.channels, channels) &&
+         EXPECT_TRUE(decoded.pixels == ExpectedPngPixels(image));
+}
+
+void PutU16(std::vector<uint8_t>* data, size_t offset, uint16_t value) {
+  (*data)[offset] = static_cast<uint8_t>(value);
+  (*data)[offset + 1] = static_cast<uint8_t>(value >> 8);
+}
+
+void PutU32(std::vector<uint8_t>* data, size_t offset, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    (*data)[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+// A packed DIB with a |header_size| header, bottom-up unless |height| is
+// negative. V5 headers declare the BGRA masks, alpha included.
+std::vector<uint8_t> PackedDib(uint32_t header_size, int width, int height,
+                               uint16_t bit_count,
+                               const std::vector<uint8_t>& pixels) {
+  std::vector<uint8_t> dib(header_size);
+  PutU32(&dib, 0, header_size);
+  PutU32(&dib, 4, static_cast<uint32_t>(width));
+  PutU32(&dib, 8, static_cast<uint32_t>(height));
+  PutU16(&dib, 12, 1);
+  PutU16(&dib, 14, bit_count);
+  if (header_size >= 56) {
+    PutU32(&dib, 16, 3);  // BI_BITFIELDS
+    PutU32(&dib, 40, 0x00FF0000u);
+    PutU32(&dib, 44, 0x0000FF00u);
+    PutU32(&dib, 48, 0x000000FFu);
+    PutU32(&dib, 52, 0xFF000000u);
+  }
+  dib.insert(dib.end(), pixels.begin(), pixels.end());
+  return dib;
+}
+
+}  // namespace
+
+TEST(EncodesEveryFormatTopDownAndBottomUp) {
+  const int sizes[][2] = {{1, 1}, {2, 3}, {37, 23}, {300, 17}, {5, 200}};
+  for (DibPixelFormat format : kFormats) {
+    for (const auto& size : sizes) {
+      const int width = size[0];
+      const int height = size[1];
+      const std::vector<uint8_t> pixels = clipboard_test::ScreenshotPixels(
+          width, height, DibBytesPerPixel(format), DibStride(width, format),
+          static_cast<uint32_t>(width * 31 + height));
+      for (bool bottom_up : {false, true}) {
+        if (!RoundTrips(View(pixels, width, height, format, bottom_up))) {
+          std::fprintf(stderr, "  format %d, %dx%d, bottom-up %d\n",
+                       static_cast<int>(format), width, height, bottom_up);
+          return;
+        }
+      }
+    }
+  }
+}
+
+// Noise cannot be compressed, so deflate falls back to stored blocks.
+TEST(EncodesIncompressibleImage) {
+  const int width = 257;
+  const int height = 129;
+  for (DibPixelFormat format : kFormats) {
+    const std::vector<uint8_t> pixels = clipboard_test::RandomBytes(
+        DibStride(width, format) * height, 77);
+    RoundTrips(View(pixels, width, height, format, true));
+  }
+}
+
+// Long runs produce matches at the maximum length and distance.
+TEST(EncodesFlatImageLargerThanWindow) {
+  const int width = 1000;
+  const int height = 300;
+  const DibPixelFormat format = DibPixelFormat::kBgrx;
+  std::vector<uint8_t> pixels(DibStride(width, format) * height, 0xC8);
+  RoundTrips(View(pixels, width, height, format, false));
+}
+
+TEST(RejectsEmptyImage) {
+  DibImage image;
+  std::vector<uint8_t> png;
+  EXPECT_FALSE(EncodePng(image, &png));
+  EXPECT_TRUE(png.empty());
+}
+
+// The clipboard path: ParseDib of a bottom-up DIB, then EncodePng. The
+// expected rows are reversed by hand rather than through a DibImage.
+TEST(EncodesParsedBottomUpDibs) {
+  const int width = 13;
+  const int height = 7;
+  struct Case {
+    uint32_t header_size;
+    uint16_t bit_count;
+    int channels;
+  };
+  // 24-bit BI_RGB, 32-bit BI_RGB (alpha undefined) and 32-bit V5 BGRA
+  const Case cases[] = {{40, 24, 3}, {40, 32, 3}, {124, 32, 4}};
+  for (const auto& test_case : cases) {
+    const size_t bpp = test_case.bit_count / 8;
+    const size_t stride = (width * bpp + 3) / 4 * 4;
+    std::vector<uint8_t> rows =
+        clipboard_test::RandomBytes(stride * height, test_case.bit_count);
+    std::vector<uint8_t> expected;
+    for (int y = height - 1; y >= 0; y--) {
+      for (int x = 0; x < width; x++) {
+        const uint8_t* pixel = &rows[y * stride + x * bpp];
+        expected.push_back(pixel[2]);
+        expected.push_back(pixel[1]);
+        expected.push_back(pixel[0]);
+        if (test_case.channels == 4) {
+          expected.push_back(pixel[3]);
+        }
+      }
+    }
+    const std::vector<uint8_t> dib = PackedDib(
+        test_case.header_size, width, height, test_case.bit_count, rows);
+    DibImage image;
+    if (!EXPECT_TRUE(clipboard::ParseDib(dib.data(), dib.size(), &image))) {
+      continue;
+    }
+    std::vector<uint8_t> png;
+    DecodedPng decoded;
+    EXPECT_TRUE(EncodePng(image, &png));
+    if (EXPECT_TRUE(DecodePng(png, &decoded))) {
+      EXPECT_EQ(decoded.channels, test_case.channels);
+      EXPECT_TRUE(decoded.pixels == expected);
+    }
+  }
+}
+
+// Producers that leave alpha zeroed must not paste as invisible.
+TEST(EncodesZeroAlphaBgraAsOpaque) {
+  const int width = 4;
+  const int height = 2;
+  std::vector<uint8_t> rows(width * 4 * height, 0x40);
+  for (size_t i = 3; i < rows.size(); i += 4) {
+    rows[i] = 0;
+  }
+  const std::vector<uint8_t> dib = PackedDib(124, width, height, 32, rows);
+  DibImage image;
+  std::vector<uint8_t> png;
+  DecodedPng decoded;
+  EXPECT_TRUE(clipboard::ParseDib(dib.data(), dib.size(), &image));
+  EXPECT_TRUE(EncodePng(image, &png));
+  EXPECT_TRUE(DecodePng(png, &decoded));
+  EXPECT_EQ(decoded.channels, 3);
+}
+
+// Row bands and deflate pieces follow the thread count. The scanlines must
+// not depend on it at all; the compressed stream may, since each piece
+// ends with a sync flush, but it must decode to the same rows.
+TEST(OutputIsTheSameForEveryThreadCount) {
+  clipboard::ThreadPool pool(3);
+  const int width = 700;
+  const int height = 1001;
+  for (DibPixelFormat format : kFormats) {
+    const std::vector<uint8_t> pixels = clipboard_test::ScreenshotPixels(
+        width, height, DibBytesPerPixel(format), DibStride(width, format), 3);
+    const DibImage image = View(pixels, width, height, format, true);
+
+    clipboard::PngScanlines serial;
+    EXPECT_TRUE(clipboard::FilterPngRows(image, &serial));
+    for (size_t threads = 1; threads <= 8; threads++) {
+      PngEncodeOptions options;
+      options.thread_pool = &pool;
+      options.max_threads = threads;
+      options.parallel_pixel_threshold = 0;
+
+      clipboard::PngScanlines scanlines;
+      EXPECT_TRUE(clipboard::FilterPngRows(image, &scanlines, options));
+      EXPECT_TRUE(scanlines.data == serial.data);
+
+      std::vector<uint8_t> png;
+      DecodedPng decoded;
+      EXPECT_TRUE(EncodePng(image, &png, options));
+      if (!EXPECT_TRUE(DecodePng(png, &decoded)) ||
+          !EXPECT_TRUE(decoded.scanlines == serial.data) ||
+          !EXPECT_TRUE(decoded.pixels == ExpectedPngPixels(image))) {
+        std::fprintf(stderr, "  format %d, %zu threads\n",
+                     static_cast<int>(format), threads);
+      }
+    }
+  }
+}
@@ -0,0 +1,19 @@
+#include <cstdio>
+
+#include "test_util.h"
+
+int main() {
+  int failed_tests = 0;
+  for (const auto& test : clipboard_test::Registry()) {
+    const int failures_before = clipboard_test::FailureCount();
+    test.run();
+    const bool passed = clipboard_test::FailureCount() == failures_before;
+    std::printf("[%s] %s\n", passed ? "  OK  " : "FAILED", test.name);
+    if (!passed) {
+      failed_tests++;
+    }
+  }
+  std::printf("%zu tests, %d failed\n", clipboard_test::Registry().size(),
+              failed_tests);
+  return failed_tests == 0 ? 0 : 1;
+}
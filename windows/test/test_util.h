@@ -0,0 +1,97 @@
+#ifndef CLIPBOARD_TEST_UTIL_H_
+#define CLIPBOARD_TEST_UTIL_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace clipboard_test {
+
+// Minimal test registry, so the native tests need nothing beyond the
+// standard library. TEST functions register themselves before main runs;
+// test_main.cpp runs them all and fails if any EXPECT did.
+
+struct TestCase {
+  const char* name;
+  void (*run)();
+};
+
+inline std::vector<TestCase>& Registry() {
+  static std::vector<TestCase> tests;
+  return tests;
+}
+
+inline int& FailureCount() {
+  static int failures = 0;
+  return failures;
+}
+
+inline bool Register(const char* name, void (*run)()) {
+  Registry().push_back({name, run});
+  return true;
+}
+
+inline bool Check(bool passed, const char* file, int line,
+                  const char* expression) {
+  if (!passed) {
+    FailureCount()++;
+    std::fprintf(stderr, "%s:%d: expected %s\n", file, line, expression);
+  }
+  return passed;
+}
+
+// Deterministic pseudo-random bytes (xorshift32), so failures reproduce.
+inline std::vector<uint8_t> RandomBytes(size_t size, uint32_t seed) {
+  std::vector<uint8_t> bytes(size);
+  uint32_t state = seed ? seed : 1;
+  for (auto& byte : bytes) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    byte = static_cast<uint8_t>(state >> 24);
+  }
+  return bytes;
+}
+
+// Pixels that compress the way screen captures do: flat runs of a few
+// colors with noisy stretches in between. |bytes_per_pixel| is 3 or 4;
+// rows are |stride| bytes apart, the padding left zero.
+inline std::vector<uint8_t> ScreenshotPixels(int width, int height,
+                                             size_t bytes_per_pixel,
+                                             size_t stride, uint32_t seed) {
+  std::vector<uint8_t> pixels(stride * static_cast<size_t>(height));
+  const std::vector<uint8_t> noise = RandomBytes(pixels.size(), seed);
+  for (int y = 0; y < height; y++) {
+    uint8_t* row = pixels.data() + stride * static_cast<size_t>(y);
+    const uint8_t* row_noise = noise.data() + stride * static_cast<size_t>(y);
+    for (int x = 0; x < width; x++) {
+      uint8_t* pixel = row + bytes_per_pixel * static_cast<size_t>(x);
+      const bool noisy = ((x / 24) + (y / 16)) % 5 == 0;
+      for (size_t c = 0; c < bytes_per_pixel; c++) {
+        pixel[c] = noisy ? row_noise[x * bytes_per_pixel + c]
+                         : static_cast<uint8_t>((x / 64) * 40 + (y / 32) * 25 +
+                                                c * 60);
+      }
+    }
+  }
+  return pixels;
+}
+
+}  // namespace clipboard_test
+
+#define TEST(name)                                          \
+  static void name();                                       \
+  static const bool name##_registered =                     \
+      ::clipboard_test::Register(#name, name);              \
+  static void name()
+
+// Return whether the check passed, so a test can stop before indexing past
+// a buffer whose size was wrong.
+#define EXPECT_TRUE(condition) \
+  ::clipboard_test::Check((condition), __FILE__, __LINE__, #condition)
+#define EXPECT_FALSE(condition) \
+  ::clipboard_test::Check(!(condition), __FILE__, __LINE__, "!(" #condition ")")
+#define EXPECT_EQ(a, b) \
+  ::clipboard_test::Check((a) == (b), __FILE__, __LINE__, #a " == " #b)
+
+#endif  // CLIPBOARD_TEST_UTIL_H_
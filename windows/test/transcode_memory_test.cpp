@@ -0,0 +1,153 @@
+// Asserts the memory bound of large text copies and pastes: transcoding
+// needs no buffer besides its destination, whatever the payload size. The
+// plugin sizes the destination (the clipboard allocation on copy, the
+// result string on paste) with the *Length pass and converts straight into
+// it, so the heap is tracked here through a replaced global operator new.
+
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "test_util.h"
+#include "utf_transcode.h"
+
+namespace {
+
+size_t g_live_bytes = 0;
+size_t g_peak_bytes = 0;
+size_t g_allocations = 0;
+
+// Room in front of each block for its size, keeping the default alignment.
+constexpr size_t kHeaderSize = alignof(std::max_align_t);
+
+void* TrackedAlloc(size_t size) {
+  auto* block = static_cast<unsigned char*>(std::malloc(size + kHeaderSize));
+  if (!block) {
+    throw std::bad_alloc();
+  }
+  *reinterpret_cast<size_t*>(block) = size;
+  g_allocations++;
+  g_live_bytes += size;
+  if (g_live_bytes > g_peak_bytes) {
+    g_peak_bytes = g_live_bytes;
+  }
+  return block + kHeaderSize;
+}
+
+void TrackedFree(void* pointer) {
+  if (!pointer) {
+    return;
+  }
+  auto* block = static_cast<unsigned char*>(pointer) - kHeaderSize;
+  g_live_bytes -= *reinterpret_cast<size_t*>(block);
+  std::free(block);
+}
+
+// Heap use between construction and Stop(), relative to the live bytes at
+// the start.
+class HeapScope {
+ public:
+  HeapScope()
+      : base_bytes_(g_live_bytes), base_allocations_(g_allocations) {
+    g_peak_bytes = g_live_bytes;
+  }
+
+  void Stop() {
+    peak_extra_bytes_ = g_peak_bytes - base_bytes_;
+    allocations_ = g_allocations - base_allocations_;
+  }
+
+  size_t peak_extra_bytes() const { return peak_extra_bytes_; }
+  size_t allocations() const { return allocations_; }
+
+ private:
+  size_t base_bytes_;
+  size_t base_allocations_;
+  size_t peak_extra_bytes_ = 0;
+  size_t allocations_ = 0;
+};
+
+constexpr size_t kPayloadBytes = 64 * 1024 * 1024;
+
+// Log-like text: mostly ASCII lines with some accented and CJK words and
+// an emoji now and then, in every UTF-8 sequence length.
+std::string LargeUtf8(size_t size) {
+  const std::string line =
+      "2024-01-01 12:00:00 INFO r\xC3\xA9sum\xC3\xA9 \xE6\x97\xA5\xE6\x9C\xAC "
+      "\xF0\x9F\x98\x80 request handled in 12 ms\n";
+  std::string text;
+  text.reserve(size);
+  while (text.size() + line.size() <= size) {
+    text += line;
+  }
+  return text;
+}
+
+}  // namespace
+
+void* operator new(size_t size) { return TrackedAlloc(size); }
+void* operator new[](size_t size) { return TrackedAlloc(size); }
+void operator delete(void* pointer) noexcept { TrackedFree(pointer); }
+void operator delete[](void* pointer) noexcept { TrackedFree(pointer); }
+void operator delete(void* pointer, size_t) noexcept { TrackedFree(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { TrackedFree(pointer); }
+
+// copy: UTF-8 from Dart into the UTF-16 clipboard allocation.
+TEST(CopyTranscodesWithoutHeapMemory) {
+  const std::string text = LargeUtf8(kPayloadBytes);
+  // Stands in for the GlobalAlloc block, which is sized by the length pass
+  std::vector<char16_t> clipboard_memory(text.size() + 1);
+
+  HeapScope scope;
+  const size_t units = clipboard::Utf16LengthOfUtf8(text.data(), text.size());
+  const size_t written =
+      clipboard::Utf8ToUtf16(text.data(), text.size(), clipboard_memory.data());
+  scope.Stop();
+
+  EXPECT_EQ(written, units);
+  EXPECT_EQ(scope.allocations(), 0u);
+  EXPECT_EQ(scope.peak_extra_bytes(), 0u);
+}
+
+// paste: UTF-16 clipboard data into the UTF-8 result string. The result is
+// the only allocation, and it is the size of the output.
+TEST(PasteAllocatesOnlyTheResult) {
+  const std::string text = LargeUtf8(kPayloadBytes);
+  std::u16string clipboard_data(
+      clipboard::Utf16LengthOfUtf8(text.data(), text.size()), u'\0');
+  clipboard::Utf8ToUtf16(text.data(), text.size(), &clipboard_data[0]);
+
+  HeapScope scope;
+  std::string result;
+  result.resize(clipboard::Utf8LengthOfUtf16(clipboard_data.data(),
+                                             clipboard_data.size()));
+  clipboard::Utf16ToUtf8(clipboard_data.data(), clipboard_data.size(),
+                         &result[0]);
+  scope.Stop();
+
+  EXPECT_TRUE(result == text);
+  EXPECT_EQ(scope.allocations(), 1u);
+  // Beyond the text: the terminator and the library's capacity rounding
+  EXPECT_TRUE(scope.peak_extra_bytes() >= text.size());
+  EXPECT_TRUE(scope.peak_extra_bytes() <= text.size() + 64);
+}
+
+// Replacement characters change the output size; the length pass still
+// predicts it, so the bound holds for malformed input too.
+TEST(InvalidInputKeepsTheBound) {
+  std::string text = LargeUtf8(kPayloadBytes / 4);
+  for (size_t i = 7; i < text.size(); i += 101) {
+    text[i] = '\xFF';
+  }
+  std::vector<char16_t> clipboard_memory(text.size() + 1);
+
+  HeapScope scope;
+  const size_t units = clipboard::Utf16LengthOfUtf8(text.data(), text.size());
+  const size_t written =
+      clipboard::Utf8ToUtf16(text.data(), text.size(), clipboard_memory.data());
+  scope.Stop();
+
+  EXPECT_EQ(written, units);
+  EXPECT_EQ(scope.allocations(), 0u);
+}
@@ -0,0 +1,80 @@
+// Times the UTF-8 <-> UTF-16 converters copyText and pasteText use, from a
+// short snippet to a 100 MB paste, in both directions and against the
+// scalar converters. ASCII-only text is where the SIMD runs pay off; mixed
+// text cycles through 1-, 2-, 3- and 4-byte sequences, so every run is
+// short and the benchmark shows what the probe costs when it fails.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "benchmark_util.h"
+#include "utf_transcode.h"
+
+namespace {
+
+// |size| bytes of UTF-8 built by repeating |sample|, cut at a character
+// boundary.
+std::string Repeat(const std::string& sample, size_t size) {
+  std::string text;
+  text.reserve(size + sample.size());
+  while (text.size() + sample.size() <= size) {
+    text += sample;
+  }
+  return text.empty() ? sample : text;
+}
+
+void Run(const char* label, const std::string& utf8) {
+  const size_t units = clipboard::Utf16LengthOfUtf8(utf8.data(), utf8.size());
+  std::u16string utf16(units, u'\0');
+  std::string back(utf8.size(), '\0');
+  // Fewer runs for the large inputs; they are not noisy anyway
+  const int iterations = utf8.size() >= (8 << 20) ? 3 : 10;
+  const double bytes = static_cast<double>(utf8.size());
+
+  std::printf("\n%s, %zu bytes, best of %d\n", label, utf8.size(),
+              iterations);
+  const double scalar_widen_ms = clipboard_test::BestMillis(iterations, [&] {
+    clipboard::Utf8ToUtf16Scalar(utf8.data(), utf8.size(), &utf16[0]);
+  });
+  clipboard_test::PrintResult("utf-8 -> utf-16 scalar", scalar_widen_ms,
+                              bytes, scalar_widen_ms);
+  const double widen_ms = clipboard_test::BestMillis(iterations, [&] {
+    clipboard::Utf8ToUtf16(utf8.data(), utf8.size(), &utf16[0]);
+  });
+  clipboard_test::PrintResult("utf-8 -> utf-16", widen_ms, bytes,
+                              scalar_widen_ms);
+
+  const double scalar_narrow_ms = clipboard_test::BestMillis(iterations, [&] {
+    clipboard::Utf16ToUtf8Scalar(utf16.data(), utf16.size(), &back[0]);
+  });
+  clipboard_test::PrintResult("utf-16 -> utf-8 scalar", scalar_narrow_ms,
+                              bytes, scalar_narrow_ms);
+  const double narrow_ms = clipboard_test::BestMillis(iterations, [&] {
+    clipboard::Utf16ToUtf8(utf16.data(), utf16.size(), &back[0]);
+  });
+  clipboard_test::PrintResult("utf-16 -> utf-8", narrow_ms, bytes,
+                              scalar_narrow_ms);
+  if (back != utf8) {
+    std::printf("round trip mismatch\n");
+  }
+}
+
+}  // namespace
+
+int main() {
+  const size_t sizes[] = {1 << 10, 64 << 10, 1 << 20, 16 << 20, 100 << 20};
+  const std::string ascii =
+      "The quick brown fox jumps over the lazy dog, 0123456789.\r\n";
+  // U+00E9, U+00FC, U+65E5 U+672C, U+1F600 between ASCII words
+  const std::string mixed =
+      "caf\xC3\xA9 \xC3\xBC"
+      "ber \xE6\x97\xA5\xE6\x9C\xAC \xF0\x9F\x98\x80 ok ";
+  for (size_t size : sizes) {
+    Run("ascii", Repeat(ascii, size));
+  }
+  for (size_t size : sizes) {
+    Run("mixed 1-4 byte", Repeat(mixed, size));
+  }
+  return 0;
+}
@@ -0,0 +1,260 @@
+#include "utf_transcode.h"
+
+#include <string>
+#include <vector>
+
+#include "test_util.h"
+
+using clipboard::Utf16LengthOfUtf8;
+using clipboard::Utf16ToUtf8;
+using clipboard::Utf8LengthOfUtf16;
+using clipboard::Utf8ToUtf16;
+
+namespace {
+
+constexpr char16_t kReplacement = 0xFFFD;
+constexpr char kGuard = '\x5A';
+constexpr char16_t kGuard16 = 0x5A5A;
+
+// Converts through a buffer of exactly the reported length plus guard
+// units, and checks the write count matches the length and the guards
+// are untouched.
+std::u16string ToUtf16(const std::string& utf8) {
+  const size_t length = Utf16LengthOfUtf8(utf8.data(), utf8.size());
+  std::u16string buffer(length + 4, kGuard16);
+  const size_t written = Utf8ToUtf16(utf8.data(), utf8.size(), &buffer[0]);
+  EXPECT_EQ(written, length);
+  EXPECT_TRUE(buffer.substr(length) == std::u16string(4, kGuard16));
+  buffer.resize(written);
+  return buffer;
+}
+
+std::string ToUtf8(const std::u16string& utf16) {
+  const size_t length = Utf8LengthOfUtf16(utf16.data(), utf16.size());
+  std::string buffer(length + 4, kGuard);
+  const size_t written = Utf16ToUtf8(utf16.data(), utf16.size(), &buffer[0]);
+  EXPECT_EQ(written, length);
+  EXPECT_TRUE(buffer.substr(length) == std::string(4, kGuard));
+  buffer.resize(written);
+  return buffer;
+}
+
+std::u16string Replacements(size_t count) {
+  return std::u16string(count, kReplacement);
+}
+
+// Encodes |code_point| as UTF-8 and UTF-16 by the book.
+void Encode(char32_t code_point, std::string* utf8, std::u16string* utf16) {
+  if (code_point < 0x80) {
+    *utf8 += static_cast<char>(code_point);
+  } else if (code_point < 0x800) {
+    *utf8 += static_cast<char>(0xC0 | (code_point >> 6));
+    *utf8 += static_cast<char>(0x80 | (code_point & 0x3F));
+  } else if (code_point < 0x10000) {
+    *utf8 += static_cast<char>(0xE0 | (code_point >> 12));
+    *utf8 += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+    *utf8 += static_cast<char>(0x80 | (code_point & 0x3F));
+  } else {
+    *utf8 += static_cast<char>(0xF0 | (code_point >> 18));
+    *utf8 += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+    *utf8 += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+    *utf8 += static_cast<char>(0x80 | (code_point & 0x3F));
+  }
+  if (code_point < 0x10000) {
+    *utf16 += static_cast<char16_t>(code_point);
+  } else {
+    *utf16 += static_cast<char16_t>(0xD800 + ((code_point - 0x10000) >> 10));
+    *utf16 += static_cast<char16_t>(0xDC00 + ((code_point - 0x10000) & 0x3FF));
+  }
+}
+
+}  // namespace
+
+TEST(ConvertsEmptyInput) {
+  EXPECT_TRUE(ToUtf16("").empty());
+  EXPECT_TRUE(ToUtf8(u"").empty());
+}
+
+// Mixes every sequence length at every position relative to the 16-unit
+// ASCII blocks, so the SIMD loop hands over to the scalar code everywhere.
+TEST(RoundTripsValidTextAroundAsciiBlocks) {
+  const char32_t samples[] = {0xE9, 0x65E5, 0x1F600, 0x10FFFF, 0xFFFD};
+  for (char32_t sample : samples) {
+    for (size_t prefix = 0; prefix < 40; prefix++) {
+      std::string utf8(prefix, 'a');
+      std::u16string utf16(prefix, u'a');
+      Encode(sample, &utf8, &utf16);
+      utf8 += std::string(prefix % 19, 'z');
+      utf16 += std::u16string(prefix % 19, u'z');
+      EXPECT_TRUE(ToUtf16(utf8) == utf16);
+      EXPECT_TRUE(ToUtf8(utf16) == utf8);
+    }
+  }
+}
+
+TEST(RoundTripsRandomCodePoints) {
+  const std::vector<uint8_t> random = clipboard_test::RandomBytes(3 * 4000, 9);
+  std::string utf8;
+  std::u16string utf16;
+  for (size_t i = 0; i + 3 <= random.size(); i += 3) {
+    char32_t code_point = (static_cast<char32_t>(random[i]) << 16 |
+                           static_cast<char32_t>(random[i + 1]) << 8 |
+                           random[i + 2]) %
+                          0x110000;
+    if (code_point >= 0xD800 && code_point < 0xE000) {
+      code_point -= 0x800;
+    }
+    // Long ASCII stretches now and then
+    if (random[i] < 40) {
+      code_point = 0x20 + random[i];
+    }
+    Encode(code_point, &utf8, &utf16);
+  }
+  EXPECT_TRUE(ToUtf16(utf8) == utf16);
+  EXPECT_TRUE(ToUtf8(utf16) == utf8);
+}
+
+TEST(KeepsEmbeddedNuls) {
+  const std::string utf8("a\0b\0\0\xC3\xA9", 7);
+  const std::u16string utf16(u"a\0b\0\0\u00E9", 6);
+  EXPECT_TRUE(ToUtf16(utf8) == utf16);
+  EXPECT_TRUE(ToUtf8(utf16) == utf8);
+  // A NUL inside an ASCII block does not end the block early
+  std::string long_utf8(32, 'x');
+  long_utf8[7] = '\0';
+  EXPECT_EQ(ToUtf16(long_utf8).size(), 32u);
+  EXPECT_EQ(ToUtf16(long_utf8)[7], u'\0');
+}
+
+// Each maximal subpart of an ill-formed sequence becomes one U+FFFD, as
+// the Unicode standard recommends and MultiByteToWideChar does.
+TEST(ReplacesInvalidUtf8) {
+  struct Case {
+    std::string utf8;
+    std::u16string utf16;
+  };
+  const Case cases[] = {
+      // Lone continuation bytes
+      {"\x80", Replacements(1)},
+      {"a\x80\xBF" "b", u"a\uFFFD\uFFFDb"},
+      // Truncated sequences, at the end and before ASCII
+      {"\xC3", Replacements(1)},
+      {"\xE6\x97", Replacements(1)},
+      {"\xF0\x9F\x98", Replacements(1)},
+      {"\xF0\x9F\x98" "a", u"\uFFFDa"},
+      // Overlong encodings
+      {"\xC0\xAF", Replacements(2)},
+      {"\xE0\x80\xAF", Replacements(3)},
+      {"\xF0\x80\x80\xAF", Replacements(4)},
+      // UTF-16 surrogates encoded in UTF-8
+      {"\xED\xA0\x80", Replacements(3)},
+      {"\xED\xBF\xBF", Replacements(3)},
+      // Beyond U+10FFFF, and bytes that never occur
+      {"\xF4\x90\x80\x80", Replacements(4)},
+      {"\xF8\x88\x80\x80\x80", Replacements(5)},
+      {"\xFE\xFF", Replacements(2)},
+      // A valid sequence right after an invalid lead
+      {"\xC3\xC3\xA9", u"\uFFFD\u00E9"},
+  };
+  for (const auto& test_case : cases) {
+    if (!EXPECT_TRUE(ToUtf16(test_case.utf8) == test_case.utf16)) {
+      std::fprintf(stderr, "  input of %zu bytes starting 0x%02X\n",
+                   test_case.utf8.size(),
+                   static_cast<uint8_t>(test_case.utf8[0]));
+    }
+  }
+}
+
+TEST(ReplacesInvalidUtf8AfterAsciiBlock) {
+  std::string utf8(20, 'a');
+  utf8 += "\xE6\x97";
+  std::u16string expected(20, u'a');
+  expected += kReplacement;
+  EXPECT_TRUE(ToUtf16(utf8) == expected);
+}
+
+TEST(ReplacesUnpairedSurrogates) {
+  const std::string replacement = "\xEF\xBF\xBD";
+  struct Case {
+    std::u16string utf16;
+    std::string utf8;
+  };
+  const Case cases[] = {
+      // High surrogate at the end, before a non-surrogate, before another
+      // high surrogate
+      {u"a\xD83D", "a" + replacement},
+      {u"\xD83Dz", replacement + "z"},
+      {u"\xD83D\xD83D\xDE00", replacement + "\xF0\x9F\x98\x80"},
+      // Low surrogates on their own
+      {u"\xDE00", replacement},
+      {u"\xDE00\xD83D", replacement + replacement},
+      // Valid pair for comparison
+      {u"\xD83D\xDE00", "\xF0\x9F\x98\x80"},
+  };
+  for (const auto& test_case : cases) {
+    EXPECT_TRUE(ToUtf8(test_case.utf16) == test_case.utf8);
+  }
+}
+
+TEST(ReplacesUnpairedSurrogateAfterAsciiBlock) {
+  std::u16string utf16(33, u'a');
+  utf16 += u'\xDC00';
+  utf16 += std::u16string(17, u'b');
+  std::string expected(33, 'a');
+  expected += "\xEF\xBF\xBD";
+  expected += std::string(17, 'b');
+  EXPECT_TRUE(ToUtf8(utf16) == expected);
+}
+
+// Random bytes are mostly invalid UTF-8: the lengths must still match what
+// the converters write, byte for byte.
+TEST(LengthsMatchOutputForRandomInput) {
+  for (uint32_t seed = 1; seed <= 50; seed++) {
+    const std::vector<uint8_t> bytes =
+        clipboard_test::RandomBytes(seed * 37, seed);
+    const std::string utf8(bytes.begin(), bytes.end());
+    const std::u16string utf16 = ToUtf16(utf8);
+    ToUtf8(utf16);
+
+    std::u16string units;
+    for (size_t i = 0; i + 1 < bytes.size(); i += 2) {
+      units += static_cast<char16_t>(bytes[i] << 8 | bytes[i + 1]);
+    }
+    ToUtf16(ToUtf8(units));
+  }
+}
+
+// The SIMD ASCII runs are an optimization only: on valid and invalid input
+// alike the output matches the scalar converters unit for unit.
+TEST(MatchesScalarConverters) {
+  for (uint32_t seed = 1; seed <= 50; seed++) {
+    const std::vector<uint8_t> bytes =
+        clipboard_test::RandomBytes(seed * 53, seed);
+    // Long ASCII stretches so both paths are taken
+    std::string utf8(bytes.begin(), bytes.end());
+    for (size_t i = 0; i < utf8.size(); i++) {
+      if ((i / 24) % 2 == 0) {
+        utf8[i] = static_cast<char>(bytes[i] & 0x7F);
+      }
+    }
+    const std::u16string utf16 = ToUtf16(utf8);
+    std::u16string scalar16(utf16.size(), kGuard16);
+    EXPECT_EQ(clipboard::Utf8ToUtf16Scalar(utf8.data(), utf8.size(),
+                                           &scalar16[0]),
+              utf16.size());
+    EXPECT_TRUE(scalar16 == utf16);
+
+    std::u16string units(utf16);
+    for (size_t i = 0; i + 1 < bytes.size() && i / 2 < units.size(); i += 2) {
+      if ((i / 40) % 2 == 1) {
+        units[i / 2] = static_cast<char16_t>(bytes[i] << 8 | bytes[i + 1]);
+      }
+    }
+    const std::string back = ToUtf8(units);
+    std::string scalar8(back.size(), kGuard);
+    EXPECT_EQ(clipboard::Utf16ToUtf8Scalar(units.data(), units.size(),
+                                           &scalar8[0]),
+              back.size());
+    EXPECT_TRUE(scalar8 == back);
+  }
+}
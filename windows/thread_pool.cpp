@@ -0,0 +1,108 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace clipboard {
+
+struct ThreadPool::Job {
+  const std::function<void(size_t)>* fn = nullptr;
+  size_t count = 0;
+  std::atomic<size_t> next{0};
+  std::atomic<size_t> pending{0};
+  ThreadPool* pool = nullptr;
+};
+
+ThreadPool::ThreadPool(size_t worker_count) {
+  workers_.reserve(worker_count);
+  for (size_t i = 0; i < worker_count; i++) {
+    workers_.emplace_back([this] { WorkerLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+size_t ThreadPool::DefaultWorkerCount(size_t max_workers) {
+  size_t hardware = std::thread::hardware_concurrency();
+  if (hardware <= 1) {
+    return 0;
+  }
+  return std::min(hardware - 1, max_workers);
+}
+
+void ThreadPool::ParallelFor(size_t count,
+                             const std::function<void(size_t)>& fn) {
+  if (count == 0) {
+    return;
+  }
+  if (workers_.empty() || count == 1) {
+    for (size_t i = 0; i < count; i++) {
+      fn(i);
+    }
+    return;
+  }
+
+  std::lock_guard<std::mutex> job_lock(job_mutex_);
+  auto job = std::make_shared<Job>();
+  job->fn = &fn;
+  job->count = count;
+  job->pending = count;
+  job->pool = this;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = job;
+    generation_++;
+  }
+  work_cv_.notify_all();
+
+  // The caller works too instead of idling until the workers finish.
+  RunItems(*job);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [&job] { return job->pending.load() == 0; });
+  job_.reset();
+}
+
+void ThreadPool::WorkerLoop() {
+  uint64_t seen_generation = 0;
+  for (;;) {
+    std::shared_ptr<Job> job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_cv_.wait(lock, [&] {
+        return stop_ || (job_ && generation_ != seen_generation);
+      });
+      if (stop_) {
+        return;
+      }
+      seen_generation = generation_;
+      job = job_;
+    }
+    RunItems(*job);
+  }
+}
+
+void ThreadPool::RunItems(Job& job) {
+  for (;;) {
+    size_t index = job.next.fetch_add(1);
+    if (index >= job.count) {
+      return;
+    }
+    (*job.fn)(index);
+    if (job.pending.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> lock(job.pool->mutex_);
+      job.pool->done_cv_.notify_all();
+    }
+  }
+}
+
+}  // namespace clipboard
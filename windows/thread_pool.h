@@ -0,0 +1,56 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace clipboard {
+
+// Fixed-size pool of worker threads for data-parallel image work (row bands,
+// compression blocks). Work items run on any thread, the caller's
+// included, and must not call back into the same pool.
+class ThreadPool {
+ public:
+  // Creates a pool with |worker_count| background threads. The thread calling
+  // ParallelFor also runs work items, so a pool of N workers uses N + 1 cores.
+  explicit ThreadPool(size_t worker_count);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  size_t worker_count() const { return workers_.size(); }
+
+  // Runs fn(i) for every i in [0, count) and returns once all calls have
+  // finished. Jobs from different callers are serialized.
+  void ParallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+  // One worker per hardware thread besides the caller, capped at
+  // |max_workers|.
+  static size_t DefaultWorkerCount(size_t max_workers = 15);
+
+ private:
+  struct Job;
+
+  void WorkerLoop();
+  static void RunItems(Job& job);
+
+  std::vector<std::thread> workers_;
+  std::mutex job_mutex_;  // Serializes ParallelFor callers.
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  std::shared_ptr<Job> job_;
+  uint64_t generation_ = 0;
+  bool stop_ = false;
+};
+
+}  // namespace clipboard
+
+#endif  // THREAD_POOL_H_
@@ -0,0 +1,310 @@
+#include "utf_transcode.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__x86_64__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define CLIPBOARD_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace clipboard {
+
+namespace {
+
+constexpr char32_t kReplacementCharacter = 0xFFFD;
+
+// Code units handled by the scalar path before the SIMD ASCII path is tried
+// again, so mostly non-ASCII text does not pay for a failed probe per
+// character.
+constexpr size_t kScalarRun = 16;
+
+// Decodes the (non-ASCII) sequence at |src|. On malformed input returns
+// U+FFFD and consumes the maximal invalid subpart, as recommended by the
+// Unicode standard.
+char32_t DecodeUtf8(const uint8_t* src, size_t size, size_t* length) {
+  const uint8_t lead = src[0];
+  *length = 1;
+  size_t trail_count;
+  char32_t code_point;
+  uint8_t lower = 0x80;
+  uint8_t upper = 0xBF;
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    trail_count = 1;
+    code_point = lead & 0x1Fu;
+  } else if (lead >= 0xE0 && lead <= 0xEF) {
+    trail_count = 2;
+    code_point = lead & 0x0Fu;
+    if (lead == 0xE0) {
+      lower = 0xA0;  // Overlong
+    } else if (lead == 0xED) {
+      upper = 0x9F;  // Surrogates
+    }
+  } else if (lead >= 0xF0 && lead <= 0xF4) {
+    trail_count = 3;
+    code_point = lead & 0x07u;
+    if (lead == 0xF0) {
+      lower = 0x90;  // Overlong
+    } else if (lead == 0xF4) {
+      upper = 0x8F;  // Beyond U+10FFFF
+    }
+  } else {
+    return kReplacementCharacter;
+  }
+  for (size_t i = 1; i <= trail_count; i++) {
+    if (i >= size || src[i] < lower || src[i] > upper) {
+      *length = i;
+      return kReplacementCharacter;
+    }
+    code_point = (code_point << 6) | (src[i] & 0x3Fu);
+    lower = 0x80;
+    upper = 0xBF;
+  }
+  *length = trail_count + 1;
+  return code_point;
+}
+
+// Decodes the code point at |src|; unpaired surrogates yield U+FFFD.
+char32_t DecodeUtf16(const char16_t* src, size_t size, size_t* length) {
+  const char16_t unit = src[0];
+  *length = 1;
+  if (unit < 0xD800 || unit > 0xDFFF) {
+    return unit;
+  }
+  if (unit <= 0xDBFF && size > 1 && src[1] >= 0xDC00 && src[1] <= 0xDFFF) {
+    *length = 2;
+    return 0x10000 + ((static_cast<char32_t>(unit) - 0xD800) << 10) +
+           (static_cast<char32_t>(src[1]) - 0xDC00);
+  }
+  return kReplacementCharacter;
+}
+
+size_t Utf8SizeOf(char32_t code_point) {
+  if (code_point < 0x80) {
+    return 1;
+  }
+  if (code_point < 0x800) {
+    return 2;
+  }
+  return code_point < 0x10000 ? 3 : 4;
+}
+
+char* EncodeUtf8(char32_t code_point, char* dst) {
+  if (code_point < 0x80) {
+    *dst++ = static_cast<char>(code_point);
+  } else if (code_point < 0x800) {
+    *dst++ = static_cast<char>(0xC0 | (code_point >> 6));
+    *dst++ = static_cast<char>(0x80 | (code_point & 0x3F));
+  } else if (code_point < 0x10000) {
+    *dst++ = static_cast<char>(0xE0 | (code_point >> 12));
+    *dst++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+    *dst++ = static_cast<char>(0x80 | (code_point & 0x3F));
+  } else {
+    *dst++ = static_cast<char>(0xF0 | (code_point >> 18));
+    *dst++ = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+    *dst++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+    *dst++ = static_cast<char>(0x80 | (code_point & 0x3F));
+  }
+  return dst;
+}
+
+char16_t* EncodeUtf16(char32_t code_point, char16_t* dst) {
+  if (code_point < 0x10000) {
+    *dst++ = static_cast<char16_t>(code_point);
+  } else {
+    code_point -= 0x10000;
+    *dst++ = static_cast<char16_t>(0xD800 + (code_point >> 10));
+    *dst++ = static_cast<char16_t>(0xDC00 + (code_point & 0x3FF));
+  }
+  return dst;
+}
+
+#if defined(CLIPBOARD_HAS_SSE2)
+
+// Each helper handles whole 16-unit blocks of ASCII from the start of its
+// input and returns how many units it consumed; 0 if the first block is not
+// pure ASCII.
+
+size_t CountAsciiUtf8(const uint8_t* src, size_t size) {
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    if (_mm_movemask_epi8(bytes) != 0) {
+      break;
+    }
+  }
+  return i;
+}
+
+size_t WidenAscii(const uint8_t* src, size_t size, char16_t* dst) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    if (_mm_movemask_epi8(bytes) != 0) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_unpacklo_epi8(bytes, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8),
+                     _mm_unpackhi_epi8(bytes, zero));
+  }
+  return i;
+}
+
+inline bool IsAsciiUtf16(__m128i low, __m128i high) {
+  const __m128i non_ascii_bits = _mm_set1_epi16(static_cast<short>(0xFF80));
+  __m128i bits = _mm_and_si128(_mm_or_si128(low, high), non_ascii_bits);
+  return _mm_movemask_epi8(_mm_cmpeq_epi16(bits, _mm_setzero_si128())) ==
+         0xFFFF;
+}
+
+size_t CountAsciiUtf16(const char16_t* src, size_t size) {
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m128i high =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+    if (!IsAsciiUtf16(low, high)) {
+      break;
+    }
+  }
+  return i;
+}
+
+size_t NarrowAscii(const char16_t* src, size_t size, char* dst) {
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m128i high =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+    if (!IsAsciiUtf16(low, high)) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packus_epi16(low, high));
+  }
+  return i;
+}
+
+#else
+
+size_t CountAsciiUtf8(const uint8_t*, size_t) { return 0; }
+size_t WidenAscii(const uint8_t*, size_t, char16_t*) { return 0; }
+size_t CountAsciiUtf16(const char16_t*, size_t) { return 0; }
+size_t NarrowAscii(const char16_t*, size_t, char*) { return 0; }
+
+#endif  // CLIPBOARD_HAS_SSE2
+
+// The converters, with the SIMD ASCII path compiled out when |kAsciiRuns|
+// is false.
+
+template <bool kAsciiRuns>
+size_t Utf8ToUtf16Impl(const char* src_chars, size_t size, char16_t* dst) {
+  const uint8_t* src = reinterpret_cast<const uint8_t*>(src_chars);
+  char16_t* out = dst;
+  size_t i = 0;
+  while (i < size) {
+    if (kAsciiRuns) {
+      size_t ascii = WidenAscii(src + i, size - i, out);
+      i += ascii;
+      out += ascii;
+    }
+    const size_t run_end = std::min(size, i + kScalarRun);
+    while (i < run_end) {
+      if (src[i] < 0x80) {
+        *out++ = src[i++];
+        continue;
+      }
+      size_t consumed;
+      char32_t code_point = DecodeUtf8(src + i, size - i, &consumed);
+      i += consumed;
+      out = EncodeUtf16(code_point, out);
+    }
+  }
+  return static_cast<size_t>(out - dst);
+}
+
+template <bool kAsciiRuns>
+size_t Utf16ToUtf8Impl(const char16_t* src, size_t size, char* dst) {
+  char* out = dst;
+  size_t i = 0;
+  while (i < size) {
+    if (kAsciiRuns) {
+      size_t ascii = NarrowAscii(src + i, size - i, out);
+      i += ascii;
+      out += ascii;
+    }
+    const size_t run_end = std::min(size, i + kScalarRun);
+    while (i < run_end) {
+      size_t consumed;
+      char32_t code_point = DecodeUtf16(src + i, size - i, &consumed);
+      i += consumed;
+      out = EncodeUtf8(code_point, out);
+    }
+  }
+  return static_cast<size_t>(out - dst);
+}
+
+}  // namespace
+
+size_t Utf16LengthOfUtf8(const char* src_chars, size_t size) {
+  const uint8_t* src = reinterpret_cast<const uint8_t*>(src_chars);
+  size_t length = 0;
+  size_t i = 0;
+  while (i < size) {
+    size_t ascii = CountAsciiUtf8(src + i, size - i);
+    i += ascii;
+    length += ascii;
+    const size_t run_end = std::min(size, i + kScalarRun);
+    while (i < run_end) {
+      if (src[i] < 0x80) {
+        i++;
+        length++;
+        continue;
+      }
+      size_t consumed;
+      char32_t code_point = DecodeUtf8(src + i, size - i, &consumed);
+      i += consumed;
+      length += code_point < 0x10000 ? 1 : 2;
+    }
+  }
+  return length;
+}
+
+size_t Utf8ToUtf16(const char* src, size_t size, char16_t* dst) {
+  return Utf8ToUtf16Impl<true>(src, size, dst);
+}
+
+size_t Utf8ToUtf16Scalar(const char* src, size_t size, char16_t* dst) {
+  return Utf8ToUtf16Impl<false>(src, size, dst);
+}
+
+size_t Utf8LengthOfUtf16(const char16_t* src, size_t size) {
+  size_t length = 0;
+  size_t i = 0;
+  while (i < size) {
+    size_t ascii = CountAsciiUtf16(src + i, size - i);
+    i += ascii;
+    length += ascii;
+    const size_t run_end = std::min(size, i + kScalarRun);
+    while (i < run_end) {
+      size_t consumed;
+      char32_t code_point = DecodeUtf16(src + i, size - i, &consumed);
+      i += consumed;
+      length += Utf8SizeOf(code_point);
+    }
+  }
+  return length;
+}
+
+size_t Utf16ToUtf8(const char16_t* src, size_t size, char* dst) {
+  return Utf16ToUtf8Impl<true>(src, size, dst);
+}
+
+size_t Utf16ToUtf8Scalar(const char16_t* src, size_t size, char* dst) {
+  return Utf16ToUtf8Impl<false>(src, size, dst);
+}
+
+}  // namespace clipboard
@@ -0,0 +1,38 @@
+#ifndef UTF_TRANSCODE_H_
+#define UTF_TRANSCODE_H_
+
+#include <cstddef>
+
+namespace clipboard {
+
+// UTF-8 <-> UTF-16 conversion for clipboard text. Inputs are explicit-length
+// buffers (no NUL scanning) and outputs are written straight into memory the
+// caller sized with the matching *Length function, so no intermediate buffer
+// is needed. Runs of ASCII are converted 16 code units at a time with SSE2
+// where available. Malformed input never fails: each maximal invalid UTF-8
+// subsequence and each unpaired surrogate becomes U+FFFD, as
+// MultiByteToWideChar and WideCharToMultiByte do without strict flags.
+
+// Number of UTF-16 code units Utf8ToUtf16 produces for |src|.
+size_t Utf16LengthOfUtf8(const char* src, size_t size);
+
+// Converts |size| bytes of UTF-8 to UTF-16. |dst| must hold
+// Utf16LengthOfUtf8(src, size) units. Returns the number of units written.
+size_t Utf8ToUtf16(const char* src, size_t size, char16_t* dst);
+
+// Number of UTF-8 bytes Utf16ToUtf8 produces for |src|.
+size_t Utf8LengthOfUtf16(const char16_t* src, size_t size);
+
+// Converts |size| UTF-16 code units to UTF-8. |dst| must hold
+// Utf8LengthOfUtf16(src, size) bytes. Returns the number of bytes written.
+size_t Utf16ToUtf8(const char16_t* src, size_t size, char* dst);
+
+// Scalar reference implementations of Utf8ToUtf16 and Utf16ToUtf8, one code
+// point at a time with no SIMD ASCII runs, so tests and benchmarks can
+// compare against them.
+size_t Utf8ToUtf16Scalar(const char* src, size_t size, char16_t* dst);
+size_t Utf16ToUtf8Scalar(const char16_t* src, size_t size, char* dst);
+
+}  // namespace clipboard
+
+#endif  // UTF_TRANSCODE_H_